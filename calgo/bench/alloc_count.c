@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+/* Compte les allocations de toto, pour les scénarios de bench/run.sh.
+ * Lié au programme avec -Wl,--wrap=malloc,... : les appels du programme
+ * (pas ceux de la libc elle-même) passent par les __wrap_. À la sortie,
+ * écrit une ligne "pic_rss_ko allocations" dans le fichier nommé par
+ * $BENCH_PROCESS_OUT, ou sur stderr. */
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+int __real_posix_memalign(void **p, size_t alignment, size_t size);
+
+static long long allocations = 0;
+
+void *__wrap_malloc(size_t size)
+{
+  __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+  __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size)
+{
+  __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  return __real_realloc(p, size);
+}
+
+int __wrap_posix_memalign(void **p, size_t alignment, size_t size)
+{
+  __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  return __real_posix_memalign(p, alignment, size);
+}
+
+__attribute__((destructor)) static void report(void)
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  const char *path = getenv("BENCH_PROCESS_OUT");
+  FILE *f = (path != NULL) ? fopen(path, "w") : NULL;
+  fprintf((f != NULL) ? f : stderr, "%ld %lld\n", usage.ru_maxrss,
+          __atomic_load_n(&allocations, __ATOMIC_RELAXED));
+  if (f != NULL) fclose(f);
+  return ;
+}
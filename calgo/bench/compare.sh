@@ -0,0 +1,36 @@
+#!/bin/bash
+# Compare deux sorties de bench/run.sh, scénario par scénario : rapport
+# actuel / référence du débit, du temps jusqu'au seuil, du pic de mémoire et
+# du nombre d'allocations. Un écart défavorable de plus de TOLERANCE (5 %
+# par défaut) est marqué d'un « ! » et le script sort avec le code 1.
+#
+# Usage : bench/compare.sh référence.csv actuel.csv
+
+if [ $# -ne 2 ]
+then
+  echo "Usage: $0 baseline.csv current.csv" >&2
+  exit 2
+fi
+
+awk -F, -v tol="${TOLERANCE:-0.05}" '
+  function ratio(cur, base) { return (base > 0 && cur != "") ? cur / base : "" }
+  function show(r, worse,    s) {
+    if (r == "") return sprintf("%10s", "-")
+    s = sprintf("%9.3f", r)
+    if ((worse > 0 && r > 1 + tol) || (worse < 0 && r < 1 - tol))
+    { bad++; return s "!" }
+    return s " "
+  }
+  FNR == 1 { next }
+  NR == FNR { rate[$1] = $6; eps[$1] = $8; rss[$1] = $10; allocs[$1] = $11;
+              next }
+  !($1 in rate) { printf "%-20s (not in baseline)\n", $1; next }
+  {
+    if (!header++)
+      printf "%-20s %10s %10s %10s %10s\n", "scenario", "rate", "to_eps",
+             "peak_rss", "allocs"
+    printf "%-20s %s %s %s %s\n", $1, show(ratio($6, rate[$1]), -1),
+           show(ratio($8, eps[$1]), 1), show(ratio($10, rss[$1]), 1),
+           show(ratio($11, allocs[$1]), 1)
+  }
+  END { exit (bad > 0) }' "$1" "$2"
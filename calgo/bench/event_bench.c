@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "../src/event.h"
+
+/* Débit push/pop des files d'événements, selon le modèle "hold" :
+ * on remplit la file de N événements, puis chaque opération extrait le
+ * prochain événement et en replanifie un, comme le fait la simulation.
+ *
+ * Usage : event_bench [N_max] [opérations par taille]
+ * Sortie : kind N ns/push(remplissage) ns/hold */
+
+#define DEFAULT_NMAX 10000000
+#define DEFAULT_OPS  4000000
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static double rand_exp(void)
+{
+  return -log(1 - drand48());
+}
+
+static int bench(int kind, int N, int ops, double *push_ns, double *hold_ns)
+/* Renvoie 0 si l'ordre des extractions n'est pas respecté */
+{
+  srand48(42);
+  struct EventQueue *q = new_EventQueue_kind(kind, EVENT_QUEUE_SIZE);
+
+  double t0 = now();
+  for (int i=0; i<N; i++)
+    add_Event(new_Event(rand_exp() * N, i & 0xff, NEW_PAQUET, 0), &q);
+  double t1 = now();
+
+  struct Event event;
+  double last = 0;
+  int ordered = 1;
+  for (int i=0; i<ops; i++)
+  {
+    next_event(&event, q);
+    if (event.T < last) ordered = 0;
+    last = event.T;
+    event.T += rand_exp() * N;
+    add_Event(event, &q);
+  }
+  double t2 = now();
+
+  *push_ns = 1e9 * (t1 - t0) / N;
+  *hold_ns = 1e9 * (t2 - t1) / ops;
+  free_EventQueue(q);
+  return ordered;
+}
+
+int main(int argc, char **argv)
+{
+  int nmax = (argc > 1) ? atoi(argv[1]) : DEFAULT_NMAX;
+  int ops  = (argc > 2) ? atoi(argv[2]) : DEFAULT_OPS;
+
+  printf("kind N push_ns hold_ns\n");
+  for (int N=10000; N<=nmax; N*=10)
+  for (int kind=QUEUE_BINARY; kind<=QUEUE_LADDER; kind++)
+  {
+    double push_ns, hold_ns;
+    if (!bench(kind, N, ops, &push_ns, &hold_ns))
+    {
+      fprintf(stderr, "%s : events out of order\n", queue_kind_name(kind));
+      return EXIT_FAILURE;
+    }
+    printf("%s %d %.1f %.1f\n", queue_kind_name(kind), N, push_ns, hold_ns);
+    fflush(stdout);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../src/distrib.h"
+#include "../src/event.h"
+#include "../src/graph.h"
+#include "../src/network_th.h"
+#include "../src/fun.h"
+
+/* Temps des noyaux de calcul, sur une gamme de tailles :
+ *  - distrib.c : logit, pos_balanced_logit, select_on_distrib,
+ *    spherical_noise (n : taille de la distribution), rand_exponential ;
+ *  - event.c : add_Event + next_event sur la file par défaut, en modèle
+ *    "hold" (n : événements en attente ; event_bench compare les files) ;
+ *  - graph.c : path_from_to sur un DAG aléatoire (n : nombre de sommets) ;
+ *  - network_th.c : fast_path_cost et add_mass_over (n : longueur du
+ *    chemin).
+ * Chaque mesure répète le noyau jusqu'à traiter environ BUDGET éléments.
+ *
+ * Usage : kernel_bench [budget] [noyau]
+ * Sortie : kernel n ns/op éléments/op éléments/s */
+
+#define DEFAULT_BUDGET 20000000
+
+static long long budget = DEFAULT_BUDGET;
+static volatile double sink; /* Empêche d'optimiser les appels */
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+static long long reps_for(long long items)
+/* Nombre de répétitions d'une opération traitant items éléments */
+{
+  long long reps = budget / ((items > 0) ? items : 1);
+  return (reps > 0) ? reps : 1;
+}
+
+static void report(const char *kernel, int n, long long reps, double items,
+                   double t)
+{
+  double ns = 1e9 * t / reps;
+  printf("%s %d %.1f %.0f %.4g\n", kernel, n, ns, items, items * 1e9 / ns);
+  fflush(stdout);
+  return ;
+}
+
+static double *random_vector(int n)
+{
+  double *y = malloc(n * sizeof(double));
+  if (y == NULL) { fprintf(stderr, "(malloc) random_vector\n"); exit(EXIT_FAILURE); }
+  for (int i=0; i<n; i++) y[i] = 10 * drand48() - 5;
+  return y;
+}
+
+/* *********************** DISTRIB *********************** */
+
+static void bench_distrib(int n)
+{
+  double *y = random_vector(n), *x = random_vector(n);
+  long long reps = reps_for(n);
+  double t0;
+
+  t0 = now();
+  for (long long r=0; r<reps; r++) { y[r % n] += 1e-9; logit(x, y, n); }
+  report("logit", n, reps, n, now() - t0);
+
+  t0 = now();
+  for (long long r=0; r<reps; r++)
+  { y[r % n] += 1e-9; pos_balanced_logit(x, y, 0.1, n); }
+  report("pos_balanced_logit", n, reps, n, now() - t0);
+
+  /* x est une distribution */
+  logit(x, y, n);
+  long long sum = 0;
+  t0 = now();
+  for (long long r=0; r<reps; r++) sum += select_on_distrib(x, n);
+  report("select_on_distrib", n, reps, n, now() - t0);
+  sink = sum;
+
+  t0 = now();
+  for (long long r=0; r<reps; r++)
+  { double *noise = spherical_noise(n); sink = noise[0]; free(noise); }
+  report("spherical_noise", n, reps, n, now() - t0);
+
+  free(x); free(y);
+  return ;
+}
+
+static void bench_exponential(void)
+{
+  long long reps = reps_for(1);
+  double sum = 0;
+  double t0 = now();
+  for (long long r=0; r<reps; r++) sum += rand_exponential(1.5);
+  report("rand_exponential", 1, reps, 1, now() - t0);
+  sink = sum;
+  return ;
+}
+
+/* *********************** ÉVÉNEMENTS *********************** */
+
+static void bench_events(int n)
+/* n événements en attente ; une opération : extraire le prochain et le
+ * replanifier */
+{
+  struct EventQueue *q = new_EventQueue(EVENT_QUEUE_SIZE);
+  for (int i=0; i<n; i++)
+    add_Event(new_Event(rand_exponential(1) * n, i & 0xff, NEW_PAQUET, 0), &q);
+
+  long long reps = reps_for(64); /* Une opération coûte à peu près 64 éléments */
+  struct Event event;
+  double t0 = now();
+  for (long long r=0; r<reps; r++)
+  {
+    next_event(&event, q);
+    event.T += rand_exponential(1) * n;
+    add_Event(event, &q);
+  }
+  report("add_Event+next_event", n, reps, 1, now() - t0);
+
+  free_EventQueue(q);
+  return ;
+}
+
+/* *********************** CHEMINS *********************** */
+
+static void bench_paths(int n)
+/* Tous les chemins 0 --> n-1 d'un DAG aléatoire de densité 1/2 */
+{
+  struct graph *g = new_graph(n);
+  set_randDAG(g, 0.5);
+  g->network[0][n-1] = 1; /* Au moins un chemin */
+  int **vertices = vertices_array(n);
+
+  struct List *paths = path_from_to(0, n-1, g, vertices);
+  int n_paths = len(paths);
+  free_paths(paths);
+
+  long long reps = reps_for((long long) n_paths * n);
+  double t0 = now();
+  for (long long r=0; r<reps; r++)
+  {
+    paths = path_from_to(0, n-1, g, vertices);
+    sink = (paths != NULL);
+    free_paths(paths);
+  }
+  report("path_from_to", n, reps, n_paths, now() - t0);
+
+  free_vertices(vertices, n);
+  free_graph(g);
+  return ;
+}
+
+static void bench_path_cost(int n)
+/* Le chemin 0 --> 1 --> ... --> n-1 du DAG complet à n sommets */
+{
+  struct graph *g = new_graph(n);
+  for (int i=0; i<n; i++) for (int j=0; j<n; j++) g->network[i][j] = (i < j);
+  struct Network *net = new_Network(n);
+  network_get_graph(net, g);
+  set_allfun(net, fun_lin);
+  reset_masses(net);
+
+  int **vertices = vertices_array(n);
+  struct List *path = new_empty();
+  for (int i=n-1; i>=0; i--) path = push(vertices[i], path);
+
+  double **cost_mat = cost_matrix(net);
+  for (int i=0; i<n; i++) for (int j=0; j<n; j++) cost_mat[i][j] = drand48();
+
+  long long reps = reps_for(n);
+  double sum = 0;
+  double t0 = now();
+  for (long long r=0; r<reps; r++) sum += fast_path_cost(path, cost_mat);
+  report("fast_path_cost", n, reps, n - 1, now() - t0);
+
+  t0 = now();
+  for (long long r=0; r<reps; r++) add_mass_over(net, 1e-6, path);
+  report("add_mass_over", n, reps, n - 1, now() - t0);
+  sink = sum + net->masses[0][1];
+
+  free_cost_matrix(cost_mat, n);
+  free_paths(push(path, new_empty())); /* Libère le chemin, pas les sommets */
+  free_vertices(vertices, n);
+  free_Network(net);
+  free_graph(g);
+  return ;
+}
+
+/* *********************** PROGRAMME *********************** */
+
+int main(int argc, char **argv)
+{
+  if (argc > 1) budget = atoll(argv[1]);
+  const char *only = (argc > 2) ? argv[2] : NULL;
+  srand48(42); srand(42);
+
+  printf("kernel n ns_op items_op items_s\n");
+  if (only == NULL || !strcmp(only, "distrib"))
+  {
+    for (int n=4; n<=4096; n*=4) bench_distrib(n);
+    bench_exponential();
+  }
+  if (only == NULL || !strcmp(only, "event"))
+    for (int n=1000; n<=1000000; n*=10) bench_events(n);
+  if (only == NULL || !strcmp(only, "paths"))
+    for (int n=8; n<=20; n+=4) bench_paths(n);
+  if (only == NULL || !strcmp(only, "network"))
+    for (int n=4; n<=1024; n*=4) bench_path_cost(n);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+#!/bin/bash
+# Lance les scénarios de bench/scenarios et écrit sur stdout une ligne CSV
+# par scénario :
+#   scenario,mode,runs,steps,time_s,rate,unit,time_to_eps_s,potential,
+#   peak_rss_kb,allocations
+# steps : itérations (événements en simulation) de tous les runs du
+# scénario ; time_s : leur temps CPU ; rate : steps / time_s. time_to_eps_s
+# n'est rempli que pour les scénarios *-eps, qui s'arrêtent sur un seuil.
+# Pic de mémoire et allocations sont ceux de tout le processus (programme
+# lié à bench/alloc_count.c).
+#
+# Usage : bench/run.sh [toto_bench [scénario.cmd ...]]
+
+TOTO=${1:-bin/toto_bench}
+shift
+SCENARIOS=${@:-bench/scenarios/*.cmd}
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+echo "scenario,mode,runs,steps,time_s,rate,unit,time_to_eps_s,potential,peak_rss_kb,allocations"
+for f in $SCENARIOS
+do
+  name=$(basename "$f" .cmd)
+  if ! BENCH_PROCESS_OUT="$TMP/process" "$TOTO" --script "$f" \
+       --out "$TMP/runs.csv" > /dev/null 2> "$TMP/log"
+  then
+    echo "$name: failed, see below" >&2
+    cat "$TMP/log" >&2
+    continue
+  fi
+  read rss allocations < "$TMP/process"
+
+  awk -F, -v name="$name" -v rss="$rss" -v allocs="$allocations" '
+    $1 == "run" { mode = $3; runs++; steps += $5; time += $6; potential = $7;
+                  converged = ($8 != "") }
+    END {
+      unit = (mode == "simulation") ? "events/s" : "iterations/s"
+      rate = (time > 0) ? sprintf("%.6g", steps / time) : ""
+      eps  = (name ~ /-eps$/ && converged) ? sprintf("%.6g", time) : ""
+      printf "%s,%s,%d,%d,%.6g,%s,%s,%s,%.10g,%s,%s\n", name, mode, runs,
+             steps, time, rate, unit, eps, potential, rss, allocs
+    }' "$TMP/runs.csv"
+done
@@ -0,0 +1,9 @@
+set seed 1
+mode vertex
+new graph 15
+new players 15
+set mass 3
+new network
+set network poly3
+run bandit for 2000
+quit
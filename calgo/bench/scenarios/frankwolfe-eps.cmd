@@ -0,0 +1,8 @@
+set seed 1
+new graph 30 0.3
+new players 20
+set mass 3
+new network
+set network poly3
+run frankwolfe for 100000 gap 1e-4
+quit
@@ -0,0 +1,9 @@
+set seed 1
+mode paths
+new graph 20 0.3
+new players 30
+set mass 3
+new network
+set network poly3
+run for 10000
+quit
@@ -0,0 +1,9 @@
+set seed 1
+mode paths
+new graph 10 0.5
+new players 10
+set mass 3
+new network
+set network poly3
+run for 20000
+quit
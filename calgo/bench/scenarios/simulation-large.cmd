@@ -0,0 +1,10 @@
+set seed 1
+new graph 3000 0.003
+new players 20
+set mass 0.05
+new network
+set network linear
+set trace off
+set arrivals merged
+run simulation time for 10000000 with 1000000
+quit
@@ -0,0 +1,10 @@
+set seed 1
+new graph 1000 0.005
+new players 20
+set mass 0.05
+new network
+set network linear
+set trace off
+set arrivals merged
+run simulation time for 1000000 with 100000
+quit
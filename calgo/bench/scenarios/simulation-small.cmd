@@ -0,0 +1,9 @@
+set seed 1
+new graph 100 0.05
+new players 10
+set mass 0.05
+new network
+set network linear
+set trace off
+run simulation time for 200000
+quit
@@ -0,0 +1,9 @@
+set seed 1
+mode vertex
+new graph 15
+new players 15
+set mass 3
+new network
+set network poly3
+run for 20000 gap 2e-2 every 10
+quit
@@ -0,0 +1,9 @@
+set seed 1
+mode vertex
+new graph 200 0.05
+new players 50
+set mass 3
+new network
+set network poly3
+run for 100
+quit
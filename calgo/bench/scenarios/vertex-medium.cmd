@@ -0,0 +1,9 @@
+set seed 1
+mode vertex
+new graph 60 0.2
+new players 30
+set mass 3
+new network
+set network poly3
+run for 500
+quit
@@ -0,0 +1,11 @@
+set seed 1
+mode vertex
+new graph 15
+new players 15
+set mass 3
+new network
+set network poly3
+set cst_gamma 0.01
+set beta 0.5
+run for 2000
+quit
@@ -65,12 +65,51 @@ double max(double *x, int n)
   return m;
 }
 
+/* Flux du thread courant (NULL : celui de drand48) */
+static __thread unsigned short *thread_stream = NULL;
+
+void set_thread_stream(unsigned short *xsubi)
+{
+  thread_stream = xsubi;
+  return ;
+}
+
+static double uniform(unsigned short *xsubi)
+/* Nombre aléatoire uniforme sur [0, 1[, tiré sur le flux xsubi, ou sur
+ * celui du thread si xsubi vaut NULL */
+{
+  if (xsubi == NULL) xsubi = thread_stream;
+  return (xsubi == NULL) ? drand48() : erand48(xsubi);
+}
+
+double rand_uniform(void)
+{
+  return uniform(NULL);
+}
+
+long rand_long(void)
+{
+  return (thread_stream == NULL) ? lrand48() : nrand48(thread_stream);
+}
+
+int rand_int(int n)
+{
+  if (thread_stream == NULL) return rand() % n;
+  int i = (int) (erand48(thread_stream) * n);
+  return (i < n) ? i : n - 1;
+}
+
 int select_on_distrib(double *x, int n)
 /* La distribution x se doit d'être initialisée.
  * Sélectionne un nombre aléatoire sur {0 ... n-1} selon la distribution x
  * i.e P(i) = x[i]. */
 {
-  double lambda = drand48();
+  return select_on_distrib_r(x, n, NULL);
+}
+
+int select_on_distrib_r(double *x, int n, unsigned short *xsubi)
+{
+  double lambda = uniform(xsubi);
   double sum = 0;
 
   for (int i=0; i<n-1; i++)
@@ -155,8 +194,8 @@ double Gaussian_rand(void)
 {
   double u1, u2;
   do {
-    u1 = drand48();
-    u2 = drand48();
+    u1 = uniform(NULL);
+    u2 = uniform(NULL);
   } while(u1 == 0.);
 
   return sqrt(-2 * log(u1)) * cos(2 * PI * u2);
@@ -183,6 +222,76 @@ double *spherical_noise(int n)
 double rand_exponential(double lambda)
 /* Renvoie un nombre aléatoire de loi E(lambda) */
 {
-  double u = drand48();
+  return rand_exponential_r(lambda, NULL);
+}
+
+double rand_exponential_r(double lambda, unsigned short *xsubi)
+{
+  double u = uniform(xsubi);
   return - log(1-u) / lambda;
 }
+
+/* ************************* TABLE D'ALIAS ************************* */
+
+struct AliasTable *new_AliasTable(double *x, int n)
+/* Table d'alias de la distribution x (pas nécessairement normalisée) */
+{
+  struct AliasTable *table = malloc(sizeof(struct AliasTable));
+  if (table == NULL) handle_error("(malloc) new_AliasTable");
+  table->n = n;
+  table->prob  = malloc(n * sizeof(double));
+  table->alias = malloc(n * sizeof(int));
+  int *small = malloc(n * sizeof(int)), *large = malloc(n * sizeof(int));
+  if (table->prob == NULL || table->alias == NULL || small == NULL
+      || large == NULL)
+    handle_error("(malloc) new_AliasTable");
+
+  double sum = 0;
+  for (int i=0; i<n; i++) sum += x[i];
+
+  /* prob[i] = n.P(i) ; les cases sous 1 sont complétées par une case
+   * au-dessus de 1 */
+  int n_small = 0, n_large = 0;
+  for (int i=0; i<n; i++)
+  {
+    table->prob[i]  = n * x[i] / sum;
+    table->alias[i] = i;
+    if (table->prob[i] < 1) small[n_small++] = i;
+    else large[n_large++] = i;
+  }
+  while (n_small && n_large)
+  {
+    int s = small[--n_small], l = large[n_large-1];
+    table->alias[s] = l;
+    table->prob[l] -= 1 - table->prob[s];
+    if (table->prob[l] < 1) { n_large--; small[n_small++] = l; }
+  }
+  /* Restes (arrondis flottants) : probabilité 1 */
+  while (n_small) table->prob[small[--n_small]] = 1;
+  while (n_large) table->prob[large[--n_large]] = 1;
+
+  free(small); free(large);
+  return table;
+}
+
+void free_AliasTable(struct AliasTable *table)
+{
+  if (table == NULL) return ;
+  free(table->prob);
+  free(table->alias);
+  return free(table);
+}
+
+int select_on_alias(struct AliasTable *table)
+/* Sélectionne i dans {0 ... n-1} avec P(i) = x[i] / somme(x) */
+{
+  return select_on_alias_r(table, NULL);
+}
+
+int select_on_alias_r(struct AliasTable *table, unsigned short *xsubi)
+{
+  double u = uniform(xsubi) * table->n;
+  int i = (int) u;
+  if (i >= table->n) i = table->n - 1;
+  return (u - i < table->prob[i]) ? i : table->alias[i];
+}
@@ -38,10 +38,25 @@ int select_on_distrib(double *x, int n);
 /* La distribution x se doit d'être initialisée.
  * Sélectionne un nombre aléatoire sur {0 ... n-1} selon la distribution x
  * i.e P(i) = x[i]. */
+int select_on_distrib_r(double *x, int n, unsigned short *xsubi);
+/* Idem, sur le flux aléatoire xsubi (erand48) ; celui du thread si xsubi
+ * vaut NULL. De même pour les autres fonctions _r. */
 
 void print_distrib(double *x, int n);
 /* Affiche la distribution x */
 
+/* **************** Flux aléatoires ********************* */
+/* Par défaut, tous les tirages se font sur drand48 (et rand). Un thread
+ * peut se donner son propre flux, un état erand48 : ses tirages ne
+ * dépendent plus des autres threads. */
+
+void set_thread_stream(unsigned short *xsubi);
+/* Flux du thread courant (NULL : drand48) ; xsubi doit lui survivre */
+double rand_uniform(void); /* Uniforme sur [0, 1[, sur le flux du thread */
+long rand_long(void); /* Uniforme sur [0, 2^31[ : lrand48 sur le flux du thread */
+int rand_int(int n);
+/* Uniforme sur {0 ... n-1}, sur le flux du thread (rand() % n sinon) */
+
 /* **************** Opérations ********************* */
 
 void sum_distrib(double *x, double *y, double scal, int n);
@@ -70,5 +85,24 @@ double *spherical_noise(int n);
 
 double rand_exponential(double lambda);
 /* Renvoie un nombre aléatoire de loi E(lambda) */
+double rand_exponential_r(double lambda, unsigned short *xsubi);
+
+/* ************************* TABLE D'ALIAS ************************* */
+/* Tirage en O(1) selon une distribution fixe (méthode de Vose) */
+
+struct AliasTable
+{
+  int n;
+  double *prob; /* prob[i] : probabilité de garder i plutôt que alias[i] */
+  int *alias;
+};
+
+struct AliasTable *new_AliasTable(double *x, int n);
+/* Table d'alias de la distribution x (pas nécessairement normalisée) */
+void free_AliasTable(struct AliasTable *table);
+
+int select_on_alias(struct AliasTable *table);
+/* Sélectionne i dans {0 ... n-1} avec P(i) = x[i] / somme(x) */
+int select_on_alias_r(struct AliasTable *table, unsigned short *xsubi);
 
 #endif
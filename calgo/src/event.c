@@ -1,66 +1,147 @@
 #include "event.h"
+#include "ladder.h"
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+static struct EventKey *new_EventKeys(int maxsize, void **block)
+/* Alloue un tas de maxsize clés. On décale de HEAP_ARITY - 1 clés le début
+ * d'un bloc aligné : les fils de k (HEAP_ARITY.k + 1 ...) commencent alors
+ * sur une frontière de ligne de cache. */
+{
+  size_t size = (maxsize + HEAP_ARITY - 1) * sizeof(struct EventKey);
+  if (mem_posix_memalign(MEM_EVENTS, block, CACHE_LINE, size))
+    handle_error("(posix_memalign) new_EventKeys");
+  return (struct EventKey*) *block + HEAP_ARITY - 1;
+}
 
 struct EventQueue *new_EventQueue(int maxsize)
+/* File par défaut (QUEUE_DARY) */
 {
-  struct EventQueue *qevents = malloc(sizeof(struct EventQueue));
+  return new_EventQueue_kind(QUEUE_DARY, maxsize);
+}
+
+struct EventQueue *new_EventQueue_kind(int kind, int maxsize)
+{
+  struct EventQueue *qevents = mem_malloc(MEM_EVENTS, sizeof(struct EventQueue));
   if (qevents == NULL) { fprintf(stderr, "(malloc) new_EventQueue\n");
                          exit(EXIT_FAILURE); }
 
-  qevents->events = malloc(maxsize * sizeof(struct Event));
+  qevents->events = mem_malloc(MEM_EVENTS, maxsize * sizeof(struct Event));
   if (qevents->events == NULL) { fprintf(stderr, "(malloc) new_EventQueue\n");
                                 exit(EXIT_FAILURE); }
+  qevents->kind = kind;
   qevents->n = 0;
   qevents->maxsize = maxsize;
+
+  qevents->keys = NULL; qevents->keys_block = NULL;
+  qevents->free_slots = NULL;
+  qevents->n_free = qevents->n_slab = 0;
+  qevents->ladder = NULL;
+  if (kind != QUEUE_BINARY)
+  {
+    qevents->free_slots = mem_malloc(MEM_EVENTS, maxsize * sizeof(int));
+    if (qevents->free_slots == NULL) handle_error("(malloc) new_EventQueue");
+  }
+  if (kind == QUEUE_DARY) qevents->keys = new_EventKeys(maxsize, &qevents->keys_block);
+  if (kind == QUEUE_LADDER) qevents->ladder = new_Ladder();
   return qevents;
 }
 
 
 void free_EventQueue(struct EventQueue *qevents)
 {
-  free(qevents->events);
-  return free(qevents);
+  mem_free(MEM_EVENTS, qevents->events);
+  mem_free(MEM_EVENTS, qevents->keys_block);
+  mem_free(MEM_EVENTS, qevents->free_slots);
+  if (qevents->ladder != NULL) free_Ladder(qevents->ladder);
+  return mem_free(MEM_EVENTS, qevents);
+}
+
+int queue_kind_from_name(const char *name)
+/* Renvoie l'implémentation de nom 'name', -1 si elle n'existe pas */
+{
+  for (int kind=QUEUE_BINARY; kind<=QUEUE_LADDER; kind++)
+    if (!strcmp(name, queue_kind_name(kind))) return kind;
+  return -1;
+}
+
+const char *queue_kind_name(int kind)
+{
+  if (kind == QUEUE_BINARY) return "binary";
+  if (kind == QUEUE_DARY)   return "dary";
+  if (kind == QUEUE_LADDER) return "ladder";
+  return "unknown";
 }
 
 struct EventQueue *extend_EventQueue(struct EventQueue *qevents)
-/* Double le nombre d'événements possibles dans la file */
+/* Double le nombre d'événements possibles dans la file (QUEUE_BINARY) */
+{
+  qevents->maxsize *= 2;
+  qevents->events = mem_realloc(MEM_EVENTS, qevents->events,
+                                qevents->maxsize * sizeof(struct Event));
+  if (qevents->events == NULL) handle_error("(realloc) extend_EventQueue");
+  return qevents;
+}
+
+static void extend_slab(struct EventQueue *qevents)
+/* Double la taille du slab, sur place */
+{
+  int maxsize = 2 * qevents->maxsize;
+
+  qevents->events = mem_realloc(MEM_EVENTS, qevents->events,
+                                maxsize * sizeof(struct Event));
+  qevents->free_slots = mem_realloc(MEM_EVENTS, qevents->free_slots,
+                                    maxsize * sizeof(int));
+  if (qevents->events == NULL || qevents->free_slots == NULL)
+    handle_error("(realloc) extend_slab");
+  qevents->maxsize = maxsize;
+  return ;
+}
+
+static int slab_put(struct EventQueue *qevents, struct Event event)
+/* Range l'événement dans une case libre du slab et renvoie son indice */
 {
-  struct EventQueue *extended_qevents = new_EventQueue(qevents->maxsize * 2);
-  for (int i=0; i<qevents->maxsize; i++)
-    extended_qevents->events[i] = qevents->events[i];
-  extended_qevents->n = qevents->n;
-  free_EventQueue(qevents);
-  return extended_qevents;
+  int idx = (qevents->n_free) ? qevents->free_slots[--qevents->n_free]
+                              : qevents->n_slab++;
+  qevents->events[idx] = event;
+  return idx;
 }
 
+static struct Event slab_take(struct EventQueue *qevents, int idx)
+/* Renvoie l'événement de la case idx, qui redevient libre */
+{
+  qevents->free_slots[qevents->n_free++] = idx;
+  return qevents->events[idx];
+}
 
-struct EventID new_EventID(double T, int source, int sink)
-/* Renvoie EventID(T, sink, source) */
+static void extend_dary(struct EventQueue *qevents)
+/* Double la taille du slab et du tas, sur place */
 {
-  struct EventID ID;
-  ID.T = T;
-  ID.source = source;
-  ID.sink   = sink;
-  return ID;
+  int maxsize = 2 * qevents->maxsize;
+  void *block;
+  struct EventKey *keys = new_EventKeys(maxsize, &block);
+  memcpy(keys, qevents->keys, qevents->n * sizeof(struct EventKey));
+  mem_free(MEM_EVENTS, qevents->keys_block);
+  qevents->keys = keys; qevents->keys_block = block;
+  extend_slab(qevents);
+  return ;
 }
 
-struct Event new_Event(double T, int u, int action, int sink, struct EventID ID)
-/* Renvoie Event(T, u, action, sink) */
+struct Event new_Event(double T, int u, int action, uint32_t arg)
+/* Renvoie Event(T, u, action, arg) */
 {
   struct Event event;
-  event.T  = T;
-  event.u  = u;
-  event.ID = ID;
-  event.sink   = sink;
-  event.action = action;
+  event.T   = T;
+  event.tag = ((uint32_t) u << EVENT_ACTION_BITS) | (uint32_t) action;
+  event.arg = arg;
 
   return event;
 }
 
 /* ***************** MANIPULATION DES ÉVÉNEMENTS ***************** */
 
-void add_Event(struct Event event, struct EventQueue **p_qevents)
-/* Ajoute un événement à l'ensemble des événements.
- * Passer un pointeur vers cet ensemble, en cas d'extension. */
+static void binary_add_Event(struct Event event, struct EventQueue **p_qevents)
+/* Tas binaire : on remonte l'événement par échanges successifs */
 {
   //printf("Adding : "); print_Event(event);
   if ((*p_qevents)->n >= (*p_qevents)->maxsize)
@@ -83,10 +164,8 @@ void add_Event(struct Event event, struct EventQueue **p_qevents)
   return;
 }
 
-int next_event(struct Event *event, struct EventQueue *qevents)
-/* Extrait l'événement suivant dans la file de priorité.
- * Renvoie 1 si l'extraction s'est passée sans soucis.
- * Renvoie 0 sinon. */
+static int binary_next_event(struct Event *event, struct EventQueue *qevents)
+/* Tas binaire : on fait descendre le dernier événement depuis la racine */
 {
   if (!qevents->n) return 0;
   //printf("== At top : "); print_Event(qevents->events[0]);
@@ -135,11 +214,121 @@ int next_event(struct Event *event, struct EventQueue *qevents)
   return 1;
 }
 
+static void dary_add_Event(struct Event event, struct EventQueue *qevents)
+/* Tas d-aire : l'événement va dans le slab, seule sa clé remonte le tas.
+ * On décale les pères vers le bas plutôt que d'échanger. */
+{
+  if (qevents->n >= qevents->maxsize) extend_dary(qevents);
+
+  struct EventKey *keys = qevents->keys;
+  struct EventKey key = { event.T, slab_put(qevents, event) };
+  int k = qevents->n++;
+  while (k > 0)
+  {
+    int m = (k-1) / HEAP_ARITY;
+    if (keys[m].T <= key.T) break;
+    keys[k] = keys[m];
+    k = m;
+  }
+  keys[k] = key;
+
+  return ;
+}
+
+static int dary_next_event(struct Event *event, struct EventQueue *qevents)
+/* Tas d-aire : on libère la case du slab de la racine, puis on fait descendre
+ * la dernière clé en suivant le plus petit des fils */
+{
+  if (!qevents->n) return 0;
+
+  struct EventKey *keys = qevents->keys;
+  *event = slab_take(qevents, keys[0].idx);
+
+  struct EventKey key = keys[--qevents->n];
+  int k = 0, n = qevents->n;
+  while (1)
+  {
+    int first = HEAP_ARITY*k + 1;
+    if (first >= n) break;
+    int last = (first + HEAP_ARITY < n) ? first + HEAP_ARITY : n;
+
+    int best = first;
+    for (int c=first+1; c<last; c++) if (keys[c].T < keys[best].T) best = c;
+    if (keys[best].T >= key.T) break;
+
+    keys[k] = keys[best];
+    k = best;
+  }
+  keys[k] = key;
+
+  return 1;
+}
+
+static void ladder_add_Event(struct Event event, struct EventQueue *qevents)
+{
+  if (qevents->n >= qevents->maxsize) extend_slab(qevents);
+  struct EventKey key = { event.T, slab_put(qevents, event) };
+  ladder_push(qevents->ladder, key);
+  qevents->n++;
+  return ;
+}
+
+static int ladder_next_event(struct Event *event, struct EventQueue *qevents)
+{
+  struct EventKey key;
+  if (!ladder_pop(qevents->ladder, &key)) return 0;
+  *event = slab_take(qevents, key.idx);
+  qevents->n--;
+  return 1;
+}
+
+void add_Event(struct Event event, struct EventQueue **p_qevents)
+/* Ajoute un événement à l'ensemble des événements.
+ * Passer un pointeur vers cet ensemble, en cas d'extension. */
+{
+  if ((*p_qevents)->kind == QUEUE_DARY) return dary_add_Event(event, *p_qevents);
+  if ((*p_qevents)->kind == QUEUE_LADDER)
+    return ladder_add_Event(event, *p_qevents);
+  return binary_add_Event(event, p_qevents);
+}
+
+int next_event(struct Event *event, struct EventQueue *qevents)
+/* Extrait l'événement suivant dans la file de priorité.
+ * Renvoie 1 si l'extraction s'est passée sans soucis.
+ * Renvoie 0 sinon. */
+{
+  if (qevents->kind == QUEUE_DARY) return dary_next_event(event, qevents);
+  if (qevents->kind == QUEUE_LADDER) return ladder_next_event(event, qevents);
+  return binary_next_event(event, qevents);
+}
+
 /* ***************** FONCTIONS D'AFFICHAGE ***************** */
 
 void print_Event(struct Event event)
 {
-  printf("(T: %.3f, u: %d, a: %d, t:%d)\n", event.T,      event.u,
-                                            event.action, event.sink);
+  printf("(T: %.3f, u: %d, a: %d, arg:%u)\n", event.T,      event_u(event),
+                                              event_action(event), event.arg);
+  return;
+}
+
+void print_EventQueue(struct EventQueue *qevents)
+/* Affiche les événements en attente (dans l'ordre du tas) */
+{
+  if (qevents->kind == QUEUE_LADDER)
+  { /* Pas d'ordre simple : on parcourt le slab */
+    char *is_free = calloc(qevents->n_slab + 1, sizeof(char));
+    if (is_free == NULL) handle_error("(calloc) print_EventQueue");
+    for (int i=0; i<qevents->n_free; i++) is_free[qevents->free_slots[i]] = 1;
+    for (int i=0; i<qevents->n_slab; i++)
+      if (!is_free[i]) print_Event(qevents->events[i]);
+    return free(is_free);
+  }
+
+  for (int i=0; i<qevents->n; i++)
+  {
+    if (qevents->kind == QUEUE_DARY)
+      print_Event(qevents->events[qevents->keys[i].idx]);
+    else print_Event(qevents->events[i]);
+  }
   return;
 }
@@ -3,46 +3,90 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "memory.h"
 
 #define NEW_PAQUET   0
 #define TREAT_PAQUET 1
 #define UPDATE_DISTRIB 2
+#define ARRIVAL      3 /* Arrivée sur la superposition de tous les flux */
+#define ENTER_PAQUET 4 /* Arrivée d'un paquet sur un nœud, après un lien */
 
-struct EventID
+/* L'action tient dans les bits de poids faible de 'tag', le nœud au-dessus */
+#define EVENT_ACTION_BITS 3
+#define EVENT_ACTION_MASK ((1u << EVENT_ACTION_BITS) - 1)
+#define EVENT_MAX_NODE    (UINT32_MAX >> EVENT_ACTION_BITS)
+
+struct Event /* La structure pour les événements (16 octets) */
 {
-  double T; /* Instant de création de l'évent. */
-  int source;
-  int sink;
+  double T;     /* Instant de l'event */
+  uint32_t tag; /* (nœud << EVENT_ACTION_BITS) | action */
+  uint32_t arg; /* NEW_PAQUET, UPDATE_DISTRIB : destination ;
+                 * TREAT_PAQUET, ENTER_PAQUET : identifiant du paquet
+                 * (network_simu.h) ;
+                 * ARRIVAL : inutilisé */
 };
 
-struct Event /* La structure pour les événements */
+#define event_u(e)      ((int) ((e).tag >> EVENT_ACTION_BITS)) /* Nœud concerné */
+#define event_action(e) ((int) ((e).tag & EVENT_ACTION_MASK))  /* ID de l'action */
+
+#define EVENT_QUEUE_SIZE 256 /* Taille initiale d'une file, doublée au besoin */
+
+/* Implémentations de la file de priorité */
+#define QUEUE_BINARY 0 /* Tas binaire des événements eux-mêmes */
+#define QUEUE_DARY   1 /* Tas 4-aire de clés (T, indice), événements à part */
+#define QUEUE_LADDER 2 /* Ladder queue (ladder.c), événements à part */
+
+struct Ladder;
+
+#define HEAP_ARITY 4   /* 4 clés de 16 octets : une ligne de cache */
+#define CACHE_LINE 64
+
+struct EventKey
+/* Clé d'un événement : son instant et sa case dans le slab */
 {
-  double T;   /* Instant de l'event */
-  int u;      /* Nœud concerné */
-  int sink;   /* Destination */
-  int action; /* ID de l'action */
-  struct EventID ID; /* Identifiant de l'évent (ses origines) */
+  double T;
+  int idx;
 };
 
 struct EventQueue
 /* Une file de priorité en pratique
  * File de priorité contenant les événements à traiter */
 {
-  struct Event *events;
+  int kind; /* QUEUE_BINARY, QUEUE_DARY ou QUEUE_LADDER */
+
+  struct Event *events; /* BINARY : le tas ; sinon le slab des événements */
   int n; /* Pointe sur la prochaine case vide dans events */
   int maxsize;
+
+  /* Slab (DARY et LADDER) */
+  int *free_slots;      /* Pile des cases libres du slab */
+  int n_free, n_slab;   /* Taille de la pile, cases du slab déjà utilisées */
+
+  /* DARY uniquement */
+  struct EventKey *keys; /* Le tas, décalé pour que les fils de chaque nœud
+                          * tiennent dans une ligne de cache */
+  void *keys_block;      /* Bloc aligné alloué (à libérer) */
+
+  struct Ladder *ladder; /* LADDER uniquement */
 };
 
 struct EventQueue *new_EventQueue(int maxsize);
+/* File par défaut (QUEUE_DARY) */
+struct EventQueue *new_EventQueue_kind(int kind, int maxsize);
 void free_EventQueue(struct EventQueue *qevents);
 
+int queue_kind_from_name(const char *name);
+/* Renvoie l'implémentation de nom 'name', -1 si elle n'existe pas */
+const char *queue_kind_name(int kind);
+
 struct EventQueue *extend_EventQueue(struct EventQueue *qevents);
-/* Double le nombre d'événements possibles dans la file */
+/* Double le nombre d'événements possibles dans la file (QUEUE_BINARY), sur
+ * place si realloc le permet. Renvoie la file. */
 
-struct EventID new_EventID(double T, int source, int sink);
-/* Renvoie EventID(T, sink, source) */
-struct Event new_Event(double T, int u, int action, int sink, struct EventID ID);
-/* Renvoie Event(T, u, action, sink) */
+struct Event new_Event(double T, int u, int action, uint32_t arg);
+/* Renvoie Event(T, u, action, arg) */
 
 /* ***************** MANIPULATION DES ÉVÉNEMENTS ***************** */
 
@@ -58,5 +102,7 @@ int next_event(struct Event *event, struct EventQueue *qevents);
 /* ***************** FONCTIONS D'AFFICHAGE ***************** */
 
 void print_Event(struct Event event);
+void print_EventQueue(struct EventQueue *qevents);
+/* Affiche les événements en attente (dans l'ordre du tas) */
 
 #endif
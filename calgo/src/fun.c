@@ -25,5 +25,7 @@ double fun_d2deg3(double x) { return 6*x; }
 
 double fun_inv  (double x) { return 1 / (2 - x); }
 double fun_dinv (double x) { return 1 / ((2-x)*(2-x)); }
+double fun_d2inv(double x) { return 2 / ((2-x)*(2-x)*(2-x)); }
 double fun_inv2 (double x) { return 1 / ((2-x)*(2-x)); }
 double fun_dinv2(double x) { return 1 / ((2-x)*(2-x)*(2-x)); }
+double fun_d2inv2(double x) { return 6 / ((2-x)*(2-x)*(2-x)*(2-x)); }
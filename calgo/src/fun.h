@@ -28,7 +28,9 @@ double fun_d2deg3(double x);
 
 double fun_inv  (double x);
 double fun_dinv (double x);
+double fun_d2inv(double x);
 double fun_inv2 (double x);
 double fun_dinv2(double x);
+double fun_d2inv2(double x);
 
 #endif
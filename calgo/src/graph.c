@@ -1,4 +1,5 @@
 #include "graph.h"
+#include "distrib.h"
 
 /* Fonctions de base :
  * nouveau graphe, libération d'un graphe, initialisation aléatoire */
@@ -8,15 +9,15 @@
 struct graph *new_graph(int n)
 /* Renvoie un nouveau graphe */
 {
-  struct graph *g = calloc(1, sizeof (struct graph));
+  struct graph *g = mem_calloc(MEM_GRAPH, 1, sizeof (struct graph));
   if (g == NULL) handle_error("new_graph");
 
   g->n = n;
-  g->network = calloc(n, sizeof (int*));
+  g->network = mem_calloc(MEM_GRAPH, n, sizeof (int*));
   if (g->network == NULL) handle_error("new_graph");
   for (int i=0; i<n; i++)
   {
-    g->network[i] = calloc(n, sizeof (int));
+    g->network[i] = mem_calloc(MEM_GRAPH, n, sizeof (int));
     if (g->network[i] == NULL) handle_error("new_graph");
   }
 
@@ -28,8 +29,8 @@ void free_graph(struct graph *g)
 {
   if (g != NULL)
   {
-    for (int i=0; i<g->n; i++) free(g->network[i]);
-    free(g->network); free(g);
+    for (int i=0; i<g->n; i++) mem_free(MEM_GRAPH, g->network[i]);
+    mem_free(MEM_GRAPH, g->network); mem_free(MEM_GRAPH, g);
   }
   return ;
 }
@@ -40,7 +41,7 @@ void set_random (struct graph *g, double p)
   for (int i=0; i<g->n-1; i++)
   for (int j=i+1; j<g->n; j++)
   {
-    if (drand48() < p) g->network[j][i] = g->network[i][j] = 1;
+    if (rand_uniform() < p) g->network[j][i] = g->network[i][j] = 1;
     else               g->network[j][i] = g->network[i][j] = 0;
   }
   return ;
@@ -52,7 +53,7 @@ void set_drandom(struct graph *g, double p)
   for (int i=0; i<g->n; i++)
   for (int j=0; j<g->n; j++)
   {
-    if (i != j && drand48() < p) g->network[i][j] = 1;
+    if (i != j && rand_uniform() < p) g->network[i][j] = 1;
     else                         g->network[i][j] = 0;
   }
   return ;
@@ -79,7 +80,7 @@ void set_randDAG(struct graph *g, double p)
   for (int i=0; i<g->n; i++)
   for (int j=0; j<g->n; j++)
   {
-    if (i < j && drand48() < p) g->network[i][j] = 1;
+    if (i < j && rand_uniform() < p) g->network[i][j] = 1;
     else                        g->network[i][j] = 0;
   }
 
@@ -123,8 +124,8 @@ struct Couple connected_couple_DAG(struct graph *g)
   int u, v;
   do
   {
-    a = rand() % g->n;
-    b = rand() % g->n;
+    a = rand_int(g->n);
+    b = rand_int(g->n);
     u = (a > b) ? b : a;
     v = (a > b) ? a : b;
   } while ( a == b || !connected(u, v, g));
@@ -209,6 +210,32 @@ struct List *path_from_to(int u, int v, struct graph *g, int **vertices)
   return all_paths;
 }
 
+double path_from_to_size(int u, int v, struct graph *g)
+/* Octets des maillons que renverra path_from_to(u, v, g, .), comptés sans
+ * énumérer les chemins (DAG en ordre topologique) */
+{
+  if (u > v) return sizeof(struct List);
+
+  /* count[w] : nombre de chemins w --> v ; length[w] : total de leurs sommets */
+  double *count = calloc(g->n, sizeof(double));
+  double *length = calloc(g->n, sizeof(double));
+  if (count == NULL || length == NULL) handle_error("(calloc) path_from_to_size");
+
+  count[v] = length[v] = 1;
+  for (int w=v-1; w>=u; w--)
+  for (int x=w+1; x<=v; x++) if (g->network[w][x])
+  {
+    count[w] += count[x];
+    length[w] += length[x] + count[x];
+  }
+
+  /* Un maillon par sommet, plus une liste vide par chemin et une pour la
+   * liste des chemins */
+  double cells = length[u] + 2 * count[u] + 1;
+  free(count); free(length);
+  return cells * sizeof(struct List);
+}
+
 
 /* Fonctions utilitaires : Affichages & co */
 
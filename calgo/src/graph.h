@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "list.h"
+#include "memory.h"
 
 struct Couple
 /* Petite structure de couple bien pratique */
@@ -51,6 +52,9 @@ struct List *path_from_to(int u, int v, struct graph *g, int **vertices);
 /* Renvoie la liste des chemins u --> v dans g
  * Astuce : on a un tableau t tel que t[i] est un pointeur vers un
  * entier de valeur i */
+double path_from_to_size(int u, int v, struct graph *g);
+/* Octets des maillons que renverra path_from_to(u, v, g, .), comptés sans
+ * énumérer les chemins (DAG en ordre topologique) */
 
 
 /* Utilitaires : affichages & co */
@@ -0,0 +1,211 @@
+#include "ladder.h"
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+/* ************************ SEAUX ************************ */
+
+static void bucket_add(struct LadderBucket *bucket, struct EventKey key)
+{
+  if (bucket->n >= bucket->size)
+  {
+    bucket->size = (bucket->size) ? 2 * bucket->size : 8;
+    bucket->keys = mem_realloc(MEM_EVENTS, bucket->keys,
+                               bucket->size * sizeof(struct EventKey));
+    if (bucket->keys == NULL) handle_error("(realloc) bucket_add");
+  }
+  bucket->keys[bucket->n++] = key;
+  return ;
+}
+
+static int cmp_keys_decreasing(const void *a, const void *b)
+{
+  double Ta = ((const struct EventKey*) a)->T;
+  double Tb = ((const struct EventKey*) b)->T;
+  return (Ta < Tb) - (Ta > Tb);
+}
+
+/* ************************ ADMINISTRATION ************************ */
+
+struct Ladder *new_Ladder(void)
+{
+  struct Ladder *ladder = mem_calloc(MEM_EVENTS, 1, sizeof(struct Ladder));
+  if (ladder == NULL) handle_error("(calloc) new_Ladder");
+  ladder->top_start = -INFINITY; /* Tant qu'il n'y a pas de barreau, tout va en haut */
+  ladder->top_min = INFINITY; ladder->top_max = -INFINITY;
+  return ladder;
+}
+
+void free_Ladder(struct Ladder *ladder)
+{
+  mem_free(MEM_EVENTS, ladder->top.keys);
+  mem_free(MEM_EVENTS, ladder->bottom.keys);
+  for (int r=0; r<LADDER_RUNGS; r++)
+  {
+    for (int b=0; b<ladder->rungs[r].cap; b++)
+      mem_free(MEM_EVENTS, ladder->rungs[r].buckets[b].keys);
+    mem_free(MEM_EVENTS, ladder->rungs[r].buckets);
+  }
+  return mem_free(MEM_EVENTS, ladder);
+}
+
+/* ************************ BARREAUX ************************ */
+
+static double rung_current_start(struct LadderRung *rung)
+/* Début du prochain seau à vider : en deçà, le barreau ne reçoit plus rien */
+{
+  return rung->start + rung->current * rung->width;
+}
+
+static void rung_add(struct LadderRung *rung, struct EventKey key)
+{
+  int b = (int) ((key.T - rung->start) / rung->width);
+  if (b < rung->current) b = rung->current; /* Arrondis flottants */
+  if (b >= rung->nb) b = rung->nb - 1;
+  bucket_add(&rung->buckets[b], key);
+  rung->count++;
+  return ;
+}
+
+static int spawn_rung(struct Ladder *ladder, struct EventKey *keys, int n,
+                      double start, double end)
+/* Crée un nouveau barreau (le plus bas) couvrant [start, end[ et y répartit
+ * les n clés. Les seaux sont dimensionnés pour en recevoir une chacun en
+ * moyenne. Renvoie 0 si c'est impossible (plus de barreau, largeur nulle). */
+{
+  if (ladder->n_rungs >= LADDER_RUNGS || !(end > start)) return 0;
+
+  struct LadderRung *rung = &ladder->rungs[ladder->n_rungs];
+  if (rung->cap < n)
+  {
+    rung->buckets = mem_realloc(MEM_EVENTS, rung->buckets,
+                                n * sizeof(struct LadderBucket));
+    if (rung->buckets == NULL) handle_error("(realloc) spawn_rung");
+    memset(rung->buckets + rung->cap, 0, (n - rung->cap) * sizeof(struct LadderBucket));
+    rung->cap = n;
+  }
+  for (int b=0; b<n; b++) rung->buckets[b].n = 0;
+
+  rung->start = start;
+  rung->width = (end - start) / n;
+  if (!(rung->width > 0)) return 0;
+  rung->nb = n;
+  rung->current = 0;
+  rung->count = 0;
+  ladder->n_rungs++;
+
+  for (int i=0; i<n; i++) rung_add(rung, keys[i]);
+  return 1;
+}
+
+static void to_bottom(struct Ladder *ladder, struct EventKey *keys, int n)
+/* Verse n clés dans Bottom (vide) et le trie */
+{
+  for (int i=0; i<n; i++) bucket_add(&ladder->bottom, keys[i]);
+  qsort(ladder->bottom.keys, ladder->bottom.n, sizeof(struct EventKey),
+        cmp_keys_decreasing);
+  return ;
+}
+
+static void refill_bottom(struct Ladder *ladder)
+/* Remplit Bottom (vide) avec le prochain seau non vide, en éclatant les seaux
+ * trop pleins en barreaux plus fins */
+{
+  while (1)
+  {
+    if (!ladder->n_rungs)
+    {
+      struct LadderBucket *top = &ladder->top;
+      if (!top->n) return;
+
+      /* Top -> premier barreau. Les instants >= top_max resteront en haut. */
+      ladder->top_start = ladder->top_max;
+      if (top->n <= LADDER_THRES || !spawn_rung(ladder, top->keys, top->n,
+                                                ladder->top_min, ladder->top_max))
+        /* Peu d'événements, ou instants tous égaux : directement en bas */
+        to_bottom(ladder, top->keys, top->n);
+      top->n = 0;
+      ladder->top_min = INFINITY; ladder->top_max = -INFINITY;
+      if (ladder->bottom.n) return;
+      continue;
+    }
+
+    struct LadderRung *rung = &ladder->rungs[ladder->n_rungs - 1];
+    while (rung->current < rung->nb && !rung->buckets[rung->current].n)
+      rung->current++;
+    if (rung->current >= rung->nb) { ladder->n_rungs--; continue; }
+
+    struct LadderBucket *bucket = &rung->buckets[rung->current];
+    double start = rung_current_start(rung);
+    rung->current++;
+    rung->count -= bucket->n;
+
+    /* Seau trop plein : on l'éclate en un barreau plus fin */
+    if (bucket->n <= LADDER_THRES
+        || !spawn_rung(ladder, bucket->keys, bucket->n, start, start + rung->width))
+      to_bottom(ladder, bucket->keys, bucket->n);
+    bucket->n = 0;
+
+    if (ladder->bottom.n) return;
+  }
+}
+
+/* ************************ MANIPULATION ************************ */
+
+void ladder_push(struct Ladder *ladder, struct EventKey key)
+/* Ajoute la clé à la file */
+{
+  ladder->n++;
+
+  if (key.T >= ladder->top_start)
+  {
+    bucket_add(&ladder->top, key);
+    if (key.T < ladder->top_min) ladder->top_min = key.T;
+    if (key.T > ladder->top_max) ladder->top_max = key.T;
+    return ;
+  }
+
+  /* Un barreau épuisé (mais pas encore retiré) ne reçoit plus rien */
+  for (int r=0; r<ladder->n_rungs; r++)
+  if (ladder->rungs[r].current < ladder->rungs[r].nb
+      && key.T >= rung_current_start(&ladder->rungs[r]))
+  {
+    rung_add(&ladder->rungs[r], key);
+    return ;
+  }
+
+  /* Insertion triée dans Bottom (les plus petits instants à la fin) */
+  struct LadderBucket *bottom = &ladder->bottom;
+  bucket_add(bottom, key);
+  int i = bottom->n - 1;
+  while (i > 0 && bottom->keys[i-1].T < key.T)
+  {
+    bottom->keys[i] = bottom->keys[i-1];
+    i--;
+  }
+  bottom->keys[i] = key;
+
+  /* Bottom trop gros : on en fait un barreau */
+  if (bottom->n > 4 * LADDER_THRES)
+  {
+    double end = (ladder->n_rungs)
+                 ? rung_current_start(&ladder->rungs[ladder->n_rungs - 1])
+                 : ladder->top_start;
+    struct LadderBucket full = *bottom;
+    bottom->keys = NULL; bottom->n = bottom->size = 0;
+    if (!spawn_rung(ladder, full.keys, full.n, full.keys[full.n - 1].T, end))
+    { *bottom = full; return ; }
+    mem_free(MEM_EVENTS, full.keys);
+  }
+  return ;
+}
+
+int ladder_pop(struct Ladder *ladder, struct EventKey *key)
+/* Extrait la plus petite clé. Renvoie 0 si la file est vide, 1 sinon. */
+{
+  if (!ladder->bottom.n) refill_bottom(ladder);
+  if (!ladder->bottom.n) return 0;
+
+  *key = ladder->bottom.keys[--ladder->bottom.n];
+  ladder->n--;
+  return 1;
+}
@@ -0,0 +1,66 @@
+#ifndef ladder_h
+#define ladder_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "event.h"
+
+/* Ladder queue (Tang, Goh & Thng, 2005) : file de priorité en O(1) amorti
+ * quand les instants des événements sont bien répartis, ce qui est le cas
+ * des tirages exponentiels de la simulation.
+ *
+ * Trois étages :
+ *  - Top    : événements lointains, non triés ;
+ *  - Ladder : barreaux de seaux de largeur constante. Un seau trop plein est
+ *             éclaté en un barreau plus fin plutôt que trié ;
+ *  - Bottom : petit tableau trié, d'où l'on extrait.
+ * Le nombre et la largeur des seaux d'un barreau sont recalculés à chaque
+ * création de barreau, à partir du nombre d'événements à y répartir. */
+
+#define LADDER_RUNGS  8    /* Nombre maximal de barreaux */
+#define LADDER_THRES  50   /* Taille maximale d'un seau trié directement */
+
+struct LadderBucket
+{
+  struct EventKey *keys;
+  int n, size;
+};
+
+struct LadderRung
+{
+  double start, width; /* Le seau b couvre [start + b.width, start + (b+1).width[ */
+  int nb;              /* Nombre de seaux utilisés */
+  int current;         /* Prochain seau à vider */
+  int count;           /* Nombre d'événements dans le barreau */
+  struct LadderBucket *buckets;
+  int cap;             /* Nombre de seaux alloués */
+};
+
+struct Ladder
+{
+  struct LadderBucket top;
+  double top_min, top_max, top_start; /* Top reçoit les instants >= top_start */
+
+  struct LadderRung rungs[LADDER_RUNGS];
+  int n_rungs;
+
+  struct LadderBucket bottom; /* Trié par instants décroissants */
+  int n; /* Nombre total d'événements */
+};
+
+/* ************************ ADMINISTRATION ************************ */
+
+struct Ladder *new_Ladder(void);
+void free_Ladder(struct Ladder *ladder);
+
+/* ************************ MANIPULATION ************************ */
+
+void ladder_push(struct Ladder *ladder, struct EventKey key);
+/* Ajoute la clé à la file */
+
+int ladder_pop(struct Ladder *ladder, struct EventKey *key);
+/* Extrait la plus petite clé. Renvoie 0 si la file est vide, 1 sinon. */
+
+#endif
@@ -8,7 +8,7 @@
 struct List *new_empty(void)
 /* Renvoie une liste vide */
 {
-  struct List *l = malloc(sizeof(struct List));
+  struct List *l = mem_malloc(MEM_PATHS, sizeof(struct List));
   if (l == NULL) handle_error("(List) new_empty");
 
   l->tail = l->head = NULL;
@@ -24,10 +24,10 @@ void free_List(struct List *l, void (*free_el)(void* el))
   {
     next = l->tail;
     free_el(l->head);
-    free(l);
+    mem_free(MEM_PATHS, l);
     l = next;
   }
-  free(l);
+  mem_free(MEM_PATHS, l);
   return ;
 }
 
@@ -53,10 +53,10 @@ void free_paths(struct List *l)
   {
     next = l->tail;
     free_List(l->head, pass);
-    free(l);
+    mem_free(MEM_PATHS, l);
     l = next;
   }
-  free(l); /* on libère la liste vide */
+  mem_free(MEM_PATHS, l); /* on libère la liste vide */
   return;
 }
 
@@ -104,12 +104,12 @@ struct List *concat(struct List *l1, struct List *l2)
 {
   if (is_empty(l1))
   {
-    free(l1);
+    mem_free(MEM_PATHS, l1);
     return l2;
   }
   else /* donc l1 != [] */
   {
-    free(l1->jmper->tail); /* l1->jmper->tail est nécessairement [] */
+    mem_free(MEM_PATHS, l1->jmper->tail); /* l1->jmper->tail est nécessairement [] */
     l1->jmper->tail = l2;
     if (!is_empty(l2)) l1->jmper = l2->jmper; /* on ne veut pas faire pointer
                                                * le jumper vers [] */
@@ -130,6 +130,29 @@ struct List *add_on(struct List *l, void *el)
   return l0;
 }
 
+void drop_head(struct List *l, void (*free_el)(void* el))
+/* Retire sur place le premier élément de l (non vide) : le maillon l prend
+ * le contenu du suivant, qui est libéré */
+{
+  struct List *next = l->tail;
+  free_el(l->head);
+  l->head  = next->head;
+  l->tail  = next->tail;
+  l->jmper = next->jmper;
+  mem_free(MEM_PATHS, next);
+  return ;
+}
+
+void fix_jmper(struct List *l)
+/* Recalcule le jmper de la vraie tête l */
+{
+  if (is_empty(l)) return ;
+  struct List *last = l;
+  while (!is_empty(last->tail)) last = last->tail;
+  l->jmper = last;
+  return ;
+}
+
 /* ******************************* AFFICHAGE ****************************** */
 
 void aff_List(struct List *l, void (*aff_el)(void* el))
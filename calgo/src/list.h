@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "memory.h"
 
 /* ************************* LISTES ************************ */
 /* Je définis ici une structure de listes non typées
@@ -31,6 +32,7 @@ void partial_free_List(struct List *l);
 /* Libère la mémoire dédiée à une liste, et libère ses éléments en utilisant
  * la fonction 'free' */
 
+void pass(void* x); /* Ne fait rien : pour free_List sans les éléments */
 void free_paths(struct List *l);
 /* Libère une liste de chemins (i.e type (int list) list) */
 
@@ -54,6 +56,13 @@ struct List *add_on(struct List *l, void *el);
 /* l doit être une liste de listes.
  * si l = l1 :: l2 :: l3 :: ..., renvoie (el :: l1) :: (el :: l2) :: .... */
 
+void drop_head(struct List *l, void (*free_el)(void* el));
+/* Retire sur place le premier élément de l (non vide), libéré avec free_el :
+ * le maillon l prend le contenu du suivant. Ceux qui pointaient vers l voient
+ * donc sa queue. Le jmper de la vraie tête est à refaire (fix_jmper). */
+void fix_jmper(struct List *l);
+/* Recalcule le jmper de la vraie tête l */
+
 /* Fonctions d'affichage */
 
 void aff_List(struct List *l, void (*aff_el)(void* el));
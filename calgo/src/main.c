@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <sys/time.h>
 #include "graph.h"
@@ -10,12 +11,20 @@
 #include "ui.h"
 #include "shell.h"
 #include "event.h"
+#include "server.h"
 
 #define N 10
 #define NPLAYERS 15
 #define NITER    100
 
-int main(void)
+static void usage(const char *name)
+{
+  fprintf(stderr, "Usage : %s [--script commandes] [--out résultats.csv|.jsonl]\n"
+          "        %s --serve socket [--workers P]\n", name, name);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
 {
   struct timeval tv;
   gettimeofday(&tv, NULL);
@@ -39,9 +48,35 @@ int main(void)
   free_graph(g);
   free_Network(net);
   */
+  /* Mode serveur : sessions résidentes derrière une socket Unix */
+  if (argc > 1 && !strcmp(argv[1], "--serve"))
+  {
+    if (argc != 3 && !(argc == 5 && !strcmp(argv[3], "--workers")))
+      usage(argv[0]);
+    return serve(argv[2], (argc == 5) ? atoi(argv[4]) : 0);
+  }
+
   struct Shell *sh = new_Shell();
-  while(1) treat_cmd(sh);
+
+  /* Mode batch : commandes lues dans un fichier, sans invite ; résultats
+   * structurés dans un autre */
+  for (int i=1; i<argc; i++)
+  {
+    if (!strcmp(argv[i], "--script") && i + 1 < argc)
+    {
+      if ((sh->in = fopen(argv[++i], "r")) == NULL)
+      { perror(argv[i]); return EXIT_FAILURE; }
+      sh->batch = 1;
+    }
+    else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+    {
+      if ((sh->out = new_Output(argv[++i])) == NULL)
+      { perror(argv[i]); return EXIT_FAILURE; }
+    }
+    else usage(argv[0]);
+  }
+
+  while (!(sh->batch && feof(sh->in))) treat_cmd(sh);
   free_Shell(sh);
-  printf("Hello World!\n");
   return 0;
 }
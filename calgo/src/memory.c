@@ -0,0 +1,97 @@
+#include "memory.h"
+#include <malloc.h>
+#include <sys/resource.h>
+
+static const char *tag_names[N_MEM_TAGS] =
+  { "graph", "network", "paths", "routing", "events", "packets" };
+
+static long long current[N_MEM_TAGS], peak[N_MEM_TAGS], allocs[N_MEM_TAGS];
+static long long total_current, total_peak;
+
+/* *********************** DÉCOMPTE *********************** */
+
+static void raise_peak(long long *peak_p, long long value)
+{
+  long long seen = __atomic_load_n(peak_p, __ATOMIC_RELAXED);
+  while (value > seen
+         && !__atomic_compare_exchange_n(peak_p, &seen, value, 1,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+  return ;
+}
+
+static void count(int tag, long long bytes, int new_block)
+/* bytes octets de plus (ou de moins) pour tag */
+{
+  long long now = __atomic_add_fetch(&current[tag], bytes, __ATOMIC_RELAXED);
+  long long all = __atomic_add_fetch(&total_current, bytes, __ATOMIC_RELAXED);
+  if (new_block) __atomic_fetch_add(&allocs[tag], 1, __ATOMIC_RELAXED);
+  if (bytes > 0) { raise_peak(&peak[tag], now); raise_peak(&total_peak, all); }
+  return ;
+}
+
+/* *********************** ALLOCATION *********************** */
+
+void *mem_malloc(int tag, size_t size)
+{
+  void *p = malloc(size);
+  if (p != NULL && tag != MEM_NONE) count(tag, malloc_usable_size(p), 1);
+  return p;
+}
+
+void *mem_calloc(int tag, size_t n, size_t size)
+{
+  void *p = calloc(n, size);
+  if (p != NULL && tag != MEM_NONE) count(tag, malloc_usable_size(p), 1);
+  return p;
+}
+
+void *mem_realloc(int tag, void *p, size_t size)
+/* Si realloc échoue, p reste valide et son décompte aussi */
+{
+  if (tag == MEM_NONE) return realloc(p, size);
+  long long before = (p != NULL) ? (long long) malloc_usable_size(p) : 0;
+  void *q = realloc(p, size);
+  if (q == NULL) return NULL;
+  count(tag, (long long) malloc_usable_size(q) - before, p == NULL);
+  return q;
+}
+
+int mem_posix_memalign(int tag, void **p, size_t alignment, size_t size)
+{
+  int error = posix_memalign(p, alignment, size);
+  if (!error && tag != MEM_NONE) count(tag, malloc_usable_size(*p), 1);
+  return error;
+}
+
+void mem_free(int tag, void *p)
+{
+  if (p == NULL || tag == MEM_NONE) return free(p);
+  count(tag, -(long long) malloc_usable_size(p), 0);
+  return free(p);
+}
+
+/* *********************** CONSULTATION *********************** */
+
+long long mem_current(int tag)
+{
+  if (tag < 0) return __atomic_load_n(&total_current, __ATOMIC_RELAXED);
+  return __atomic_load_n(&current[tag], __ATOMIC_RELAXED);
+}
+
+void print_memory(FILE *f)
+{
+  fprintf(f, "%-10s %12s %12s %12s\n", "tag", "current KiB", "peak KiB",
+          "allocations");
+  for (int t=0; t<N_MEM_TAGS; t++)
+    fprintf(f, "%-10s %12.1f %12.1f %12lld\n", tag_names[t],
+            mem_current(t) / 1024., __atomic_load_n(&peak[t], __ATOMIC_RELAXED)
+            / 1024., __atomic_load_n(&allocs[t], __ATOMIC_RELAXED));
+  fprintf(f, "%-10s %12.1f %12.1f\n", "total", mem_current(-1) / 1024.,
+          __atomic_load_n(&total_peak, __ATOMIC_RELAXED) / 1024.);
+
+  struct rusage usage;
+  if (!getrusage(RUSAGE_SELF, &usage))
+    fprintf(f, "Process peak resident size : %ld KiB\n", usage.ru_maxrss);
+  return ;
+}
@@ -0,0 +1,42 @@
+#ifndef memory_h
+#define memory_h
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* On définit ici le décompte de la mémoire par sous-système : les
+ * structures qui grossissent avec le graphe ou le nombre de joueurs sont
+ * allouées par mem_malloc & co, avec une étiquette, et libérées par
+ * mem_free avec la même. Pour chaque étiquette, on suit les octets en
+ * cours, leur maximum et le nombre d'allocations. La taille d'un bloc est
+ * celle que rapporte l'allocateur (malloc_usable_size) : pas d'en-tête, et
+ * un bloc libéré par free au lieu de mem_free fausse le décompte sans rien
+ * casser. Les compteurs sont atomiques (réplicas). */
+
+#define MEM_GRAPH   0 /* Matrices d'adjacence */
+#define MEM_NETWORK 1 /* Matrices des réseaux (masses, fonctions de coût) */
+#define MEM_PATHS   2 /* Maillons de listes : chemins des joueurs */
+#define MEM_ROUTING 3 /* Tables de routage et nœuds de la simulation */
+#define MEM_EVENTS  4 /* Files d'événements */
+#define MEM_PACKETS 5 /* Paquets en vol de la simulation */
+#define N_MEM_TAGS  6
+#define MEM_NONE    (-1) /* Pas de décompte : malloc & co tout court */
+
+/* *********************** ALLOCATION *********************** */
+
+void *mem_malloc(int tag, size_t size);
+void *mem_calloc(int tag, size_t n, size_t size);
+void *mem_realloc(int tag, void *p, size_t size);
+int mem_posix_memalign(int tag, void **p, size_t alignment, size_t size);
+void mem_free(int tag, void *p);
+/* Comme leurs homologues de la libc (NULL en cas d'échec) */
+
+/* *********************** CONSULTATION *********************** */
+
+long long mem_current(int tag); /* Octets en cours ; tag < 0 : total */
+
+void print_memory(FILE *f);
+/* Tableau par étiquette : en cours, maximum, allocations ; puis le total et
+ * le pic de mémoire résidente du processus */
+
+#endif
@@ -0,0 +1,302 @@
+#include "network_par.h"
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+/* *********************** PARTITIONS *********************** */
+
+static struct SimulatedNetwork *new_partition(struct SimulatedNetwork *snet,
+                                              struct SimuParallel *par, int p)
+/* La partition p de snet : copie de snet qui en partage les nœuds, les
+ * joueurs et lambda, avec sa propre file, ses paquets et ses statistiques */
+{
+  struct SimulatedNetwork *part = malloc(sizeof(struct SimulatedNetwork));
+  if (part == NULL) handle_error("(malloc) new_partition");
+  *part = *snet;
+
+  part->qevents = new_EventQueue_kind(snet->qevents->kind, EVENT_QUEUE_SIZE);
+  part->packets = NULL; part->free_packets = NULL;
+  part->n_free_packets = part->n_packets = part->max_packets = 0;
+  part->trace = NULL;
+  part->stats = (snet->stats != NULL) ? new_SimuStats(snet->n, snet->lambda)
+                                      : NULL;
+  part->flows = NULL; part->flow_source = part->flow_sink = NULL;
+  part->rate = 0;
+  part->rng = par->rng[p];
+  part->par = par; part->part = p;
+  return part;
+}
+
+static void free_partition(struct SimulatedNetwork *part)
+/* Ne libère que ce qui est propre à la partition */
+{
+  free_EventQueue(part->qevents);
+  mem_free(MEM_PACKETS, part->packets);
+  mem_free(MEM_PACKETS, part->free_packets);
+  free_SimuStats(part->stats);
+  free_AliasTable(part->flows);
+  free(part->flow_source);
+  free(part->flow_sink);
+  return free(part);
+}
+
+static struct SimuParallel *new_SimuParallel(struct SimulatedNetwork *snet,
+                                             int P, long long max_events)
+{
+  int n = snet->n;
+  struct SimuParallel *par = malloc(sizeof(struct SimuParallel));
+  if (par == NULL) handle_error("(malloc) new_SimuParallel");
+
+  par->P = P; par->n = n;
+  par->window = snet->delay;
+  par->max_events = max_events;
+
+  par->owner = malloc(n * sizeof(int));
+  par->part  = malloc(P * sizeof(struct SimulatedNetwork*));
+  par->rng   = malloc(P * sizeof(unsigned short[3]));
+  par->chan  = malloc(P * sizeof(struct Channel*));
+  par->next_T   = malloc(P * sizeof(double));
+  par->n_events = malloc(P * sizeof(long long));
+  par->shadow_W = malloc(n * sizeof(double*));
+  par->shadowed   = malloc(P * sizeof(int*));
+  par->n_shadowed = calloc(P, sizeof(int));
+  if (par->owner == NULL || par->part == NULL || par->rng == NULL
+      || par->chan == NULL || par->next_T == NULL || par->n_events == NULL
+      || par->shadow_W == NULL || par->shadowed == NULL
+      || par->n_shadowed == NULL)
+    handle_error("(malloc) new_SimuParallel");
+  if (posix_memalign((void**) &par->shadow_node, CACHE_LINE,
+                     n * sizeof(struct SimulatedNode)))
+    handle_error("(posix_memalign) new_SimuParallel");
+
+  /* Blocs contigus */
+  for (int u=0; u<n; u++) par->owner[u] = (int) ((long long) u * P / n);
+
+  /* Images : les nœuds dont un prédécesseur est dans une autre partition */
+  for (int v=0; v<n; v++) par->shadow_W[v] = NULL;
+  for (int u=0; u<n; u++) for (int k=0; k<snet->vertex[u].d; k++)
+  {
+    int v = snet->vertex[u].neighbours[k];
+    if (par->owner[v] == par->owner[u] || par->shadow_W[v] != NULL) continue;
+    /* Au moins une case, pour que NULL reste « pas d'image » */
+    par->shadow_W[v] = malloc((snet->vertex[v].n_dests + 1) * sizeof(double));
+    if (par->shadow_W[v] == NULL) handle_error("(malloc) new_SimuParallel");
+    par->n_shadowed[par->owner[v]] ++;
+  }
+  for (int p=0; p<P; p++)
+  {
+    par->shadowed[p] = malloc(par->n_shadowed[p] * sizeof(int));
+    if (par->shadowed[p] == NULL && par->n_shadowed[p])
+      handle_error("(malloc) new_SimuParallel");
+    par->n_shadowed[p] = 0;
+  }
+  for (int v=0; v<n; v++) if (par->shadow_W[v] != NULL)
+    par->shadowed[par->owner[v]][par->n_shadowed[par->owner[v]]++] = v;
+
+  for (int p=0; p<P; p++)
+  {
+    /* Flux aléatoires tirés sur celui du thread : reproductibles */
+    for (int i=0; i<3; i++) par->rng[p][i] = (unsigned short) rand_long();
+    par->part[p] = new_partition(snet, par, p);
+
+    par->chan[p] = malloc(P * sizeof(struct Channel));
+    if (par->chan[p] == NULL) handle_error("(malloc) new_SimuParallel");
+    for (int q=0; q<P; q++)
+    { par->chan[p][q].msg = NULL; par->chan[p][q].n = par->chan[p][q].max = 0; }
+  }
+
+  if (pthread_barrier_init(&par->barrier, NULL, P))
+    handle_error("(pthread_barrier_init) new_SimuParallel");
+  return par;
+}
+
+static void free_SimuParallel(struct SimuParallel *par)
+{
+  for (int p=0; p<par->P; p++)
+  {
+    free_partition(par->part[p]);
+    for (int q=0; q<par->P; q++) free(par->chan[p][q].msg);
+    free(par->chan[p]);
+    free(par->shadowed[p]);
+  }
+  for (int v=0; v<par->n; v++) free(par->shadow_W[v]);
+  pthread_barrier_destroy(&par->barrier);
+  free(par->owner); free(par->part); free(par->rng); free(par->chan);
+  free(par->next_T); free(par->n_events);
+  free(par->shadow_node); free(par->shadow_W);
+  free(par->shadowed); free(par->n_shadowed);
+  return free(par);
+}
+
+/* *********************** CANAUX ET IMAGES *********************** */
+
+void send_packet(struct SimulatedNetwork *snet, int v, double T,
+                 struct Packet packet)
+/* Envoie à la partition de v le paquet qui y entrera à l'instant T */
+{
+  struct Channel *chan = &snet->par->chan[snet->part][snet->par->owner[v]];
+  if (chan->n >= chan->max)
+  {
+    chan->max = (chan->max) ? 2 * chan->max : EVENT_QUEUE_SIZE;
+    chan->msg = realloc(chan->msg, chan->max * sizeof(struct SimuMessage));
+    if (chan->msg == NULL) handle_error("(realloc) send_packet");
+  }
+  chan->msg[chan->n].T = T;
+  chan->msg[chan->n].v = v;
+  chan->msg[chan->n].packet = packet;
+  chan->n ++;
+  return ;
+}
+
+static void receive_all(struct SimulatedNetwork *part)
+/* Vide les canaux arrivant à la partition, dans l'ordre des partitions */
+{
+  struct SimuParallel *par = part->par;
+  for (int p=0; p<par->P; p++)
+  {
+    struct Channel *chan = &par->chan[p][part->part];
+    for (int i=0; i<chan->n; i++)
+      receive_packet(part, chan->msg[i].v, chan->msg[i].T, chan->msg[i].packet);
+    chan->n = 0;
+  }
+  return ;
+}
+
+static void take_shadows(struct SimulatedNetwork *part)
+/* Image des nœuds de la partition vus par les autres */
+{
+  struct SimuParallel *par = part->par;
+  for (int j=0; j<par->n_shadowed[part->part]; j++)
+  {
+    int v = par->shadowed[part->part][j];
+    struct SimulatedPlayer *player = &part->vertex[v];
+    par->shadow_node[v] = part->node[v];
+    for (int i=0; i<player->n_dests; i++)
+      par->shadow_W[v][i] = player->table[i * ROUTE_STRIDE(player->d)];
+  }
+  return ;
+}
+
+struct SimulatedNode *seen_node(struct SimulatedNetwork *snet, int v)
+{
+  if (snet->par == NULL || snet->par->owner[v] == snet->part)
+    return &snet->node[v];
+  return &snet->par->shadow_node[v];
+}
+
+double *seen_W_u(struct SimulatedNetwork *snet, int v, int a)
+{
+  if (snet->par == NULL || snet->par->owner[v] == snet->part)
+    return route_W_u(snet->vertex, v, a);
+  int i = snet->vertex[v].slot[a];
+  return (i < 0) ? NULL : &snet->par->shadow_W[v][i];
+}
+
+/* *********************** SIMULATION *********************** */
+
+static double next_time(struct SimulatedNetwork *part)
+/* Instant du prochain événement de la partition, INFINITY s'il n'y en a pas
+ * (les files n'ont pas de consultation sans extraction) */
+{
+  struct Event event;
+  if (!next_event(&event, part->qevents)) return INFINITY;
+  add_Event(event, &part->qevents);
+  return event.T;
+}
+
+static void treat_window(struct SimulatedNetwork *part, double end,
+                         long long *n_events)
+/* Traite les événements antérieurs à end */
+{
+  struct Event event;
+  while (next_event(&event, part->qevents))
+  {
+    if (event.T >= end) { add_Event(event, &part->qevents); return ; }
+    treat_event(part, event);
+    (*n_events) ++;
+  }
+  return ;
+}
+
+static void *partition_thread(void *arg)
+{
+  struct SimulatedNetwork *part = arg;
+  struct SimuParallel *par = part->par;
+  int p = part->part;
+  long long n_events = 0;
+
+  while (1)
+  {
+    /* Entre deux fenêtres : réception, images, prochain instant */
+    receive_all(part);
+    take_shadows(part);
+    par->next_T[p] = next_time(part);
+    par->n_events[p] = n_events;
+    pthread_barrier_wait(&par->barrier);
+
+    /* Même décision dans tous les threads */
+    double start = INFINITY;
+    long long total = 0;
+    for (int q=0; q<par->P; q++)
+    {
+      if (par->next_T[q] < start) start = par->next_T[q];
+      total += par->n_events[q];
+    }
+    if (total >= par->max_events || start == INFINITY) break;
+
+    treat_window(part, start + par->window, &n_events);
+    pthread_barrier_wait(&par->barrier);
+  }
+
+  return NULL;
+}
+
+long long simulate_parallel(struct SimulatedNetwork *snet, int P, int merged,
+                            long long max_events)
+{
+  if (snet->delay <= 0)
+  { fprintf(stderr, "Parallel simulation needs a positive link delay\n");
+    return 0; }
+  if (P > snet->n) P = snet->n;
+
+  struct SimuParallel *par = new_SimuParallel(snet, P, max_events);
+  for (int p=0; p<P; p++)
+  {
+    struct SimulatedNetwork *part = par->part[p];
+    init_arrivals(part, merged);
+    for (int u=0; u<snet->n; u++) if (par->owner[u] == p)
+      add_Event(new_Event(0, u, UPDATE_DISTRIB, u), &part->qevents);
+  }
+
+  pthread_t *threads = malloc(P * sizeof(pthread_t));
+  if (threads == NULL) handle_error("(malloc) simulate_parallel");
+  for (int p=0; p<P; p++)
+    if (pthread_create(&threads[p], NULL, partition_thread, par->part[p]))
+      handle_error("(pthread_create) simulate_parallel");
+  for (int p=0; p<P; p++) pthread_join(threads[p], NULL);
+  free(threads);
+
+  /* Fin : statistiques des partitions, dans l'ordre */
+  long long total = 0;
+  double now = -INFINITY;
+  for (int p=0; p<P; p++)
+  {
+    total += par->n_events[p];
+    if (par->part[p]->stats != NULL && par->part[p]->stats->now > now)
+      now = par->part[p]->stats->now;
+  }
+  if (snet->stats != NULL)
+  {
+    reset_SimuStats(snet->stats, 0);
+    for (int p=0; p<P; p++)
+    {
+      struct SimuStats *stats = par->part[p]->stats;
+      /* Partition restée avant la fin de la chauffe */
+      if (stats->start < snet->warmup && now >= snet->warmup)
+        reset_SimuStats(stats, snet->warmup);
+      merge_SimuStats(snet->stats, stats);
+    }
+  }
+
+  free_SimuParallel(par);
+  return total;
+}
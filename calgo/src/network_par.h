@@ -0,0 +1,91 @@
+#ifndef network_par_h
+#define network_par_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "network_simu.h"
+
+/* On définit ici la simulation parallèle (conservative) des files d'attente.
+ * Les nœuds sont répartis en P blocs contigus d'indices (le graphe est un
+ * DAG numéroté dans l'ordre topologique : les paquets vont surtout d'un bloc
+ * vers le suivant), un thread par bloc, chacun avec sa propre file
+ * d'événements, ses paquets et son flux aléatoire.
+ *
+ * Synchronisation à la YAWNS : tous les threads traitent leurs événements
+ * de la même fenêtre [t, t + delay[, où t est le plus petit instant en
+ * attente et delay le délai des liens (le lookahead). Un paquet qui change
+ * de partition n'entre dans son nœud que delay plus tard, donc dans une
+ * fenêtre suivante : il part dans un canal, vidé par son destinataire entre
+ * deux fenêtres. Une mise à jour de distribution lit l'état d'un voisin
+ * d'une autre partition tel qu'il était au début de la fenêtre.
+ *
+ * Les canaux sont vidés dans l'ordre des partitions et chaque thread a son
+ * flux aléatoire : pour une graine et un nombre de partitions donnés, la
+ * simulation ne dépend pas de l'ordonnancement des threads. */
+
+struct SimuMessage /* Paquet passant d'une partition à une autre */
+{
+  double T; /* Instant d'entrée dans v */
+  int v;
+  struct Packet packet;
+};
+
+struct Channel
+/* Canal de p vers q : écrit par p seul pendant une fenêtre, vidé par q seul
+ * entre deux fenêtres (les barrières séparent les deux) */
+{
+  struct SimuMessage *msg;
+  int n, max;
+};
+
+struct SimuParallel
+{
+  int P;         /* Nombre de partitions (et de threads) */
+  int n;         /* Taille du graphe */
+  double window; /* Largeur des fenêtres : le délai des liens */
+  int *owner;    /* owner[u] : partition du nœud u */
+
+  struct SimulatedNetwork **part; /* part[p] : la partition p */
+  unsigned short (*rng)[3];       /* rng[p] : son flux aléatoire */
+  struct Channel **chan;          /* chan[p][q] : de p vers q */
+
+  /* Image, au début de la fenêtre, des nœuds ayant un prédécesseur dans
+   * une autre partition (NULL pour les autres) : partie chaude et W_u de
+   * chaque case de la table */
+  struct SimulatedNode *shadow_node;
+  double **shadow_W;
+  int **shadowed;  /* shadowed[p] : ceux de ces nœuds qui sont dans p */
+  int *n_shadowed;
+
+  /* Écrits par chaque partition entre les deux barrières */
+  double *next_T;         /* Prochain événement en attente */
+  long long *n_events;    /* Événements traités depuis le début */
+  long long max_events;
+
+  pthread_barrier_t barrier;
+};
+
+/* *********************** SIMULATION *********************** */
+
+long long simulate_parallel(struct SimulatedNetwork *snet, int P, int merged,
+                            long long max_events);
+/* Simule sur P threads, avec les arrivées de init_arrivals(merged), jusqu'à
+ * la fin de la fenêtre où max_events événements ont été traités. Il faut
+ * init_destinations et snet->delay > 0. Les statistiques de snet (s'il en
+ * a) reçoivent celles des partitions. Pas de trace. Renvoie le nombre
+ * d'événements traités. */
+
+void send_packet(struct SimulatedNetwork *snet, int v, double T,
+                 struct Packet packet);
+/* Envoie à la partition de v le paquet qui y entrera à l'instant T */
+
+/* *********************** LECTURE DES VOISINS *********************** */
+
+struct SimulatedNode *seen_node(struct SimulatedNetwork *snet, int v);
+/* Le nœud v tel que le voit la partition de snet : lui-même s'il est dans
+ * cette partition (ou en séquentiel), son image sinon */
+double *seen_W_u(struct SimulatedNetwork *snet, int v, int a);
+/* Idem pour route_W_u(snet->vertex, v, a) */
+
+#endif
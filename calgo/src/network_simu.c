@@ -1,4 +1,5 @@
 #include "network_simu.h"
+#include "network_par.h"
 
 
 /* *********************** ADMINISTRATION *********************** */
@@ -6,7 +7,8 @@
 struct SimulatedPlayer *new_SimulatedPlayers(struct graph *g)
 {
   int n = g->n;
-  struct SimulatedPlayer *vertex = malloc(n * sizeof(struct SimulatedPlayer));
+  struct SimulatedPlayer *vertex = mem_malloc(MEM_ROUTING,
+                                              n * sizeof(struct SimulatedPlayer));
   if (vertex == NULL) { fprintf(stderr, "(malloc) new_SimulatedPlayers\n");
                         exit(EXIT_FAILURE); }
 
@@ -14,7 +16,7 @@ struct SimulatedPlayer *new_SimulatedPlayers(struct graph *g)
   {
     vertex[u].d = 0; /* Calcul du degré et des voisins */
     for (int v=0; v<n; v++) vertex[u].d += g->network[u][v];
-    vertex[u].neighbours = malloc(vertex[u].d * sizeof(int));
+    vertex[u].neighbours = mem_malloc(MEM_ROUTING, vertex[u].d * sizeof(int));
     if (vertex[u].neighbours == NULL) { fprintf(stderr,
                                         "(malloc) new_SimulatedPlayers\n");
                                         exit(EXIT_FAILURE); }
@@ -23,30 +25,18 @@ struct SimulatedPlayer *new_SimulatedPlayers(struct graph *g)
     for (int v=0; v<n; v++) if (g->network[u][v])
       vertex[u].neighbours[k++] = v;
 
-    vertex[u].own_c_uv = 0;
-    vertex[u].own_c_uv_count = 0;
+    vertex[u].Y_uv = mem_calloc(MEM_ROUTING, vertex[u].d, sizeof(double));
+    /* Table de routage : voir init_destinations */
+    vertex[u].n_dests = 0;
+    vertex[u].dests = NULL; vertex[u].slot = NULL; vertex[u].table = NULL;
+    vertex[u].own_slot = -1;
 
-    vertex[u].W_u  = calloc(n, sizeof(double));
-    vertex[u].Y_uv = calloc(vertex[u].d, sizeof(double));
-    vertex[u].W_uv = calloc(n, sizeof(double*));
-    vertex[u].X_uv = calloc(n, sizeof(double*));
-
-    if (vertex[u].W_u == NULL || vertex[u].Y_uv == NULL
-        || vertex[u].W_uv == NULL || vertex[u].X_uv == NULL)
+    if (vertex[u].Y_uv == NULL && vertex[u].d)
     {
       fprintf(stderr, "(malloc) new_SimulatedPlayers\n");
       exit(EXIT_FAILURE);
     }
 
-    for (int t=0; t<n; t++)
-    {
-      vertex[u].W_uv[t] = calloc(vertex[u].d, sizeof(double));
-      vertex[u].X_uv[t] = calloc(vertex[u].d, sizeof(double));
-      if (vertex[u].W_uv[t] == NULL || vertex[u].X_uv[t] == NULL)
-      { fprintf(stderr, "(malloc) new_SimulatedPlayers\n"); exit(EXIT_FAILURE);}
-    }
-
-    vertex[u].n = 0;
     vertex[u].nIter = 1;
   }
 
@@ -58,18 +48,16 @@ void free_SimulatedPlayers(struct SimulatedPlayer *vertex, int n)
 {
   for (int u=0; u<n; u++)
   {
-    free(vertex[u].neighbours);
-    free(vertex[u].W_u);
-    free(vertex[u].Y_uv);
-    for (int t=0; t<n; t++) free(vertex[u].W_uv[t]);
-    for (int t=0; t<n; t++) free(vertex[u].X_uv[t]);
-    free(vertex[u].W_uv);
-    free(vertex[u].X_uv);
+    mem_free(MEM_ROUTING, vertex[u].neighbours);
+    mem_free(MEM_ROUTING, vertex[u].Y_uv);
+    mem_free(MEM_ROUTING, vertex[u].dests);
+    mem_free(MEM_ROUTING, vertex[u].table);
   }
-  return free(vertex);
+  return mem_free(MEM_ROUTING, vertex);
 }
 
-struct SimulatedNetwork *new_SimulatedNetwork(struct graph *g, double E)
+struct SimulatedNetwork *new_SimulatedNetwork(struct graph *g, double E,
+                                             int queue_kind)
 {
   struct SimulatedNetwork *snet = malloc(sizeof(struct SimulatedNetwork));
   if (snet == NULL) { fprintf(stderr, "new_SimulatedNetwork\n");
@@ -86,14 +74,39 @@ struct SimulatedNetwork *new_SimulatedNetwork(struct graph *g, double E)
   }
 
   snet->E = E; snet->n = g->n;
-  snet->qevents = new_EventQueue(1<<20);
+  snet->n_dests = 0;
+  snet->dests = malloc(g->n * sizeof(int));
+  snet->dest_index = malloc(g->n * sizeof(int));
+  if (snet->dests == NULL || snet->dest_index == NULL)
+  { fprintf(stderr, "new_SimulatedNetwork\n"); exit(EXIT_FAILURE); }
+  if ((uint32_t) g->n > EVENT_MAX_NODE)
+  { fprintf(stderr, "new_SimulatedNetwork : too many nodes\n"); exit(EXIT_FAILURE); }
+  snet->qevents = new_EventQueue_kind(queue_kind, EVENT_QUEUE_SIZE);
   snet->vertex  = new_SimulatedPlayers(g);
 
-  snet->L = calloc(g->n, sizeof(double));
-  snet->T = calloc(g->n, sizeof(double));
-
-  if (snet->L == NULL || snet->T == NULL)
+  if (mem_posix_memalign(MEM_ROUTING, (void**) &snet->node, CACHE_LINE,
+                         g->n * sizeof(struct SimulatedNode)))
   { fprintf(stderr, "new_SimulatedNetwork\n"); exit(EXIT_FAILURE); }
+  for (int u=0; u<g->n; u++)
+  {
+    snet->node[u].L = snet->node[u].T = 0;
+    snet->node[u].mu = 1;
+    snet->node[u].c_uv = 0; snet->node[u].c_uv_count = 0;
+    snet->node[u].d = snet->vertex[u].d;
+    snet->node[u].n = 0;
+    snet->node[u].neighbours = snet->vertex[u].neighbours;
+    snet->node[u].table = NULL; /* Voir init_destinations */
+  }
+
+  snet->packets = NULL; snet->free_packets = NULL;
+  snet->n_free_packets = snet->n_packets = snet->max_packets = 0;
+  snet->trace = NULL;
+  snet->stats = NULL; snet->warmup = 0;
+  snet->flows = NULL; snet->flow_source = snet->flow_sink = NULL;
+  snet->rate = 0;
+  snet->delay = 0;
+  snet->rng = NULL;
+  snet->par = NULL; snet->part = 0;
 
   return snet;
 }
@@ -102,14 +115,309 @@ void free_SimulatedNetwork(struct SimulatedNetwork *snet)
 {
   for (int s=0; s<snet->n; s++) free(snet->lambda[s]);
   free(snet->lambda);
+  free(snet->dests);
+  free(snet->dest_index);
+  free_Trace(snet->trace);
   free_EventQueue(snet->qevents);
   free_SimulatedPlayers(snet->vertex, snet->n);
-  free(snet->L);
-  free(snet->T);
+  mem_free(MEM_ROUTING, snet->node);
+  mem_free(MEM_PACKETS, snet->packets);
+  mem_free(MEM_PACKETS, snet->free_packets);
+  free_AliasTable(snet->flows);
+  free(snet->flow_source);
+  free(snet->flow_sink);
 
   return free(snet);
 }
 
+double SimulatedNetwork_size(struct graph *g, int *dests, int n_dests)
+/* Octets des nœuds et des tables de routage d'une simulation vers les
+ * destinations dests[0 .. n_dests-1], une fois init_destinations faite */
+{
+  int n = g->n;
+  int *d = calloc(n, sizeof(int)), *reached = calloc(n, sizeof(int));
+  int *reaches = malloc(n * sizeof(int)), *stack = malloc(n * sizeof(int));
+  if (d == NULL || reached == NULL || reaches == NULL || stack == NULL)
+  { fprintf(stderr, "SimulatedNetwork_size\n"); exit(EXIT_FAILURE); }
+
+  for (int u=0; u<n; u++) for (int v=0; v<n; v++) d[u] += g->network[u][v];
+
+  /* Destinations atteintes par chaque nœud, comme dans init_destinations */
+  for (int a=0; a<n_dests; a++)
+  {
+    for (int u=0; u<n; u++) reaches[u] = 0;
+    int top = 0;
+    reaches[dests[a]] = 1; stack[top++] = dests[a];
+    while (top)
+    {
+      int v = stack[--top];
+      for (int u=0; u<n; u++) if (g->network[u][v] && !reaches[u])
+      { reaches[u] = 1; stack[top++] = u; }
+    }
+    for (int u=0; u<n; u++) reached[u] += reaches[u];
+  }
+
+  double size = (double) n * (sizeof(struct SimulatedPlayer)
+                              + sizeof(struct SimulatedNode));
+  for (int u=0; u<n; u++)
+    size += (d[u] + 2. * n_dests) * sizeof(int) + d[u] * sizeof(double)
+            + (double) reached[u] * ROUTE_STRIDE(d[u]) * sizeof(double);
+
+  free(d); free(reached); free(reaches); free(stack);
+  return size;
+}
+
+void init_destinations(struct SimulatedNetwork *snet, struct graph *g)
+{
+  int n = snet->n;
+  struct SimulatedPlayer *vertex = snet->vertex;
+  int *reaches = malloc(n * sizeof(int)), *stack = malloc(n * sizeof(int));
+  if (reaches == NULL || stack == NULL)
+  { fprintf(stderr, "init_destinations\n"); exit(EXIT_FAILURE); }
+
+  for (int t=0; t<n; t++)
+  {
+    snet->dest_index[t] = -1;
+    for (int s=0; s<n; s++) if (snet->lambda[s][t] > 0)
+    { snet->dest_index[t] = snet->n_dests; snet->dests[snet->n_dests++] = t;
+      break; }
+  }
+
+  for (int u=0; u<n; u++)
+  { /* slot à la suite des voisins, pour qu'un paquet n'ait qu'un bloc à lire */
+    int d = vertex[u].d;
+    vertex[u].neighbours = mem_realloc(MEM_ROUTING, vertex[u].neighbours,
+                                       (d + snet->n_dests) * sizeof(int));
+    vertex[u].dests = mem_malloc(MEM_ROUTING, snet->n_dests * sizeof(int));
+    if ((vertex[u].neighbours == NULL && d + snet->n_dests)
+        || (vertex[u].dests == NULL && snet->n_dests))
+    { fprintf(stderr, "init_destinations\n"); exit(EXIT_FAILURE); }
+    vertex[u].slot = vertex[u].neighbours + d;
+    snet->node[u].neighbours = vertex[u].neighbours;
+  }
+
+  /* Cases des tables : destinations dans l'ordre, pour chaque nœud */
+  for (int a=0; a<snet->n_dests; a++)
+  {
+    int t = snet->dests[a];
+
+    /* Parcours à rebours depuis t */
+    for (int u=0; u<n; u++) reaches[u] = 0;
+    int top = 0;
+    reaches[t] = 1; stack[top++] = t;
+    while (top)
+    {
+      int v = stack[--top];
+      for (int u=0; u<n; u++) if (g->network[u][v] && !reaches[u])
+      { reaches[u] = 1; stack[top++] = u; }
+    }
+
+    for (int u=0; u<n; u++)
+    {
+      vertex[u].slot[a] = (reaches[u]) ? vertex[u].n_dests : -1;
+      if (reaches[u]) vertex[u].dests[vertex[u].n_dests++] = a;
+    }
+    vertex[t].own_slot = vertex[t].slot[a];
+  }
+
+  /* Un bloc par nœud : W_u^{(t)} = 0, W_uv^{(t)} = X_uv^{(t)} = 0 */
+  for (int u=0; u<n; u++)
+  {
+    int size = vertex[u].n_dests * ROUTE_STRIDE(vertex[u].d);
+    vertex[u].table = mem_calloc(MEM_ROUTING, size, sizeof(double));
+    if (vertex[u].table == NULL && size)
+    { fprintf(stderr, "init_destinations\n"); exit(EXIT_FAILURE); }
+    snet->node[u].table = vertex[u].table;
+  }
+
+  free(reaches); free(stack);
+  return ;
+}
+
+/* *********************** PERTURBATIONS *********************** */
+
+static void drop_route_case(struct SimulatedNetwork *snet, int w, int i)
+/* Retire la case i de la table du nœud w : sa destination est hors
+ * d'atteinte */
+{
+  struct SimulatedPlayer *vertex = snet->vertex;
+  int stride = ROUTE_STRIDE(vertex[w].d), after = vertex[w].n_dests - i - 1;
+  memmove(vertex[w].table + i * stride, vertex[w].table + (i + 1) * stride,
+          after * stride * sizeof(double));
+  memmove(vertex[w].dests + i, vertex[w].dests + i + 1, after * sizeof(int));
+  vertex[w].n_dests --;
+
+  for (int a=0; a<snet->n_dests; a++)
+  {
+    if (vertex[w].slot[a] == i) vertex[w].slot[a] = -1;
+    else if (vertex[w].slot[a] > i) vertex[w].slot[a] --;
+  }
+  if (vertex[w].own_slot > i) vertex[w].own_slot --;
+  return ;
+}
+
+static void route_case_update(double *W_u, int d)
+/* Refait W_u et X_uv d'une case d'après ses W_uv */
+{
+  double *W_uv = W_u + 1, *X_uv = W_u + 1 + d;
+  double W_max = (d) ? max(W_uv, d) : -INFINITY;
+  if (W_max == -INFINITY) { *W_u = -INFINITY; return ; }
+
+  *W_u = 0;
+  for (int k=0; k<d; k++) *W_u += exp(W_uv[k] - W_max);
+  *W_u = W_max + log(*W_u);
+  pos_balanced_logit(X_uv, W_uv, 0, d);
+  return ;
+}
+
+void remove_edge_SimulatedNetwork(struct SimulatedNetwork *snet, int u, int v)
+{
+  struct SimulatedPlayer *vertex = snet->vertex;
+  int d = vertex[u].d, j = -1;
+  for (int k=0; k<d; k++) if (vertex[u].neighbours[k] == v) j = k;
+  if (j < 0) return ;
+
+  /* Voisins puis slot, qui restent d'un seul bloc */
+  memmove(vertex[u].neighbours + j, vertex[u].neighbours + j + 1,
+          (d - j - 1 + snet->n_dests) * sizeof(int));
+  vertex[u].slot = vertex[u].neighbours + d - 1;
+  memmove(vertex[u].Y_uv + j, vertex[u].Y_uv + j + 1,
+          (d - j - 1) * sizeof(double));
+
+  /* Table au nouveau pas, sur place : chaque case se resserre vers le
+   * début, on ne lit jamais ce qui a déjà été écrit */
+  int old = ROUTE_STRIDE(d), new = ROUTE_STRIDE(d - 1);
+  for (int i=0; i<vertex[u].n_dests; i++)
+  {
+    double *from = vertex[u].table + i * old, *to = vertex[u].table + i * new;
+    to[0] = from[0];
+    for (int k=0, l=0; k<d; k++) if (k != j) to[1 + l++] = from[1 + k];
+    for (int k=0, l=0; k<d; k++) if (k != j) to[d + l++] = from[1 + d + k];
+    if (i != vertex[u].own_slot && to[0] != -INFINITY)
+      route_case_update(to, d - 1);
+  }
+  vertex[u].d --;
+  snet->node[u].d = vertex[u].d;
+
+  /* Destinations que u atteignait : seuls u et ses prédécesseurs peuvent
+   * les avoir perdues, les tables des autres sont à jour */
+  int *reaches = malloc(snet->n * sizeof(int));
+  if (reaches == NULL)
+  { fprintf(stderr, "remove_edge_SimulatedNetwork\n"); exit(EXIT_FAILURE); }
+  for (int a=0; a<snet->n_dests; a++) if (vertex[u].slot[a] >= 0)
+  {
+    int t = snet->dests[a];
+    for (int w=u+1; w<snet->n; w++) reaches[w] = (vertex[w].slot[a] >= 0);
+    for (int w=u; w>=0; w--) /* Ordre topologique inverse */
+    {
+      reaches[w] = (w == t);
+      for (int k=0; k<vertex[w].d && !reaches[w]; k++)
+        reaches[w] = reaches[vertex[w].neighbours[k]];
+      if (!reaches[w] && vertex[w].slot[a] >= 0)
+        drop_route_case(snet, w, vertex[w].slot[a]);
+    }
+  }
+  free(reaches);
+  return ;
+}
+
+void set_flow_rate(struct SimulatedNetwork *snet, int s, int t, double rate)
+{
+  snet->lambda[s][t] = rate;
+  if (snet->flows == NULL) return ; /* NEW_PAQUET relit lambda */
+
+  /* Arrivées fusionnées : mêmes flux, dans l'ordre d'init_arrivals */
+  int k = 0;
+  for (int x=0; x<snet->n; x++) for (int y=0; y<snet->n; y++)
+    if (snet->lambda[x][y] > 0) k++;
+  double *rates = malloc(k * sizeof(double));
+  if (rates == NULL) { fprintf(stderr, "set_flow_rate\n"); exit(EXIT_FAILURE); }
+
+  k = 0; snet->rate = 0;
+  for (int x=0; x<snet->n; x++) for (int y=0; y<snet->n; y++)
+  if (snet->lambda[x][y] > 0)
+  {
+    rates[k] = snet->lambda[x][y];
+    snet->rate += rates[k++];
+  }
+  free_AliasTable(snet->flows);
+  snet->flows = new_AliasTable(rates, k);
+  free(rates);
+  return ;
+}
+
+/* *********************** TABLES DE ROUTAGE *********************** */
+
+double *route_W_u(struct SimulatedPlayer *vertex, int u, int a)
+{
+  int i = vertex[u].slot[a];
+  return (i < 0) ? NULL : vertex[u].table + i * ROUTE_STRIDE(vertex[u].d);
+}
+
+double *route_W_uv(struct SimulatedPlayer *vertex, int u, int a)
+{
+  double *W_u = route_W_u(vertex, u, a);
+  return (W_u == NULL) ? NULL : W_u + 1;
+}
+
+double *route_X_uv(struct SimulatedPlayer *vertex, int u, int a)
+{
+  double *W_u = route_W_u(vertex, u, a);
+  return (W_u == NULL) ? NULL : W_u + 1 + vertex[u].d;
+}
+
+static double *node_W_u(struct SimulatedNode *node, int a)
+/* route_W_u, lu depuis la partie chaude */
+{
+  int i = node->neighbours[node->d + a];
+  return (i < 0) ? NULL : node->table + i * ROUTE_STRIDE(node->d);
+}
+
+static uint32_t new_packet(struct SimulatedNetwork *snet, double T, int source,
+                           int sink)
+/* Range l'origine d'un nouveau paquet et renvoie son identifiant */
+{
+  uint32_t id;
+  if (snet->n_free_packets) id = snet->free_packets[--snet->n_free_packets];
+  else
+  {
+    if (snet->n_packets >= snet->max_packets)
+    {
+      snet->max_packets = (snet->max_packets) ? 2 * snet->max_packets
+                                              : EVENT_QUEUE_SIZE;
+      snet->packets = mem_realloc(MEM_PACKETS, snet->packets,
+                                  snet->max_packets * sizeof(struct Packet));
+      snet->free_packets = mem_realloc(MEM_PACKETS, snet->free_packets,
+                                       snet->max_packets * sizeof(uint32_t));
+      if (snet->packets == NULL || snet->free_packets == NULL)
+      { fprintf(stderr, "new_packet\n"); exit(EXIT_FAILURE); }
+    }
+    id = snet->n_packets++;
+  }
+
+  snet->packets[id].T = T;
+  snet->packets[id].source = source;
+  snet->packets[id].sink   = sink;
+  snet->packets[id].hops   = 0;
+  return id;
+}
+
+static void free_packet(struct SimulatedNetwork *snet, uint32_t id, double T,
+                        int outcome)
+/* Le paquet est sorti du réseau à l'instant T (TRACE_DELIVERED ou
+ * TRACE_LOST) */
+{
+  struct Packet *packet = &snet->packets[id];
+  if (snet->trace != NULL)
+    trace_packet(snet->trace, T, T - packet->T, packet->source, packet->sink,
+                 packet->hops, outcome);
+  if (snet->stats != NULL)
+    stats_packet(snet->stats, packet->source, packet->sink, T, T - packet->T,
+                 outcome == TRACE_DELIVERED);
+  snet->free_packets[snet->n_free_packets++] = id;
+  return ;
+}
+
 /* *********************** UTILITAIRE *********************** */
 
 static double gamma_simu(int n)
@@ -123,60 +431,61 @@ double positive_part(double x)
   return (x > 0) ? x : 0;
 }
 
-void reset_c_uv(struct SimulatedPlayer *vertex, int u)
+void reset_c_uv(struct SimulatedNode *node, int u)
 /* Remet les c_uv et count_uv à 0 pour le sommet u*/
 {
-  vertex[u].own_c_uv = 0;
-  vertex[u].own_c_uv_count = 0;
+  node[u].c_uv = 0;
+  node[u].c_uv_count = 0;
 
   return;
 }
 
-void update_distrib_SimulatedPlayer(struct SimulatedPlayer *vertex, int u, int n,
-                                    int nPlayers)
-/* Remet à jour la distribution du joueur k, selon une itération n */
+void update_distrib_SimulatedPlayer(struct SimulatedNetwork *snet, int u, int n)
+/* Remet à jour la distribution du joueur u, selon une itération n, pour
+ * ses destinations actives */
 {
   //fprintf(stderr, "################# UPDATES %d\n", u);
+  struct SimulatedPlayer *vertex = snet->vertex;
   int d = vertex[u].d;
   for (int k=0; k<d; k++)
   {
-    int v = vertex[u].neighbours[k];
-    double c_uv = vertex[v].own_c_uv;
-    double c_uv_count = vertex[v].own_c_uv_count;
-    vertex[u].Y_uv[k] += gamma_simu(n) * (c_uv + vertex[v].mu) / (c_uv_count + 1);
+    struct SimulatedNode *v = seen_node(snet, vertex[u].neighbours[k]);
+    vertex[u].Y_uv[k] += gamma_simu(n) * (v->c_uv + v->mu) / (v->c_uv_count + 1);
   }
 
-  for (int t=0; t<nPlayers; t++) for (int k=0; k<d; k++)
+  /* Case par case de la table de routage : W_u[t], W_uv[t] et X_uv[t] */
+  for (int i=0; i<vertex[u].n_dests; i++)
   {
-    int v = vertex[u].neighbours[k];
-    vertex[u].W_uv[t][k]  = vertex[v].W_u[t] - vertex[u].Y_uv[k];
-  }
+    int a = vertex[u].dests[i];
+    double *W_u  = vertex[u].table + i * ROUTE_STRIDE(d);
+    double *W_uv = W_u + 1, *X_uv = W_u + 1 + d;
+
+    if (*W_u == -INFINITY) continue;
+    if (i == vertex[u].own_slot) { *W_u = 0; continue; }
 
-  /* Recalcul de W_u[t] et X_uv[t] */
-  for (int t=0; t<nPlayers; t++)
-  {
-    if (vertex[u].W_u[t] == -INFINITY) continue;
-    if (u == t) { vertex[u].W_u[t] = 0; continue; }
     int need_update = 0;
-    for (int i=0; i<vertex[u].d; i++) if (vertex[u].W_uv[t][i] != -INFINITY)
-      need_update = 1;
+    for (int k=0; k<d; k++)
+    {
+      double *W_v = seen_W_u(snet, vertex[u].neighbours[k], a);
+      W_uv[k] = (W_v == NULL) ? -INFINITY : *W_v - vertex[u].Y_uv[k];
+      if (W_uv[k] != -INFINITY) need_update = 1;
+    }
     if (!need_update)
     {
       //printf(" · set %d to -INFINITY\n", t);
-      vertex[u].W_u[t] = -INFINITY;
+      *W_u = -INFINITY;
       continue;
     }
     /* Calcul de W_u[t] */
-    double W_max = max(vertex[u].W_uv[t], d);
-    vertex[u].W_u[t] = 0;
-    for (int i=0; i<d; i++) vertex[u].W_u[t] += exp(vertex[u].W_uv[t][i] - W_max);
+    double W_max = max(W_uv, d);
+    *W_u = 0;
+    for (int k=0; k<d; k++) *W_u += exp(W_uv[k] - W_max);
 
-    vertex[u].W_u[t] = W_max + log(vertex[u].W_u[t]);
+    *W_u = W_max + log(*W_u);
 
     /* Calcul de X_uv[t] */
-    pos_balanced_logit(vertex[u].X_uv[t], vertex[u].W_uv[t], 0, d);
-    //printf(" · (%lf) %d --> %d : ", vertex[u].W_u[t], u, t);
-    //print_distrib(vertex[u].X_uv[t], d);
+    pos_balanced_logit(X_uv, W_uv, 0, d);
+    //print_distrib(X_uv, d);
   }
 
   return ;
@@ -184,136 +493,274 @@ void update_distrib_SimulatedPlayer(struct SimulatedPlayer *vertex, int u, int n
 
 /* *********************** SIMULATION *********************** */
 
+static void load_node(struct SimulatedNetwork *snet, int v, double T)
+/* Un paquet arrive en v à l'instant T : il attend la charge restante puis
+ * est servi */
+{
+  struct SimulatedNode *node = &snet->node[v];
+  double delta = rand_exponential_r(node->mu, snet->rng);
+  double L_before = node->L, T_before = node->T;
+  node->L = delta + positive_part(L_before + T_before - T);
+  node->T = T;
 
-void event_NEW_PAQUET(struct SimulatedNetwork *snet, struct Event event)
+  if (snet->stats != NULL)
+    stats_node(snet->stats, v, T, L_before, T_before, node->L);
+
+  /* MàJ c_uv */
+  node->c_uv += node->L;
+  node->c_uv_count ++;
+  return ;
+}
+
+
+static void emit_packet(struct SimulatedNetwork *snet, int s, int t, double T)
+/* Le paquet (s, t) émis à l'instant T, déjà en attente en s, y sera traité
+ * après sa charge */
 {
-  int s = event.u;
-  int t = event.sink;
+  uint32_t packet = new_packet(snet, T, s, t);
+  add_Event(new_Event(T + snet->node[s].L, s, TREAT_PAQUET, packet),
+            &snet->qevents);
+  return ;
+}
+
+static int owns(struct SimulatedNetwork *snet, int u)
+/* Le nœud u est-il simulé par snet ? */
+{
+  return snet->par == NULL || snet->par->owner[u] == snet->part;
+}
+
+static void forward_packet(struct SimulatedNetwork *snet, int v, double T,
+                           uint32_t id)
+/* Le paquet id entrera en v à l'instant T */
+{
+  if (owns(snet, v))
+  {
+    add_Event(new_Event(T, v, ENTER_PAQUET, id), &snet->qevents);
+    return ;
+  }
+  /* Il quitte la partition : ni trace ni statistiques */
+  send_packet(snet, v, T, snet->packets[id]);
+  snet->free_packets[snet->n_free_packets++] = id;
+  return ;
+}
 
-  double delta = rand_exponential(snet->vertex[s].mu);
-  snet->L[s] = delta + positive_part(snet->L[s] + snet->T[s] - event.T);
-  snet->T[s] = event.T;
+void receive_packet(struct SimulatedNetwork *snet, int v, double T,
+                    struct Packet packet)
+{
+  uint32_t id = new_packet(snet, packet.T, packet.source, packet.sink);
+  snet->packets[id].hops = packet.hops;
+  add_Event(new_Event(T, v, ENTER_PAQUET, id), &snet->qevents);
+  return ;
+}
 
-  snet->vertex[s].own_c_uv += snet->L[s];
-  snet->vertex[s].own_c_uv_count ++;
+void init_arrivals(struct SimulatedNetwork *snet, int merged)
+{
+  if (!merged)
+  {
+    for (int s=0; s<snet->n; s++) if (owns(snet, s))
+      for (int t=0; t<snet->n; t++) if (snet->lambda[s][t] > 0)
+        add_Event(new_Event(0, s, NEW_PAQUET, t), &snet->qevents);
+    return ;
+  }
 
-  double next_T = event.T + rand_exponential(snet->lambda[s][t]);
-  struct EventID next_ID = new_EventID(next_T, s, t);
-  add_Event(new_Event(next_T, s, NEW_PAQUET, t, next_ID), &snet->qevents);
-  add_Event(new_Event(event.T + snet->L[s], s, TREAT_PAQUET, t, event.ID),
+  int k = 0;
+  for (int s=0; s<snet->n; s++) if (owns(snet, s))
+    for (int t=0; t<snet->n; t++) if (snet->lambda[s][t] > 0) k++;
+  if (!k) return ;
+
+  double *rates = malloc(k * sizeof(double));
+  snet->flow_source = malloc(k * sizeof(int));
+  snet->flow_sink   = malloc(k * sizeof(int));
+  if (rates == NULL || snet->flow_source == NULL || snet->flow_sink == NULL)
+  { fprintf(stderr, "init_arrivals\n"); exit(EXIT_FAILURE); }
+
+  k = 0; snet->rate = 0;
+  for (int s=0; s<snet->n; s++) if (owns(snet, s))
+  for (int t=0; t<snet->n; t++) if (snet->lambda[s][t] > 0)
+  {
+    rates[k] = snet->lambda[s][t];
+    snet->flow_source[k] = s; snet->flow_sink[k] = t;
+    snet->rate += rates[k++];
+  }
+  snet->flows = new_AliasTable(rates, k);
+  free(rates);
+
+  add_Event(new_Event(rand_exponential_r(snet->rate, snet->rng), 0, ARRIVAL, 0),
             &snet->qevents);
+  return ;
+}
+
+void event_ARRIVAL(struct SimulatedNetwork *snet, struct Event event)
+{
+  int f = select_on_alias_r(snet->flows, snet->rng);
+  int s = snet->flow_source[f], t = snet->flow_sink[f];
+
+  load_node(snet, s, event.T);
+
+  double next_T = event.T + rand_exponential_r(snet->rate, snet->rng);
+  add_Event(new_Event(next_T, 0, ARRIVAL, 0), &snet->qevents);
+  emit_packet(snet, s, t, event.T);
 
   return ;
 }
 
-void event_TREAT_PAQUET(struct SimulatedNetwork *snet, struct Event event)
+void event_NEW_PAQUET(struct SimulatedNetwork *snet, struct Event event)
 {
-  int u = event.u;
-  int t = event.sink;
-  int d = snet->vertex[u].d;
+  int s = event_u(event);
+  int t = event.arg;
+
+  load_node(snet, s, event.T);
 
-  snet->vertex[u].n ++;
+  double next_T = event.T + rand_exponential_r(snet->lambda[s][t], snet->rng);
+  add_Event(new_Event(next_T, s, NEW_PAQUET, t), &snet->qevents);
+  emit_packet(snet, s, t, event.T);
+
+  return ;
+}
+
+void event_TREAT_PAQUET(struct SimulatedNetwork *snet, struct Event event)
+{
+  int u = event_u(event);
+  struct SimulatedNode *node = &snet->node[u];
+  struct Packet packet = snet->packets[event.arg];
+  int t = packet.sink;
+  int d = node->d;
+  double *W_u  = node_W_u(node, snet->dest_index[t]);
+  double *X_uv = (W_u == NULL) ? NULL : W_u + 1 + d;
+
+  node->n ++;
   //fprintf(stderr, "@@@ %lf, %d\n", event.T, u);
 
   if (t == u) /* Le paquet est arrivé à Destination */
   {
     /*fprintf(stderr, "--------------- @%.2f Received (%d): %d %d, %lf\n",
-    event.T, u, event.ID.source, event.ID.sink, event.T - event.ID.T);*/
-    fprintf(stderr, "%lf %lf\n", event.T, event.T - event.ID.T);
-    snet->vertex[u].W_u[t] = 0;
+    event.T, u, packet.source, packet.sink, event.T - packet.T);*/
+    free_packet(snet, event.arg, event.T, TRACE_DELIVERED);
+    *W_u = 0;
     return;
   }
 
-  if (snet->vertex[u].d == 0)
-  {
+  if (d == 0 || X_uv == NULL)
+  { /* Cul-de-sac, ou t hors d'atteinte */
     /*fprintf(stderr, "--------------- @%.2f Lost     (%d): %d %d, %lf\n",
-    event.T, u, event.ID.source, event.ID.sink, event.T - event.ID.T);*/
-    fprintf(stderr, "%lf %lf\n", event.T, event.T - event.ID.T);
-    snet->vertex[u].W_u[t] = -INFINITY;
+    event.T, u, packet.source, packet.sink, event.T - packet.T);*/
+    free_packet(snet, event.arg, event.T, TRACE_LOST);
+    if (W_u != NULL) *W_u = -INFINITY;
     return ;
   }
 
   /* Sélection de la destination */
-  int k = select_on_distrib(snet->vertex[u].X_uv[t], d);
-  int v = snet->vertex[u].neighbours[k];
-  double delta = rand_exponential(snet->vertex[v].mu);
-  snet->L[v] = delta + positive_part(snet->L[v] + snet->T[v] - event.T);
-  snet->T[v] = event.T;
+  int k = select_on_distrib_r(X_uv, d, snet->rng);
+  int v = node->neighbours[k];
+  snet->packets[event.arg].hops ++;
+  if (snet->delay > 0)
+  {
+    forward_packet(snet, v, event.T + snet->delay, event.arg);
+    return ;
+  }
+  load_node(snet, v, event.T);
 
-  /* MàJ c_uv */
-  snet->vertex[v].own_c_uv += snet->L[v];
-  snet->vertex[v].own_c_uv_count ++;
+  double next_T = event.T + snet->node[v].L;
+  add_Event(new_Event(next_T, v, TREAT_PAQUET, event.arg), &snet->qevents);
 
-  double next_T = event.T + snet->L[v];
-  add_Event(new_Event(next_T, v, TREAT_PAQUET, t, event.ID), &snet->qevents);
+}
+
+void event_ENTER_PAQUET(struct SimulatedNetwork *snet, struct Event event)
+{
+  int v = event_u(event);
+  load_node(snet, v, event.T);
 
+  double next_T = event.T + snet->node[v].L;
+  add_Event(new_Event(next_T, v, TREAT_PAQUET, event.arg), &snet->qevents);
+  return ;
 }
 
 void event_UPDATE_DISTRIB(struct SimulatedNetwork *snet, struct Event event)
 {
-  int u = event.u;
-  int t = event.sink;
+  int u = event_u(event);
+  int t = event.arg;
 
   /* On met à jour la distribution de u */
-  update_distrib_SimulatedPlayer(snet->vertex, u, snet->vertex[u].nIter, snet->n);
-  reset_c_uv(snet->vertex, u); /* On reset ici... FIXME ?? */
+  update_distrib_SimulatedPlayer(snet, u, snet->vertex[u].nIter);
+  reset_c_uv(snet->node, u); /* On reset ici... FIXME ?? */
 
-  double next_T = event.T + snet->E + rand_exponential(snet->vertex[u].mu);
-  struct Event next_update = new_Event(next_T, u, UPDATE_DISTRIB, t, event.ID);
+  double next_T = event.T + snet->E + rand_exponential_r(snet->node[u].mu,
+                                                         snet->rng);
+  struct Event next_update = new_Event(next_T, u, UPDATE_DISTRIB, t);
   add_Event(next_update, &snet->qevents);
 
   snet->vertex[u].nIter ++;
   return;
 }
 
-void treat_new_event(struct SimulatedNetwork *snet)
+void treat_event(struct SimulatedNetwork *snet, struct Event event)
 {
-  struct Event event;
-  if (!next_event(&event, snet->qevents))
-  { fprintf(stderr, "No event ! \n"); exit(EXIT_FAILURE); }
-
   //printf("Extracting : "); print_Event(event);
 
-  if (event.action == NEW_PAQUET) event_NEW_PAQUET(snet, event);
-  else if (event.action == TREAT_PAQUET) event_TREAT_PAQUET(snet, event);
-  else if (event.action == UPDATE_DISTRIB) event_UPDATE_DISTRIB(snet, event);
+  /* Fin de la période de chauffe */
+  if (snet->stats != NULL && snet->stats->start < snet->warmup
+      && event.T >= snet->warmup)
+    reset_SimuStats(snet->stats, snet->warmup);
+
+  int action = event_action(event);
+  if (action == NEW_PAQUET) event_NEW_PAQUET(snet, event);
+  else if (action == TREAT_PAQUET) event_TREAT_PAQUET(snet, event);
+  else if (action == UPDATE_DISTRIB) event_UPDATE_DISTRIB(snet, event);
+  else if (action == ARRIVAL) event_ARRIVAL(snet, event);
+  else if (action == ENTER_PAQUET) event_ENTER_PAQUET(snet, event);
   else { fprintf(stderr, "Unexpected event\n"); exit(EXIT_FAILURE); }
 
   return;
 }
 
+void treat_new_event(struct SimulatedNetwork *snet)
+{
+  struct Event event;
+  if (!next_event(&event, snet->qevents))
+  { fprintf(stderr, "No event ! \n"); exit(EXIT_FAILURE); }
+
+  return treat_event(snet, event);
+}
+
 /* *********************** UTILITAIRE *********************** */
 
 void spread_Simulated_mass(struct SimulatedNetwork *snet, struct Network *net)
 /* Met la masse dans le network 'net' selon les distributions
  * des joueurs simulés. */
 {
-  /* local_mass[u][t] = masse partant de u en direction de t */
+  /* local_mass[u][a] = masse partant de u en direction de la a-ième
+   * destination active */
   double **local_mass = malloc(snet->n * sizeof(double*));
   if (local_mass == NULL) { fprintf(stderr, "(malloc) spread_Simulated_mass\n");
                             exit(EXIT_FAILURE); }
   for (int u=0; u<snet->n; u++)
   {
-    local_mass[u] = calloc(snet->n, sizeof(double));
-    if (local_mass[u] == NULL) { fprintf(stderr, "(malloc) spread_Simulated_mass\n");
-                                 exit(EXIT_FAILURE); }
+    local_mass[u] = calloc(snet->n_dests, sizeof(double));
+    if (local_mass[u] == NULL && snet->n_dests)
+    { fprintf(stderr, "(malloc) spread_Simulated_mass\n"); exit(EXIT_FAILURE); }
   }
 
   /* Calcul de la masse dans le graphe */
   for (int u=0; u<snet->n; u++)
   {
+    struct SimulatedPlayer *player = &snet->vertex[u];
+
     /* Ajoute de la masse partante de u */
-    for (int t=0; t<snet->n; t++) local_mass[u][t] += snet->lambda[u][t];
+    for (int a=0; a<snet->n_dests; a++)
+      local_mass[u][a] += snet->lambda[u][snet->dests[a]];
 
-    /* Calcul de la masse sur les arcs uv, màj de la masse des v voisins de u */
-    for (int k=0; k<snet->vertex[u].d; k++)
+    /* Calcul de la masse sur les arcs uv, màj de la masse des v voisins de u.
+     * Seules les destinations atteignables depuis u en reçoivent. */
+    for (int k=0; k<player->d; k++)
     {
-      int v = snet->vertex[u].neighbours[k];
+      int v = player->neighbours[k];
       net->masses[u][v] = 0; /* Reset de la masse */
-      for (int t=0; t<snet->n; t++)
+      for (int i=0; i<player->n_dests; i++)
       {
-        double mass = snet->vertex[u].X_uv[t][k] * local_mass[u][t];
-        local_mass[v][t] += mass;
+        int a = player->dests[i];
+        double *X_uv = player->table + i * ROUTE_STRIDE(player->d) + 1 + player->d;
+        double mass = X_uv[k] * local_mass[u][a];
+        local_mass[v][a] += mass;
         net->masses[u][v] += mass;
       }
     }
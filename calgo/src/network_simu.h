@@ -7,36 +7,104 @@
 #include "distrib.h"
 #include "network_th.h"
 #include "event.h"
+#include "trace.h"
+#include "stats.h"
+
+/* L'état d'un nœud est coupé en deux. Ce que lit ou écrit chaque événement
+ * de paquet (charge, service, c_uv, et de quoi choisir l'arc suivant) tient
+ * dans une ligne de cache, SimulatedNode ; le reste, lu seulement aux mises à
+ * jour des distributions, est dans SimulatedPlayer. */
+
+struct SimulatedNode
+/* Partie chaude, alignée sur une ligne de cache */
+{
+  double L; /* Charge (load) */
+  double T; /* Instant de la dernière arrivée */
+  double mu; /* Sa 'vitesse de travail' */
+  double c_uv; /* Somme des temps de séjour depuis la dernière MàJ */
+  int c_uv_count; /* et nombre de paquets correspondant */
+  int d; /* Son degré */
+  int n; /* Compteur de paquets */
+  int *neighbours; /* Ceux du joueur, suivis de son tableau slot */
+  double *table;   /* Table de routage du joueur */
+} __attribute__((aligned(CACHE_LINE)));
 
 struct SimulatedPlayer
+/* Partie froide */
 {
   int d; /* Son degré */
-  double mu; /* Sa 'vitesse de travail' */
-  int *neighbours;
+  int *neighbours; /* d voisins, puis slot : un seul bloc */
 
-  double *W_u;       /* W_u[t] = W_u^{(t)}      */
-  double **W_uv;     /* W_uv[t][v] = W_uv^{(t)} */
   double  *Y_uv;     /* Indépendant de t        */
-  double **X_uv;     /* Distribution sur uv en fonction de t,  */
-                     /* X_u[t][v] = X_uv^{(t)} */
 
-  double own_c_uv;
-  double own_c_uv_count;
+  /* Table de routage, un seul bloc : une case par destination active t
+   * atteignable depuis le nœud. La case contient W_u^{(t)}, puis les
+   * W_uv^{(t)}, puis la distribution X_uv^{(t)} sur les d arcs (voir
+   * route_W_u, route_W_uv et route_X_uv). Hors table, W_u^{(t)} = -INFINITY. */
+  int n_dests;
+  int *dests;    /* dests[i] : rang de la destination de la case i parmi les
+                  * destinations actives */
+  int *slot;     /* slot[a] : case de la a-ième destination active, -1 sinon
+                  * (slot = neighbours + d) */
+  int own_slot;  /* Case du nœud lui-même, -1 s'il n'est pas destination */
+  double *table;
 
-  int n; /* Compteur de paquets */
   int nIter; /* Compteur d'updates */
 };
 
+struct Packet
+/* Origine d'un paquet en transit, stockée une seule fois : les événements
+ * TREAT_PAQUET n'en portent que l'identifiant */
+{
+  double T; /* Instant d'émission */
+  int source, sink;
+  int hops; /* Nombre de sauts */
+};
+
 struct SimulatedNetwork
 {
   double **lambda;                /* lambda[s][t] : intensity of
                                    * emission from s towards t */
   double E; /* Constante d'échantillonage */
   struct EventQueue *qevents;
-  struct SimulatedPlayer *vertex;
-  double *L; /* Tableau des chargements (load) */
-  double *T; /* Tableau des derniers temps d'arrivées */
+  struct SimulatedNode *node;     /* Partie chaude de chaque nœud */
+  struct SimulatedPlayer *vertex; /* Partie froide */
   int n; /* Nombre de joueurs */
+
+  /* Destinations actives : les t tels qu'un lambda[s][t] > 0 */
+  int n_dests;
+  int *dests;
+  int *dest_index; /* dest_index[t] : rang de t parmi elles, -1 sinon */
+
+  /* Slab des paquets en transit, étendu au besoin */
+  struct Packet *packets;
+  uint32_t *free_packets; /* Pile des identifiants libres */
+  uint32_t n_free_packets, n_packets, max_packets;
+
+  struct Trace *trace; /* Trace des paquets (NULL : pas de trace) */
+
+  /* Statistiques (NULL : aucune), remises à zéro à l'instant warmup.
+   * Elles appartiennent à l'appelant, qui les garde après la simulation. */
+  struct SimuStats *stats;
+  double warmup;
+
+  /* Arrivées fusionnées (NULL : un événement NEW_PAQUET par flux) */
+  struct AliasTable *flows; /* Tirage du flux d'une arrivée */
+  int *flow_source, *flow_sink;
+  double rate;              /* Somme des lambda */
+
+  /* Délai de chaque lien. Nul : un paquet servi entre aussitôt dans le nœud
+   * suivant ; sinon il y entre (ENTER_PAQUET) delay plus tard. */
+  double delay;
+
+  unsigned short *rng; /* Flux aléatoire (erand48), NULL : drand48 */
+
+  /* Simulation parallèle (network_par.h) : NULL en séquentiel. Sinon, ce
+   * réseau est la partition 'part' : il partage les nœuds, les joueurs et
+   * lambda avec les autres, mais a sa file, ses paquets et ses
+   * statistiques. */
+  struct SimuParallel *par;
+  int part;
 };
 
 /* *********************** ADMINISTRATION *********************** */
@@ -45,30 +113,75 @@ struct SimulatedPlayer *new_SimulatedPlayers(struct graph *g);
 void free_SimulatedPlayers(struct SimulatedPlayer *vertex, int n);
 /* n : taille du graphe */
 
-struct SimulatedNetwork *new_SimulatedNetwork(struct graph *g, double E);
+struct SimulatedNetwork *new_SimulatedNetwork(struct graph *g, double E,
+                                             int queue_kind);
+/* queue_kind : implémentation de la file des événements (QUEUE_DARY, ...) */
+void init_destinations(struct SimulatedNetwork *snet, struct graph *g);
+/* À appeler une fois lambda rempli : relève les destinations actives et,
+ * pour chaque nœud, celles qu'il atteint. Les mises à jour ne portent que
+ * sur celles-ci ; W_u[t] vaut -INFINITY pour les autres. */
 void free_SimulatedNetwork(struct SimulatedNetwork *snet);
+/* Vide et libère aussi la trace */
+double SimulatedNetwork_size(struct graph *g, int *dests, int n_dests);
+/* Octets des nœuds et des tables de routage d'une simulation vers les
+ * destinations dests[0 .. n_dests-1], une fois init_destinations faite */
+
+/* *********************** PERTURBATIONS *********************** */
+/* En cours de simulation séquentielle, sans rien reconstruire d'autre */
+
+void remove_edge_SimulatedNetwork(struct SimulatedNetwork *snet, int u, int v);
+/* Retire l'arc uv : voisins, Y_uv et table de routage de u, puis cases des
+ * destinations que u et ses prédécesseurs n'atteignent plus. Les paquets
+ * qui s'y trouvent seront perdus. */
+void set_flow_rate(struct SimulatedNetwork *snet, int s, int t, double rate);
+/* Change l'intensité du flux (s, t), actif avant comme après (rate > 0) */
+
+/* *********************** TABLES DE ROUTAGE *********************** */
+
+#define ROUTE_STRIDE(d) (1 + 2*(d)) /* Taille d'une case de la table */
+
+double *route_W_u(struct SimulatedPlayer *vertex, int u, int a);
+double *route_W_uv(struct SimulatedPlayer *vertex, int u, int a);
+double *route_X_uv(struct SimulatedPlayer *vertex, int u, int a);
+/* W_u^{(t)}, W_uv^{(t)} et X_uv^{(t)} du nœud u, où t est la a-ième
+ * destination active. NULL si t n'est pas atteignable depuis u. */
 
 /* *********************** UTILITAIRE *********************** */
 
 double positive_part(double x); /* Renvoie 0 si x < 0, x sinon */
 
-void reset_c_uv(struct SimulatedPlayer *vertex, int u);
+void reset_c_uv(struct SimulatedNode *node, int u);
 /* Remet les c_uv et count_uv à 0 pour le sommet u */
 
-void update_distrib_SimulatedPlayer(struct SimulatedPlayer *vertex, int u, int n,
-                                    int nPlayers);
-/* Remet à jour la distribution du joueur k, selon une itération n */
+void update_distrib_SimulatedPlayer(struct SimulatedNetwork *snet, int u, int n);
+/* Remet à jour la distribution du joueur u, selon une itération n, pour
+ * ses destinations actives */
 
 /* *********************** SIMULATION *********************** */
 
+void init_arrivals(struct SimulatedNetwork *snet, int merged);
+/* Programme les premières émissions de paquets, d'après lambda : un
+ * événement NEW_PAQUET par flux, ou, si merged, un seul événement ARRIVAL
+ * pour la superposition des flux (le flux de chaque paquet est tiré avec
+ * une table d'alias). Une partition ne prend que les flux partant de ses
+ * nœuds. */
+
+void event_ARRIVAL(struct SimulatedNetwork *snet, struct Event event);
+void event_ENTER_PAQUET(struct SimulatedNetwork *snet, struct Event event);
 void event_NEW_PAQUET(struct SimulatedNetwork *snet  , struct Event event);
 void event_TREAT_PAQUET(struct SimulatedNetwork *snet, struct Event event);
 void event_UPDATE_DISTRIB(struct SimulatedNetwork *snet, struct Event event);
 
+void treat_event(struct SimulatedNetwork *snet, struct Event event);
+/* Traite un événement déjà extrait de la file */
 void treat_new_event(struct SimulatedNetwork *snet);
 /* Fonction de traitement d'un événement.
  * À utiliser en while(...) treat_new_event(snet); */
 
+void receive_packet(struct SimulatedNetwork *snet, int v, double T,
+                    struct Packet packet);
+/* Le paquet, venu d'une autre partition, entrera dans v à l'instant T */
+
 /* *********************** UTILITAIRE *********************** */
 
 void spread_Simulated_mass(struct SimulatedNetwork *snet, struct Network *net);
@@ -7,46 +7,52 @@
 
 /* Quelques fonctions pour encapsuler le code */
 
-static int** malloc_int_matrix(int n)
+static int** malloc_int_matrix(int n, int tag)
 /* Renvoie une matrice n × n d'entiers franchement allouée */
 {
-  int **res = malloc(sizeof(int*) * n);
+  int **res = mem_malloc(tag, sizeof(int*) * n);
   if (res == NULL) handle_error("malloc_int_matrix");
   for (int i=0; i<n; i++)
   {
-    res[i] = malloc(sizeof(int) * n);
+    res[i] = mem_malloc(tag, sizeof(int) * n);
     if (res[i] == NULL) handle_error("malloc_int_matrix");
   }
 
   return res;
 }
 
-static double** malloc_double_matrix(int n)
+static double** malloc_double_matrix(int n, int tag)
 /* Renvoie une matrice n × n de 'double' franchement allouée */
 {
-  double **res = malloc(sizeof(double*) * n);
+  double **res = mem_malloc(tag, sizeof(double*) * n);
   if (res == NULL) handle_error("malloc_double_matrix");
   for (int i=0; i<n; i++)
   {
-    res[i] = malloc(sizeof(double) * n);
+    res[i] = mem_malloc(tag, sizeof(double) * n);
     if (res[i] == NULL) handle_error("malloc_double_matrix");
   }
 
   return res;
 }
 
-static dtod_t **malloc_functions_matrix(int n)
+static dtod_t **malloc_functions_matrix(int n, int tag)
 {
-  double (***res)(double) = malloc(n * sizeof(dtod_t*));
+  double (***res)(double) = mem_malloc(tag, n * sizeof(dtod_t*));
   if (res == NULL) handle_error("malloc_functions_matrix");
   for (int i=0; i<n; i++)
   {
-    res[i] = malloc(n * sizeof(dtod_t));
+    res[i] = mem_malloc(tag, n * sizeof(dtod_t));
     if (res[i] == NULL) handle_error("malloc_functions_matrix");
   }
   return res;
 }
 
+static void free_matrix(void **mat, int n, int tag)
+{
+  for (int i=0; i<n; i++) mem_free(tag, mat[i]);
+  return mem_free(tag, mat);
+}
+
 
 /* Fonctions utiles */
 
@@ -54,17 +60,17 @@ struct Network *new_Network(int n)
 /* Renvoie un nouveau réseau vide */
 /* Cette fonction est vachement longue */
 {
-  struct Network *net = malloc(sizeof(struct Network));
+  struct Network *net = mem_malloc(MEM_NETWORK, sizeof(struct Network));
   if (net == NULL) handle_error("(malloc) new_Network");
 
   /* Graphe && masses */
-  net->graph = malloc_int_matrix(n);
-  net->masses = malloc_double_matrix(n);
+  net->graph = malloc_int_matrix(n, MEM_NETWORK);
+  net->masses = malloc_double_matrix(n, MEM_NETWORK);
 
   /* Fonctions */
-  net->cost  = malloc_functions_matrix(n);
-  net->dcost = malloc_functions_matrix(n);
-  net->d2cost = malloc_functions_matrix(n);
+  net->cost  = malloc_functions_matrix(n, MEM_NETWORK);
+  net->dcost = malloc_functions_matrix(n, MEM_NETWORK);
+  net->d2cost = malloc_functions_matrix(n, MEM_NETWORK);
 
   /* Taille du graphe */
   net->n = n;
@@ -72,24 +78,23 @@ struct Network *new_Network(int n)
   return net;
 }
 
+double Network_size(int n)
+/* Octets qu'occupera new_Network(n) */
+{
+  return sizeof(struct Network) + 5. * n * sizeof(void*)
+         + (double) n * n * (sizeof(int) + sizeof(double) + 3 * sizeof(dtod_t));
+}
+
 void free_Network(struct Network *net)
 /* Libère la mémoire dédiée à un réseau */
 {
-  for (int i=0; i<net->n; i++)
-  {
-    free(net->graph[i]);
-    free(net->masses[i]);
-    free(net->cost[i]);
-    free(net->dcost[i]);
-    free(net->d2cost[i]);
-  }
-  free(net->graph);
-  free(net->masses);
-  free(net->cost);
-  free(net->dcost);
-  free(net->d2cost);
+  free_matrix((void**) net->graph, net->n, MEM_NETWORK);
+  free_matrix((void**) net->masses, net->n, MEM_NETWORK);
+  free_matrix((void**) net->cost, net->n, MEM_NETWORK);
+  free_matrix((void**) net->dcost, net->n, MEM_NETWORK);
+  free_matrix((void**) net->d2cost, net->n, MEM_NETWORK);
 
-  return free(net);
+  return mem_free(MEM_NETWORK, net);
 }
 
 void set_netfun (int i, int j, struct Network *net, dtod_t fun)
@@ -173,7 +178,7 @@ void add_mass_of_player(struct Network *net, double pmass,
   while (!is_empty(paths))
   {
     path = paths->head;
-    add_mass_over(net, pmass * distrib[i], path);
+    if (distrib[i] != 0) add_mass_over(net, pmass * distrib[i], path);
     i ++;
     paths = paths->tail;
   }
@@ -235,7 +240,7 @@ double  **cost_matrix(struct Network *net)
 /* renvoie la matrice cost[i][j] */
 {
   int n = net->n;
-  double **cost_mat = malloc_double_matrix(n);
+  double **cost_mat = malloc_double_matrix(n, MEM_NONE);
   for (int i=0; i<n; i++) for (int j=0; j<n; j++)
     cost_mat[i][j] = net->cost[i][j](net->masses[i][j]);
 
@@ -246,7 +251,7 @@ double **mcost_matrix(struct Network *net)
 /* renvoie la matrice des coûts modifiés */
 {
   int n = net->n;
-  double **mcost_mat = malloc_double_matrix(n);
+  double **mcost_mat = malloc_double_matrix(n, MEM_NONE);
   for (int i=0; i<n; i++) for (int j=0; j<n; j++)
   {
     double x_ij = net->masses[i][j];
@@ -397,6 +402,87 @@ int convergence_on(int s, int t, double **mass, double epsilon,
   return worst_path <= best_path + epsilon;
 }
 
+double *DAG_distances_to(int t, double **cost_mat, struct graph *g, int *next)
+/* Renvoie d tel que d[u] est le coût du meilleur chemin u --> t, toutes
+ * masses confondues (+INFINITY si t n'est pas accessible depuis u).
+ * Si next != NULL, next[u] reçoit le successeur de u sur ce chemin. */
+/* Un seul parcours en ordre topologique inverse suffit pour tous les u */
+{
+  double *d = malloc(g->n * sizeof(double));
+  if (d == NULL) handle_error("(malloc) DAG_distances_to");
+
+  for (int u=0; u<g->n; u++) d[u] = +INFINITY;
+  if (next != NULL) for (int u=0; u<g->n; u++) next[u] = -1;
+  d[t] = 0;
+
+  for (int u=t-1; u>=0; u--)
+  for (int v=u+1; v<=t; v++)
+  if (g->network[u][v] && d[v] + cost_mat[u][v] < d[u])
+  {
+    d[u] = d[v] + cost_mat[u][v];
+    if (next != NULL) next[u] = v;
+  }
+
+  return d;
+}
+
+double total_cost(struct Network *net, double **cost_mat)
+/* Renvoie \sum_e x_e c_e, les c_e étant lus dans cost_mat */
+{
+  double c = 0;
+  for (int i=0; i<net->n; i++)
+  for (int j=0; j<net->n; j++)
+    if (net->masses[i][j]) c += net->masses[i][j] * cost_mat[i][j];
+  return c;
+}
+
+/* ***************** ÉQUILIBRE : FRANK-WOLFE ***************** */
+
+double link_cost (struct Network *net, int i, int j, double x, int marginal)
+/* Renvoie le coût de l'arc ij sous la masse x */
+{
+  if (marginal) return x * net->dcost[i][j](x) + net->cost[i][j](x);
+  return net->cost[i][j](x);
+}
+
+double link_dcost(struct Network *net, int i, int j, double x, int marginal)
+/* Renvoie la dérivée du coût de l'arc ij en x */
+{
+  if (marginal) return x * net->d2cost[i][j](x) + 2 * net->dcost[i][j](x);
+  return net->dcost[i][j](x);
+}
+
+static double directional_derivative(struct Network *net, double **x,
+                                     double **dir, double t, int marginal)
+/* Renvoie \sum_e dir_e c_e(x_e + t.dir_e) */
+{
+  double res = 0;
+  for (int i=0; i<net->n; i++)
+  for (int j=0; j<net->n; j++)
+  if (net->graph[i][j] && dir[i][j])
+    res += dir[i][j] * link_cost(net, i, j, x[i][j] + t * dir[i][j], marginal);
+  return res;
+}
+
+double line_search(struct Network *net, double **x, double **dir, int marginal)
+/* Renvoie le pas t dans [0, 1] minimisant l'objectif sur x + t.dir
+ * (dichotomie sur la dérivée directionnelle) */
+/* L'objectif étant convexe, sa dérivée est croissante en t */
+{
+  if (directional_derivative(net, x, dir, 1, marginal) <= 0) return 1;
+  if (directional_derivative(net, x, dir, 0, marginal) >= 0) return 0;
+
+  double a = 0, b = 1;
+  for (int k=0; k<50 && b - a > 1e-12; k++)
+  {
+    double t = (a + b) / 2;
+    if (directional_derivative(net, x, dir, t, marginal) > 0) b = t;
+    else                                                      a = t;
+  }
+
+  return (a + b) / 2;
+}
+
 /* ***************** Fonctions d'initialisation ***************** */
 
 void set_allfun (struct Network *net, dtod_t fun)
@@ -31,6 +31,7 @@ struct Network
 /* ***************** Fonctions administratives ***************** */
 
 struct Network *new_Network(int n); /* Renvoie un nouveau réseau vide */
+double Network_size(int n); /* Octets qu'occupera new_Network(n) */
 void free_Network(struct Network *net); /* Libère la mémoire dédiée à un réseau */
 
 void set_netfun (int i, int j, struct Network *net, dtod_t fun);
@@ -105,6 +106,29 @@ int convergence_on(int s, int t, double **mass, double epsilon,
  * avec p un chemin utilisé (i.e de masse non nulle).
  * Renvoie 0 sinon */
 
+double *DAG_distances_to(int t, double **cost_mat, struct graph *g, int *next);
+/* Renvoie d tel que d[u] est le coût du meilleur chemin u --> t, toutes
+ * masses confondues (+INFINITY si t n'est pas accessible depuis u).
+ * Si next != NULL, next[u] reçoit le successeur de u sur ce chemin. */
+
+double total_cost(struct Network *net, double **cost_mat);
+/* Renvoie \sum_e x_e c_e, les c_e étant lus dans cost_mat */
+
+/* ***************** ÉQUILIBRE : FRANK-WOLFE ***************** */
+
+/* Les coûts 'marginaux' (marginal = 1) sont les coûts modifiés
+ * x c'(x) + c(x) : leur équilibre est l'optimum social.
+ * Les coûts purs (marginal = 0) donnent l'équilibre de Wardrop. */
+
+double link_cost (struct Network *net, int i, int j, double x, int marginal);
+/* Renvoie le coût de l'arc ij sous la masse x */
+double link_dcost(struct Network *net, int i, int j, double x, int marginal);
+/* Renvoie la dérivée du coût de l'arc ij en x */
+
+double line_search(struct Network *net, double **x, double **dir, int marginal);
+/* Renvoie le pas t dans [0, 1] minimisant l'objectif sur x + t.dir
+ * (dichotomie sur la dérivée directionnelle) */
+
 /* ***************** Fonctions d'initialisation ***************** */
 
 void set_allfun (struct Network *net, dtod_t fun); /* met toutes les fonctions à fun */
@@ -0,0 +1,103 @@
+#include "output.h"
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+/* *********************** ADMINISTRATION *********************** */
+
+static int ends_with(const char *s, const char *suffix)
+{
+  size_t n = strlen(s), k = strlen(suffix);
+  return n >= k && !strcmp(s + n - k, suffix);
+}
+
+struct Output *new_Output(const char *path)
+{
+  FILE *f = fopen(path, "w");
+  if (f == NULL) return NULL;
+
+  struct Output *out = malloc(sizeof(struct Output));
+  if (out == NULL) handle_error("(malloc) new_Output");
+  out->f = f;
+  out->format = (ends_with(path, ".jsonl") || ends_with(path, ".json"))
+                ? OUT_JSONL : OUT_CSV;
+  out->run = 0;
+  setvbuf(f, NULL, _IOFBF, OUT_BUFFER);
+
+  if (out->format == OUT_CSV)
+    fprintf(f, "record,run,mode,iteration,steps,time,potential,gap,params\n");
+  return out;
+}
+
+void free_Output(struct Output *out)
+{
+  if (out == NULL) return ;
+  fclose(out->f);
+  return free(out);
+}
+
+/* *********************** ENREGISTREMENTS *********************** */
+
+static void put_double(struct Output *out, double x)
+/* Un nombre, ou la valeur vide du format s'il est inconnu */
+{
+  if (isfinite(x)) fprintf(out->f, "%.10g", x);
+  else if (out->format == OUT_JSONL) fprintf(out->f, "null");
+  return ;
+}
+
+void output_iteration(struct Output *out, const char *mode, int iteration,
+                      double potential, double gap)
+{
+  if (out->format == OUT_CSV)
+  {
+    fprintf(out->f, "iteration,%d,%s,%d,,,", out->run + 1, mode, iteration);
+    put_double(out, potential);
+    fputc(',', out->f);
+    put_double(out, gap);
+    fprintf(out->f, ",\n");
+    return ;
+  }
+
+  fprintf(out->f, "{\"record\":\"iteration\",\"run\":%d,\"mode\":\"%s\","
+          "\"iteration\":%d,\"potential\":", out->run + 1, mode, iteration);
+  put_double(out, potential);
+  fprintf(out->f, ",\"gap\":");
+  put_double(out, gap);
+  fprintf(out->f, "}\n");
+  return ;
+}
+
+void output_run(struct Output *out, const char *mode, long long steps,
+                double time, double potential, double gap, int n_params,
+                const char **names, double *values)
+{
+  out->run ++;
+  if (out->format == OUT_CSV)
+  {
+    fprintf(out->f, "run,%d,%s,,%lld,", out->run, mode, steps);
+    put_double(out, time);
+    fputc(',', out->f);
+    put_double(out, potential);
+    fputc(',', out->f);
+    put_double(out, gap);
+    fputc(',', out->f);
+    /* Paramètres : "nom=valeur" séparés par des ';' */
+    for (int k=0; k<n_params; k++)
+      fprintf(out->f, "%s%s=%.10g", (k) ? ";" : "", names[k], values[k]);
+    fputc('\n', out->f);
+    return ;
+  }
+
+  fprintf(out->f, "{\"record\":\"run\",\"run\":%d,\"mode\":\"%s\","
+          "\"steps\":%lld,\"time\":", out->run, mode, steps);
+  put_double(out, time);
+  fprintf(out->f, ",\"potential\":");
+  put_double(out, potential);
+  fprintf(out->f, ",\"gap\":");
+  put_double(out, gap);
+  fprintf(out->f, ",\"params\":{");
+  for (int k=0; k<n_params; k++)
+    fprintf(out->f, "%s\"%s\":%.10g", (k) ? "," : "", names[k], values[k]);
+  fprintf(out->f, "}}\n");
+  return ;
+}
@@ -0,0 +1,49 @@
+#ifndef output_h
+#define output_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* On définit ici la sortie structurée des résultats (toto --out), une
+ * ligne par enregistrement, en CSV ou en JSON Lines selon l'extension du
+ * fichier :
+ *  - "iteration" : une itération d'un run avec l'option potential
+ *    (potentiel, écart de Wardrop) ;
+ *  - "run" : la fin d'un run, ou d'un réplica de repeat et sweep (pas,
+ *    temps CPU, potentiel, écart, paramètres).
+ * Un seul écrivain, tamponné par gros blocs : les réplicas n'écrivent
+ * rien, repeat et sweep écrivent pour eux une fois les threads terminés.
+ * Les valeurs inconnues (NAN) sont des champs vides en CSV, null en JSON. */
+
+#define OUT_CSV   0
+#define OUT_JSONL 1
+
+#define OUT_BUFFER (1<<20) /* Tampon du fichier */
+
+struct Output
+{
+  FILE *f;
+  int format;
+  int run; /* Runs déjà écrits : les itérations sont celles du suivant */
+};
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Output *new_Output(const char *path);
+/* Ouvre 'path' en écriture : JSON Lines si son nom finit par .jsonl ou
+ * .json, CSV (avec en-tête) sinon. Renvoie NULL si l'ouverture échoue. */
+void free_Output(struct Output *out); /* Vide le tampon et ferme le fichier */
+
+/* *********************** ENREGISTREMENTS *********************** */
+
+void output_iteration(struct Output *out, const char *mode, int iteration,
+                      double potential, double gap);
+void output_run(struct Output *out, const char *mode, long long steps,
+                double time, double potential, double gap, int n_params,
+                const char **names, double *values);
+/* Les n_params paramètres du run sont names[k] = values[k] ; chaque appel
+ * est un nouveau run */
+
+#endif
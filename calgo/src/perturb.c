@@ -0,0 +1,183 @@
+#include "perturb.h"
+#include <math.h>
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+#define DESCRIPTION 64 /* Longueur d'une description */
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Perturbations *new_Perturbations(void)
+{
+  struct Perturbations *ps = malloc(sizeof(struct Perturbations));
+  if (ps == NULL) handle_error("(malloc) new_Perturbations");
+  ps->size = 8;
+  ps->list = malloc(ps->size * sizeof(struct Perturbation));
+  if (ps->list == NULL) handle_error("(malloc) new_Perturbations");
+  clear_Perturbations(ps);
+  return ps;
+}
+
+void free_Perturbations(struct Perturbations *ps)
+{
+  if (ps == NULL) return ;
+  free(ps->list);
+  return free(ps);
+}
+
+void add_Perturbation(struct Perturbations *ps, struct Perturbation p)
+{
+  if (ps->n == ps->size)
+  {
+    ps->size *= 2;
+    ps->list = realloc(ps->list, ps->size * sizeof(struct Perturbation));
+    if (ps->list == NULL) handle_error("(realloc) add_Perturbation");
+  }
+
+  int i = ps->n;
+  while (i > 0 && ps->list[i-1].T > p.T) { ps->list[i] = ps->list[i-1]; i--; }
+  ps->list[i] = p;
+  ps->n ++;
+  return ;
+}
+
+void clear_Perturbations(struct Perturbations *ps)
+{
+  ps->n = ps->next = 0;
+  ps->now = 0;
+  ps->recovering = -1;
+  ps->since = 0;
+  ps->unit = "iterations";
+  ps->window = ps->window_end = 0; ps->window_n = 0; ps->window_sum = 0;
+  ps->last_mean = NAN;
+  return ;
+}
+
+/* *********************** APPLICATION *********************** */
+
+struct Perturbation *due_Perturbation(struct Perturbations *ps, double T)
+{
+  if (ps == NULL) return NULL;
+  ps->now = T;
+  if (ps->next >= ps->n || ps->list[ps->next].T > T) return NULL;
+  return &ps->list[ps->next++];
+}
+
+int pending_Perturbations(struct Perturbations *ps)
+{
+  return (ps == NULL) ? 0 : ps->n - ps->next;
+}
+
+static void report_unrecovered(struct Perturbations *ps, double T)
+{
+  char what[DESCRIPTION];
+  describe_Perturbation(&ps->list[ps->recovering], what, DESCRIPTION);
+  fprintf(stderr, "'%s' : not recovered after %g %s\n", what, T - ps->since,
+          ps->unit);
+  return ;
+}
+
+void perturbation_applied(struct Perturbations *ps, struct Perturbation *p,
+                          double T)
+{
+  /* Au même instant, elles comptent comme une seule : on mesure le
+   * rétablissement depuis la dernière */
+  if (ps->recovering >= 0 && T > ps->since) report_unrecovered(ps, T);
+
+  char what[DESCRIPTION];
+  describe_Perturbation(p, what, DESCRIPTION);
+  fprintf(stderr, "@%g : %s\n", T, what);
+
+  ps->recovering = p - ps->list;
+  ps->since = T;
+  return ;
+}
+
+void perturbation_skipped(struct Perturbation *p, double T, const char *why)
+{
+  char what[DESCRIPTION];
+  describe_Perturbation(p, what, DESCRIPTION);
+  fprintf(stderr, "@%g : '%s' skipped (%s)\n", T, what, why);
+  return ;
+}
+
+void perturbation_recovered(struct Perturbations *ps, double T)
+{
+  if (ps->recovering < 0) return ;
+
+  char what[DESCRIPTION];
+  describe_Perturbation(&ps->list[ps->recovering], what, DESCRIPTION);
+  fprintf(stderr, "@%g : recovered from '%s' in %g %s\n", T, what,
+          T - ps->since, ps->unit);
+  ps->recovering = -1;
+  return ;
+}
+
+void finish_Perturbations(struct Perturbations *ps)
+{
+  double T = ps->now;
+  if (ps->recovering >= 0) report_unrecovered(ps, T);
+  for (int i=ps->next; i<ps->n; i++)
+  {
+    char what[DESCRIPTION];
+    describe_Perturbation(&ps->list[i], what, DESCRIPTION);
+    fprintf(stderr, "'%s' at %g : not applied (run ended at %g)\n", what,
+            ps->list[i].T, T);
+  }
+  return clear_Perturbations(ps);
+}
+
+void start_latency_window(struct Perturbations *ps, double T, long long n,
+                          double sum, double window)
+{
+  ps->window = window;
+  ps->window_end = T + window;
+  ps->window_n = n; ps->window_sum = sum;
+  ps->last_mean = NAN;
+  return ;
+}
+
+void latency_window(struct Perturbations *ps, double T, long long n, double sum,
+                    double tol)
+{
+  if (ps->recovering < 0 || T < ps->window_end) return ;
+
+  /* Statistiques remises à zéro entre-temps (fin de la chauffe) */
+  if (n < ps->window_n) return start_latency_window(ps, T, n, sum, ps->window);
+
+  if (n > ps->window_n)
+  {
+    double mean = (sum - ps->window_sum) / (n - ps->window_n);
+    if (!isnan(ps->last_mean) && fabs(mean - ps->last_mean) <= tol * ps->last_mean)
+      perturbation_recovered(ps, T);
+    ps->last_mean = mean;
+  }
+  ps->window_end += ps->window;
+  if (ps->window_end <= T) ps->window_end = T + ps->window;
+  ps->window_n = n; ps->window_sum = sum;
+  return ;
+}
+
+/* *********************** AFFICHAGE *********************** */
+
+void describe_Perturbation(struct Perturbation *p, char *buffer, size_t size)
+{
+  if (p->kind == PERTURB_COST)
+    snprintf(buffer, size, "set edge %d %d cost %s", p->u, p->v, p->fun_name);
+  else if (p->kind == PERTURB_REMOVE)
+    snprintf(buffer, size, "remove edge %d %d", p->u, p->v);
+  else snprintf(buffer, size, "set player %d mass %g", p->u, p->mass);
+  return ;
+}
+
+void print_Perturbations(struct Perturbations *ps, FILE *f)
+{
+  if (ps == NULL || ps->n == 0) { fprintf(f, "No perturbations\n"); return ; }
+  for (int i=0; i<ps->n; i++)
+  {
+    char what[DESCRIPTION];
+    describe_Perturbation(&ps->list[i], what, DESCRIPTION);
+    fprintf(f, "at %g %s\n", ps->list[i].T, what);
+  }
+  return ;
+}
@@ -0,0 +1,93 @@
+#ifndef perturb_h
+#define perturb_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "network_th.h"
+
+/* On définit ici les perturbations programmées d'un run (commande at) :
+ * changement de la fonction de coût d'un arc, retrait d'un arc, changement
+ * de la masse d'un joueur. L'instant d'une perturbation est un numéro
+ * d'itération pour les boucles d'apprentissage, un instant simulé pour la
+ * simulation des files. Le run les applique sur place, puis mesure le temps
+ * de rétablissement qui suit chacune (voir shell.c) ; elles ne valent que
+ * pour le run suivant. */
+
+#define PERTURB_COST   0 /* set edge u v cost <fonction> */
+#define PERTURB_REMOVE 1 /* remove edge u v */
+#define PERTURB_MASS   2 /* set player u mass <masse> */
+
+struct Perturbation
+{
+  double T;
+  int kind;
+  int u, v;    /* Arc uv, ou joueur u (PERTURB_MASS) */
+  double mass;
+  dtod_t fun, dfun, d2fun;
+  char fun_name[16];
+};
+
+struct Perturbations
+{
+  int n, size;
+  struct Perturbation *list; /* Par instants croissants */
+  int next;                  /* Prochaine à appliquer */
+  double now;                /* Dernier instant vu par due_Perturbation */
+
+  /* Rétablissement après la dernière perturbation appliquée */
+  int recovering; /* Son indice, -1 : aucun */
+  double since;   /* Instant où elle a été appliquée */
+  const char *unit;
+
+  /* Simulation : latences moyennes par fenêtres successives */
+  double window, window_end; /* Durée et fin de la fenêtre en cours */
+  long long window_n; /* Paquets et latence cumulée au début de la fenêtre */
+  double window_sum;
+  double last_mean;   /* Moyenne de la fenêtre précédente, NAN au départ */
+};
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Perturbations *new_Perturbations(void);
+void free_Perturbations(struct Perturbations *ps);
+
+void add_Perturbation(struct Perturbations *ps, struct Perturbation p);
+/* Insère p après celles de même instant */
+void clear_Perturbations(struct Perturbations *ps);
+
+/* *********************** APPLICATION *********************** */
+
+struct Perturbation *due_Perturbation(struct Perturbations *ps, double T);
+/* Renvoie la prochaine perturbation si son instant est atteint en T (et
+ * passe à la suivante), NULL sinon. À appeler à chaque itération ou
+ * événement : retient T comme instant courant. */
+int pending_Perturbations(struct Perturbations *ps);
+/* Nombre de perturbations pas encore appliquées (ps peut être NULL) */
+
+void perturbation_applied(struct Perturbations *ps, struct Perturbation *p,
+                          double T);
+/* p vient d'être appliquée en T : le rétablissement est mesuré à partir de
+ * là (celui d'une précédente, d'instant antérieur, est abandonné) */
+void perturbation_skipped(struct Perturbation *p, double T, const char *why);
+/* p ne s'applique pas en T (arc absent, joueur coupé...) */
+void perturbation_recovered(struct Perturbations *ps, double T);
+void finish_Perturbations(struct Perturbations *ps);
+/* Fin du run (instant now) : signale ce qui n'a pas été appliqué ou ne
+ * s'est pas rétabli, et vide la liste */
+
+void start_latency_window(struct Perturbations *ps, double T, long long n,
+                          double sum, double window);
+/* Première fenêtre de mesure, de durée window, à partir de T, où n paquets
+ * sont arrivés avec une latence cumulée sum */
+void latency_window(struct Perturbations *ps, double T, long long n, double sum,
+                    double tol);
+/* Si la fenêtre en cours est finie en T, compare sa latence moyenne à celle
+ * de la précédente : rétabli si elles diffèrent d'au plus tol (en relatif) */
+
+/* *********************** AFFICHAGE *********************** */
+
+void describe_Perturbation(struct Perturbation *p, char *buffer, size_t size);
+void print_Perturbations(struct Perturbations *ps, FILE *f);
+
+#endif
@@ -0,0 +1,179 @@
+#include "profile.h"
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#endif
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+static const char *phase_names[N_PHASES] =
+  { "distrib", "mass", "cost", "update", "check", "log" };
+
+/* *********************** COMPTEURS *********************** */
+
+#ifdef __linux__
+static int open_counter(uint64_t config, int group)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = (group == -1);
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  /* Thread courant, tout processeur */
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+static void open_counters(int *fd)
+/* Cycles et défauts de cache, lus ensemble ; -1 si le noyau refuse */
+{
+  fd[0] = fd[1] = -1;
+#ifdef __linux__
+  if ((fd[0] = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1)) < 0) return ;
+  if ((fd[1] = open_counter(PERF_COUNT_HW_CACHE_MISSES, fd[0])) < 0)
+  { close(fd[0]); fd[0] = -1; return ; }
+  ioctl(fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+  return ;
+}
+
+static void read_counters(struct Profile *prof, uint64_t *counters)
+{
+  /* PERF_FORMAT_GROUP : nombre de compteurs, puis leurs valeurs */
+  uint64_t buffer[3] = { 0, 0, 0 };
+  if (prof->perf_fd[0] < 0
+      || read(prof->perf_fd[0], buffer, sizeof(buffer)) < 0)
+  { counters[0] = counters[1] = 0; return ; }
+  counters[0] = buffer[1];
+  counters[1] = buffer[2];
+  return ;
+}
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Profile *new_Profile(FILE *csv)
+{
+  struct Profile *prof = malloc(sizeof(struct Profile));
+  if (prof == NULL) handle_error("(malloc) new_Profile");
+
+  prof->phase = -1;
+  prof->iterations = 0;
+  for (int p=0; p<N_PHASES; p++)
+  {
+    prof->ns[p] = prof->iter_ns[p] = 0;
+    prof->counters[p][0] = prof->counters[p][1] = 0;
+  }
+  open_counters(prof->perf_fd);
+  prof->csv = csv;
+
+  if (csv != NULL)
+  {
+    fprintf(csv, "iteration");
+    for (int p=0; p<N_PHASES; p++) fprintf(csv, ",%s_ns", phase_names[p]);
+    fprintf(csv, "\n");
+  }
+  return prof;
+}
+
+void free_Profile(struct Profile *prof)
+{
+  if (prof == NULL) return ;
+  if (prof->perf_fd[0] >= 0) { close(prof->perf_fd[1]); close(prof->perf_fd[0]); }
+  return free(prof);
+}
+
+/* *********************** MESURE *********************** */
+
+void profile_phase(struct Profile *prof, int phase)
+{
+  if (prof == NULL) return ;
+
+  struct timespec now;
+  uint64_t counters[2];
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  read_counters(prof, counters);
+
+  if (prof->phase >= 0)
+  {
+    int64_t ns = (int64_t) (now.tv_sec - prof->mark.tv_sec) * 1000000000
+                 + (now.tv_nsec - prof->mark.tv_nsec);
+    prof->iter_ns[prof->phase] += ns;
+    prof->counters[prof->phase][0] += counters[0] - prof->mark_counters[0];
+    prof->counters[prof->phase][1] += counters[1] - prof->mark_counters[1];
+  }
+  prof->phase = phase;
+  prof->mark = now;
+  prof->mark_counters[0] = counters[0];
+  prof->mark_counters[1] = counters[1];
+  return ;
+}
+
+static void close_iteration(struct Profile *prof)
+{
+  if (prof->phase < 0) return ;
+  profile_phase(prof, -1);
+
+  if (prof->csv != NULL) fprintf(prof->csv, "%d", prof->iterations);
+  for (int p=0; p<N_PHASES; p++)
+  {
+    if (prof->csv != NULL) fprintf(prof->csv, ",%lld",
+                                   (long long) prof->iter_ns[p]);
+    prof->ns[p] += prof->iter_ns[p];
+    prof->iter_ns[p] = 0;
+  }
+  if (prof->csv != NULL) fprintf(prof->csv, "\n");
+  return ;
+}
+
+void profile_iteration(struct Profile *prof, int iter)
+{
+  if (prof == NULL) return ;
+  close_iteration(prof);
+  prof->iterations = iter + 1;
+  /* Par défaut, le début d'une itération calcule les distributions */
+  profile_phase(prof, PHASE_DISTRIB);
+  return ;
+}
+
+void profile_finish(struct Profile *prof)
+{
+  if (prof == NULL) return ;
+  return close_iteration(prof);
+}
+
+/* *********************** AFFICHAGE *********************** */
+
+void print_Profile(struct Profile *prof, FILE *f)
+{
+  int64_t total = 0;
+  for (int p=0; p<N_PHASES; p++) total += prof->ns[p];
+  int n = (prof->iterations) ? prof->iterations : 1;
+
+  fprintf(f, "Profile over %d iterations (%.3f ms)\n", prof->iterations,
+          total * 1e-6);
+  fprintf(f, "%-8s %12s %7s %12s", "phase", "total (ms)", "share",
+          "per iter (us)");
+  if (prof->perf_fd[0] >= 0) fprintf(f, " %14s %12s", "cycles", "cache misses");
+  fprintf(f, "\n");
+
+  for (int p=0; p<N_PHASES; p++)
+  {
+    fprintf(f, "%-8s %12.3f %6.1f%% %12.3f", phase_names[p], prof->ns[p] * 1e-6,
+            (total) ? 100. * prof->ns[p] / total : 0, prof->ns[p] * 1e-3 / n);
+    if (prof->perf_fd[0] >= 0)
+      fprintf(f, " %14llu %12llu", (unsigned long long) prof->counters[p][0],
+              (unsigned long long) prof->counters[p][1]);
+    fprintf(f, "\n");
+  }
+  if (prof->perf_fd[0] < 0) fprintf(f, "(no hardware counters: perf_event_open "
+                                    "unavailable)\n");
+  return ;
+}
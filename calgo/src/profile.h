@@ -0,0 +1,63 @@
+#ifndef profile_h
+#define profile_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/* On définit ici le profilage des runs d'apprentissage (run ... profile).
+ * Chaque itération est découpée en phases ; le temps écoulé (horloge
+ * monotone, en nanosecondes) entre deux changements de phase est compté à
+ * la phase quittée. Si le noyau le permet (perf_event_open), on compte
+ * aussi les cycles et les défauts de cache du thread.
+ * Toutes les fonctions acceptent NULL (pas de profilage) : les appels
+ * restent dans les boucles sans rien coûter d'autre qu'un test. */
+
+#define PHASE_DISTRIB 0 /* Calcul des distributions (points de jeu, direction) */
+#define PHASE_MASS    1 /* Propagation des masses dans le réseau */
+#define PHASE_COST    2 /* Matrice des coûts */
+#define PHASE_UPDATE  3 /* Évaluation et mise à jour des joueurs */
+#define PHASE_CHECK   4 /* Tests de convergence */
+#define PHASE_LOG     5 /* Affichage */
+#define N_PHASES      6
+
+struct Profile
+{
+  int phase;            /* Phase en cours, -1 hors itération */
+  struct timespec mark; /* Début de la phase en cours */
+  uint64_t mark_counters[2];
+
+  int iterations;
+  int64_t ns[N_PHASES];       /* Totaux du run */
+  int64_t iter_ns[N_PHASES];  /* Itération en cours */
+  uint64_t counters[N_PHASES][2]; /* Cycles et défauts de cache */
+
+  int perf_fd[2]; /* Cycles (meneur du groupe) et défauts de cache ; -1
+                   * s'ils sont indisponibles */
+  FILE *csv;   /* Une ligne par itération (NULL : aucune) */
+};
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Profile *new_Profile(FILE *csv);
+/* Profil vide ; s'il y a un fichier csv, y écrit l'en-tête des lignes
+ * d'itérations (qui ne le ferme pas) */
+void free_Profile(struct Profile *prof);
+
+/* *********************** MESURE *********************** */
+
+void profile_iteration(struct Profile *prof, int iter);
+/* Début de l'itération iter (la précédente, s'il y en a une, est close) */
+void profile_phase(struct Profile *prof, int phase);
+/* Le temps depuis le dernier changement va à la phase en cours ; on entre
+ * dans 'phase' */
+void profile_finish(struct Profile *prof);
+/* Clôt la dernière itération (sortie de boucle, break compris) */
+
+/* *********************** AFFICHAGE *********************** */
+
+void print_Profile(struct Profile *prof, FILE *f);
+/* Tableau par phase : temps total, part, moyenne par itération, compteurs */
+
+#endif
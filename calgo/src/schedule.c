@@ -0,0 +1,104 @@
+#include "schedule.h"
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+#define ADAGRAD_EPS   1e-12 /* Évite la division par 0 */
+#define BACKTRACK_DEC 0.5   /* Réduction du pas si le potentiel augmente */
+#define BACKTRACK_INC 1.1   /* Croissance du pas sinon */
+#define BACKTRACK_MAX 1e6
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Schedule *new_Schedule(int policy, int period, int n, int k)
+/* Renvoie une nouvelle politique pour un graphe de taille n et k joueurs */
+{
+  struct Schedule *sched = malloc(sizeof(struct Schedule));
+  if (sched == NULL) handle_error("(malloc) new_Schedule");
+
+  sched->policy = policy;
+  sched->period = (period > 0) ? period : 1;
+  sched->scale  = 1;
+  sched->last_potential = INFINITY;
+  sched->n = n; sched->k = k;
+  sched->G = 0; sched->G_player = NULL;
+
+  if (policy == SCHED_ADAGRAD)
+  {
+    sched->G_player = calloc(k, sizeof(double));
+    if (sched->G_player == NULL) handle_error("(calloc) new_Schedule");
+  }
+
+  return sched;
+}
+
+void free_Schedule(struct Schedule *sched)
+{
+  free(sched->G_player);
+  return free(sched);
+}
+
+int schedule_from_name(const char *name)
+/* Renvoie la politique de nom 'name', -1 si elle n'existe pas */
+{
+  for (int policy=SCHED_POWER; policy<=SCHED_CURVATURE; policy++)
+    if (!strcmp(name, schedule_name(policy))) return policy;
+  return -1;
+}
+
+const char *schedule_name(int policy)
+{
+  if (policy == SCHED_POWER)     return "power";
+  if (policy == SCHED_ADAGRAD)   return "adagrad";
+  if (policy == SCHED_BACKTRACK) return "backtrack";
+  if (policy == SCHED_CURVATURE) return "curvature";
+  return "unknown";
+}
+
+/* *********************** CALCUL DES PAS *********************** */
+
+double schedule_observe(struct Schedule *sched, struct Network *net,
+                        double **cost_mat, int iter, double cst_gamma)
+/* À appeler une fois par itération, avant les mises à jour : accumule les
+ * coûts des arcs (AdaGrad), compare le potentiel au précédent (backtracking)
+ * et réestime la courbure. Renvoie la nouvelle valeur de cst_gamma. */
+{
+  if (sched->policy == SCHED_ADAGRAD)
+  {
+    for (int u=0; u<sched->n; u++)
+    for (int v=0; v<sched->n; v++)
+    if (net->graph[u][v]) sched->G += cost_mat[u][v] * cost_mat[u][v];
+  }
+  else if (sched->policy == SCHED_BACKTRACK)
+  {
+    /* Le dernier pas a fait augmenter le potentiel : il était trop grand */
+    double potential = net_potential(net);
+    if (potential > sched->last_potential) sched->scale *= BACKTRACK_DEC;
+    else if (sched->scale < BACKTRACK_MAX) sched->scale *= BACKTRACK_INC;
+    sched->last_potential = potential;
+  }
+  else if (sched->policy == SCHED_CURVATURE && !(iter % sched->period))
+  {
+    double d2 = net_d2potential(net);
+    if (d2 > 0) cst_gamma = 1 / d2;
+  }
+
+  return cst_gamma;
+}
+
+double schedule_gamma(struct Schedule *sched, double gamma, double cst_gamma)
+/* Pas global : le pas de base gamma corrigé par la politique */
+{
+  if (sched->policy == SCHED_ADAGRAD) return cst_gamma / sqrt(sched->G + ADAGRAD_EPS);
+  return sched->scale * gamma;
+}
+
+double schedule_player_gamma(struct Schedule *sched, int p, double *costs, int m,
+                             double gamma, double cst_gamma)
+/* Pas propre au joueur p, dont les m actions ont coûté costs (AdaGrad),
+ * schedule_gamma(gamma) sinon */
+{
+  if (sched->policy != SCHED_ADAGRAD) return schedule_gamma(sched, gamma, cst_gamma);
+
+  for (int i=0; i<m; i++) sched->G_player[p] += costs[i] * costs[i];
+  return cst_gamma / sqrt(sched->G_player[p] + ADAGRAD_EPS);
+}
@@ -0,0 +1,59 @@
+#ifndef schedule_h
+#define schedule_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include "network_th.h"
+
+/* On définit ici les politiques de pas (gamma) des mises à jour de Hedge.
+ * Le pas de base reste cst_gamma / (n+1)^beta ; une politique peut le
+ * corriger, ou le remplacer par un pas adaptatif (propre à chaque joueur
+ * dans le cas des chemins). Le pas est commun à toutes les actions d'un même
+ * joueur : un pas par arc écraserait l'écart relatif des coûts. */
+
+#define SCHED_POWER     0 /* cst_gamma / (n+1)^beta, inchangé */
+#define SCHED_ADAGRAD   1 /* cst_gamma / sqrt(somme des |c_n|²) */
+#define SCHED_BACKTRACK 2 /* Pas divisé par 2 quand le potentiel augmente */
+#define SCHED_CURVATURE 3 /* cst_gamma = 1 / d2potential toutes les 'period'
+                           * itérations, le temps du run */
+
+struct Schedule
+{
+  int policy;
+  int period;            /* Période de réestimation de la courbure */
+  double scale;          /* Facteur multiplicatif (backtracking) */
+  double last_potential;
+  double G;              /* AdaGrad : somme des |c|² sur les arcs */
+  double *G_player;      /* AdaGrad : G_player[p] = somme des |c_p|² */
+  int n, k;              /* Taille du graphe, nombre de joueurs */
+};
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Schedule *new_Schedule(int policy, int period, int n, int k);
+/* Renvoie une nouvelle politique pour un graphe de taille n et k joueurs */
+void free_Schedule(struct Schedule *sched);
+
+int schedule_from_name(const char *name);
+/* Renvoie la politique de nom 'name', -1 si elle n'existe pas */
+const char *schedule_name(int policy);
+
+/* *********************** CALCUL DES PAS *********************** */
+
+double schedule_observe(struct Schedule *sched, struct Network *net,
+                        double **cost_mat, int iter, double cst_gamma);
+/* À appeler une fois par itération, avant les mises à jour : accumule les
+ * coûts des arcs (AdaGrad), compare le potentiel au précédent (backtracking)
+ * et réestime la courbure. Renvoie la nouvelle valeur de cst_gamma. */
+
+double schedule_gamma(struct Schedule *sched, double gamma, double cst_gamma);
+/* Pas global : le pas de base gamma corrigé par la politique */
+
+double schedule_player_gamma(struct Schedule *sched, int p, double *costs, int m,
+                             double gamma, double cst_gamma);
+/* Pas propre au joueur p, dont les m actions ont coûté costs (AdaGrad),
+ * schedule_gamma sinon */
+
+#endif
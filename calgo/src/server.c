@@ -0,0 +1,577 @@
+#include "server.h"
+#include "shell.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+#define CHUNK 4096 /* Lecture des sorties d'une session */
+
+struct Request
+/* Commande en attente ou en cours dans une session */
+{
+  long client; /* Clé du client (il a pu partir entre-temps) */
+  int id;
+  char line[SERVER_LINE];
+  struct Request *next;
+};
+
+struct Client
+{
+  int fd; /* -1 : emplacement libre */
+  long key;
+  char buf[SERVER_LINE];
+  int len;
+  int next_id;
+  char session[SERVER_NAME]; /* Session courante */
+};
+
+struct Session
+{
+  char name[SERVER_NAME]; /* "" : emplacement libre */
+  pid_t pid;
+  int ctl;      /* Commandes vers le fils, codes de retour vers nous */
+  int out, err; /* Sorties du fils */
+  char status[32]; /* Code de retour en cours de lecture */
+  int status_len;
+  struct Request *running;       /* NULL : au repos */
+  struct Request *queue, *last;  /* En attente, dans l'ordre */
+};
+
+struct Server
+{
+  int fd; /* Socket d'écoute */
+  int workers, busy; /* Sessions pouvant travailler, et travaillant */
+  int next_session;  /* Début du tour de l'ordonnanceur */
+  long next_key;
+  struct Client  clients[SERVER_CLIENTS];
+  struct Session sessions[SERVER_SESSIONS];
+};
+
+static volatile sig_atomic_t stop_server = 0;
+
+static void on_signal(int sig)
+{
+  (void) sig;
+  stop_server = 1;
+  return ;
+}
+
+/* *********************** ÉCRITURE *********************** */
+
+static int write_all(int fd, const char *data, size_t size)
+/* Renvoie 0, ou -1 si l'autre bout est parti */
+{
+  while (size > 0)
+  {
+    ssize_t n = write(fd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return -1;
+    data += n; size -= n;
+  }
+  return 0;
+}
+
+static int json_string(char *dst, const char *src, int n)
+/* Écrit src[0 .. n-1] en chaîne JSON (guillemets compris) dans dst, qui
+ * doit avoir 6 n + 3 octets ; renvoie la longueur écrite */
+{
+  int len = 0;
+  dst[len++] = '"';
+  for (int i=0; i<n; i++)
+  {
+    unsigned char c = src[i];
+    if (c == '"' || c == '\\') { dst[len++] = '\\'; dst[len++] = c; }
+    else if (c == '\n') { dst[len++] = '\\'; dst[len++] = 'n'; }
+    else if (c == '\t') { dst[len++] = '\\'; dst[len++] = 't'; }
+    else if (c < 0x20 || c == 0x7f) len += sprintf(dst + len, "\\u%04x", c);
+    else dst[len++] = c;
+  }
+  dst[len++] = '"';
+  dst[len] = '\0';
+  return len;
+}
+
+static struct Client *find_client(struct Server *srv, long key)
+{
+  for (int i=0; i<SERVER_CLIENTS; i++)
+    if (srv->clients[i].fd >= 0 && srv->clients[i].key == key)
+      return &srv->clients[i];
+  return NULL;
+}
+
+static void close_client(struct Client *c)
+{
+  close(c->fd);
+  c->fd = -1;
+  return ;
+}
+
+static void send_line(struct Client *c, const char *line, int len)
+{
+  if (c != NULL && write_all(c->fd, line, len)) close_client(c);
+  return ;
+}
+
+static void send_data(struct Client *c, int id, const char *session,
+                      const char *stream, const char *data, int n)
+/* Un morceau de sortie de la commande id */
+{
+  static char line[6 * CHUNK + 6 * SERVER_NAME + 64];
+  int len = sprintf(line, "{\"id\":%d,\"session\":", id);
+  len += json_string(line + len, session, strlen(session));
+  len += sprintf(line + len, ",\"stream\":\"%s\",\"data\":", stream);
+  len += json_string(line + len, data, n);
+  len += sprintf(line + len, "}\n");
+  return send_line(c, line, len);
+}
+
+static void send_status(struct Client *c, int id, const char *session,
+                        int status, const char *error)
+/* Ligne finale de la commande id ; error : NULL si aucune */
+{
+  char line[6 * SERVER_LINE + 6 * SERVER_NAME + 64];
+  int len = sprintf(line, "{\"id\":%d,\"session\":", id);
+  len += json_string(line + len, session, strlen(session));
+  len += sprintf(line + len, ",\"status\":%d", status);
+  if (error != NULL)
+  {
+    len += sprintf(line + len, ",\"error\":");
+    len += json_string(line + len, error, strlen(error));
+  }
+  len += sprintf(line + len, "}\n");
+  return send_line(c, line, len);
+}
+
+/* *********************** SESSIONS (FILS) *********************** */
+
+static void run_session(int ctl)
+/* Boucle d'une session : une commande lue sur ctl, exécutée, puis son
+ * code de retour renvoyé sur ctl une fois les sorties vidées */
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  long int seed = (tv.tv_sec * 1000000 + tv.tv_usec) ^ getpid();
+  srand48(seed);
+  srand(seed);
+
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  struct Shell *sh = new_Shell();
+  if ((sh->in = fdopen(ctl, "r")) == NULL) handle_error("(fdopen) run_session");
+  sh->batch = TRUE;
+
+  while (1)
+  {
+    int ret_value = treat_cmd(sh);
+    if (feof(sh->in)) break;
+    fflush(stdout); fflush(stderr);
+
+    char status[16];
+    int len = sprintf(status, "%d\n", ret_value);
+    if (write_all(ctl, status, len)) break;
+  }
+
+  free_Shell(sh);
+  exit(EXIT_SUCCESS);
+}
+
+static void close_fds(struct Server *srv)
+/* Dans un fils : ferme tout ce qui appartient au serveur */
+{
+  close(srv->fd);
+  for (int i=0; i<SERVER_CLIENTS; i++)
+    if (srv->clients[i].fd >= 0) close(srv->clients[i].fd);
+  for (int i=0; i<SERVER_SESSIONS; i++)
+    if (srv->sessions[i].name[0] != '\0')
+    {
+      close(srv->sessions[i].ctl);
+      close(srv->sessions[i].out); close(srv->sessions[i].err);
+    }
+  return ;
+}
+
+static struct Session *find_session(struct Server *srv, const char *name)
+{
+  for (int i=0; i<SERVER_SESSIONS; i++)
+    if (!strcmp(srv->sessions[i].name, name)) return &srv->sessions[i];
+  return NULL;
+}
+
+static struct Session *new_session(struct Server *srv, const char *name)
+/* Lance le processus d'une session ; NULL s'il n'y a plus de place ou si
+ * le fork échoue */
+{
+  struct Session *s = NULL;
+  for (int i=0; i<SERVER_SESSIONS && s == NULL; i++)
+    if (srv->sessions[i].name[0] == '\0') s = &srv->sessions[i];
+  if (s == NULL) return NULL;
+
+  int sv[2], out[2], err[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv)) return NULL;
+  if (pipe(out)) { close(sv[0]); close(sv[1]); return NULL; }
+  if (pipe(err)) { close(sv[0]); close(sv[1]); close(out[0]); close(out[1]);
+                   return NULL; }
+
+  fflush(stdout); fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    close(sv[0]); close(sv[1]); close(out[0]); close(out[1]);
+    close(err[0]); close(err[1]);
+    return NULL;
+  }
+  if (pid == 0)
+  {
+    signal(SIGINT, SIG_DFL); signal(SIGTERM, SIG_DFL);
+    close_fds(srv);
+    close(sv[0]); close(out[0]); close(err[0]);
+    dup2(out[1], STDOUT_FILENO); dup2(err[1], STDERR_FILENO);
+    close(out[1]); close(err[1]);
+    run_session(sv[1]);
+  }
+
+  close(sv[1]); close(out[1]); close(err[1]);
+  fcntl(out[0], F_SETFL, O_NONBLOCK);
+  fcntl(err[0], F_SETFL, O_NONBLOCK);
+  fcntl(sv[0], F_SETFL, O_NONBLOCK);
+
+  strcpy(s->name, name);
+  s->pid = pid;
+  s->ctl = sv[0]; s->out = out[0]; s->err = err[0];
+  s->status_len = 0;
+  s->running = s->queue = s->last = NULL;
+  return s;
+}
+
+static void forward_output(struct Server *srv, struct Session *s, int fd,
+                           const char *stream)
+/* Relaie ce que l'on peut lire sur fd au client de la commande en cours */
+{
+  char data[CHUNK];
+  ssize_t n;
+  while ((n = read(fd, data, CHUNK)) > 0)
+    if (s->running != NULL)
+      send_data(find_client(srv, s->running->client), s->running->id,
+                s->name, stream, data, n);
+  return ;
+}
+
+static void finish_request(struct Server *srv, struct Session *s, int status,
+                           const char *error)
+/* Fin de la commande en cours : ses dernières sorties, puis son code */
+{
+  forward_output(srv, s, s->out, "stdout");
+  forward_output(srv, s, s->err, "stderr");
+  struct Request *req = s->running;
+  send_status(find_client(srv, req->client), req->id, s->name, status, error);
+  free(req);
+  s->running = NULL;
+  srv->busy--;
+  return ;
+}
+
+static void end_session(struct Server *srv, struct Session *s,
+                        const char *error)
+/* Le fils est mort (ou on le tue) : les commandes restantes échouent */
+{
+  if (s->running != NULL) finish_request(srv, s, -1, error);
+  while (s->queue != NULL)
+  {
+    struct Request *req = s->queue;
+    s->queue = req->next;
+    send_status(find_client(srv, req->client), req->id, s->name, -1, error);
+    free(req);
+  }
+
+  kill(s->pid, SIGTERM);
+  waitpid(s->pid, NULL, 0);
+  close(s->ctl); close(s->out); close(s->err);
+  s->name[0] = '\0';
+  return ;
+}
+
+static void read_status(struct Server *srv, struct Session *s)
+/* Lit les codes de retour du fils ; fin de session si ctl est fermée */
+{
+  ssize_t n = read(s->ctl, s->status + s->status_len,
+                   sizeof(s->status) - 1 - s->status_len);
+  if (n < 0 && (errno == EAGAIN || errno == EINTR)) return ;
+  if (n <= 0) return end_session(srv, s, "session ended");
+
+  s->status_len += n;
+  s->status[s->status_len] = '\0';
+  char *eol;
+  while ((eol = strchr(s->status, '\n')) != NULL)
+  {
+    if (s->running != NULL) finish_request(srv, s, atoi(s->status), NULL);
+    s->status_len -= eol + 1 - s->status;
+    memmove(s->status, eol + 1, s->status_len + 1);
+  }
+  return ;
+}
+
+static void dispatch(struct Server *srv)
+/* Donne leur prochaine commande à des sessions au repos, à tour de rôle,
+ * tant que des travailleurs sont libres */
+{
+  for (int k=0; k<SERVER_SESSIONS && srv->busy < srv->workers; k++)
+  {
+    struct Session *s = &srv->sessions[(srv->next_session + k) % SERVER_SESSIONS];
+    if (s->name[0] == '\0' || s->running != NULL || s->queue == NULL) continue;
+
+    struct Request *req = s->queue;
+    s->queue = req->next;
+    s->running = req;
+    srv->busy++;
+    srv->next_session = (s - srv->sessions + 1) % SERVER_SESSIONS;
+
+    size_t len = strlen(req->line);
+    req->line[len] = '\n';
+    int failed = write_all(s->ctl, req->line, len + 1);
+    req->line[len] = '\0';
+    if (failed) end_session(srv, s, "session ended");
+  }
+  return ;
+}
+
+/* *********************** CLIENTS *********************** */
+
+static void list_sessions(struct Server *srv, struct Client *c, int id)
+{
+  char data[SERVER_SESSIONS * (SERVER_NAME + 32)];
+  int len = 0;
+  for (int i=0; i<SERVER_SESSIONS; i++)
+  {
+    struct Session *s = &srv->sessions[i];
+    if (s->name[0] == '\0') continue;
+    int queued = 0;
+    for (struct Request *req = s->queue; req != NULL; req = req->next) queued++;
+    len += sprintf(data + len, "%s %s %d\n", s->name,
+                   (s->running != NULL) ? "running" : "idle", queued);
+  }
+  if (len) send_data(c, id, c->session, "stdout", data, len);
+  return send_status(c, id, c->session, NORMAL, NULL);
+}
+
+static int valid_name(const char *name)
+{
+  if (*name == '\0' || strlen(name) >= SERVER_NAME) return FALSE;
+  for (; *name; name++)
+    if (!(('a' <= *name && *name <= 'z') || ('A' <= *name && *name <= 'Z')
+          || ('0' <= *name && *name <= '9') || *name == '_' || *name == '-'
+          || *name == '.'))
+      return FALSE;
+  return TRUE;
+}
+
+static void treat_line(struct Server *srv, struct Client *c, char *line)
+/* Une commande du client : pour le serveur, ou pour sa session courante */
+{
+  char cmd[SERVER_LINE], arg[SERVER_LINE];
+  int n_tokens = sscanf(line, "%1023s %1023s", cmd, arg);
+  if (n_tokens < 1) return ; /* Ligne vide */
+  int id = ++c->next_id;
+
+  if (cmp_token(cmd, "quit") || cmp_token(cmd, "q"))
+  {
+    send_status(c, id, c->session, NORMAL, NULL);
+    if (c->fd >= 0) close_client(c);
+  }
+  else if (cmp_token(cmd, "session"))
+  {
+    if (n_tokens < 2 || !valid_name(arg))
+      return send_status(c, id, c->session, -1, "invalid session name");
+    strcpy(c->session, arg);
+    send_status(c, id, c->session, NORMAL, NULL);
+  }
+  else if (cmp_token(cmd, "sessions")) list_sessions(srv, c, id);
+  else if (cmp_token(cmd, "close"))
+  {
+    struct Session *s = find_session(srv, (n_tokens < 2) ? c->session : arg);
+    if (s == NULL) return send_status(c, id, c->session, -1, "no such session");
+    end_session(srv, s, "session closed");
+    send_status(c, id, c->session, NORMAL, NULL);
+  }
+  else if (cmp_token(cmd, "shutdown"))
+  {
+    stop_server = 1;
+    send_status(c, id, c->session, NORMAL, NULL);
+  }
+  else
+  {
+    struct Session *s = find_session(srv, c->session);
+    if (s == NULL && (s = new_session(srv, c->session)) == NULL)
+      return send_status(c, id, c->session, -1, "cannot start session");
+
+    struct Request *req = malloc(sizeof(struct Request));
+    if (req == NULL) handle_error("(malloc) treat_line");
+    req->client = c->key; req->id = id; req->next = NULL;
+    strcpy(req->line, line);
+    if (s->queue == NULL) s->queue = req;
+    else                  s->last->next = req;
+    s->last = req;
+  }
+  return ;
+}
+
+static void read_client(struct Server *srv, struct Client *c)
+/* Lit ce qu'envoie le client et traite ses lignes complètes */
+{
+  ssize_t n = read(c->fd, c->buf + c->len, SERVER_LINE - c->len);
+  if (n < 0 && errno == EINTR) return ;
+  if (n <= 0) return close_client(c);
+  c->len += n;
+
+  char *start = c->buf, *eol;
+  while (c->fd >= 0
+         && (eol = memchr(start, '\n', c->buf + c->len - start)) != NULL)
+  {
+    *eol = '\0';
+    if (eol > start && eol[-1] == '\r') eol[-1] = '\0';
+    treat_line(srv, c, start);
+    start = eol + 1;
+  }
+  if (c->fd < 0) return ;
+
+  c->len -= start - c->buf;
+  memmove(c->buf, start, c->len);
+  if (c->len == SERVER_LINE) /* Ligne trop longue : on la jette */
+  {
+    send_status(c, ++c->next_id, c->session, -1, "line too long");
+    if (c->fd >= 0) c->len = 0;
+  }
+  return ;
+}
+
+static void accept_client(struct Server *srv)
+{
+  int fd = accept(srv->fd, NULL, NULL);
+  if (fd < 0) return ;
+
+  struct Client *c = NULL;
+  for (int i=0; i<SERVER_CLIENTS && c == NULL; i++)
+    if (srv->clients[i].fd < 0) c = &srv->clients[i];
+  if (c == NULL) { close(fd); return ; }
+
+  c->fd = fd;
+  c->key = srv->next_key++;
+  c->len = 0;
+  c->next_id = 0;
+  strcpy(c->session, "default");
+  return ;
+}
+
+/* *********************** BOUCLE PRINCIPALE *********************** */
+
+static int listen_on(const char *path)
+/* Socket d'écoute sur path (remplace une ancienne socket, pas un fichier) */
+{
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path))
+  { fprintf(stderr, "Socket path too long : %s\n", path); return -1; }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  struct stat st;
+  if (!stat(path, &st) && S_ISSOCK(st.st_mode)) unlink(path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) { perror("socket"); return -1; }
+  if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) || listen(fd, 16))
+  { perror(path); close(fd); return -1; }
+  return fd;
+}
+
+int serve(const char *path, int workers)
+{
+  struct Server *srv = malloc(sizeof(struct Server));
+  if (srv == NULL) handle_error("(malloc) serve");
+  if ((srv->fd = listen_on(path)) < 0) { free(srv); return EXIT_FAILURE; }
+
+  srv->workers = (workers > 0) ? workers : sysconf(_SC_NPROCESSORS_ONLN);
+  if (srv->workers < 1) srv->workers = 1;
+  srv->busy = srv->next_session = 0;
+  srv->next_key = 0;
+  for (int i=0; i<SERVER_CLIENTS; i++)  srv->clients[i].fd = -1;
+  for (int i=0; i<SERVER_SESSIONS; i++) srv->sessions[i].name[0] = '\0';
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+  fprintf(stderr, "Listening on %s (%d workers)\n", path, srv->workers);
+
+  /* Descripteurs surveillés : écoute, clients, puis 3 par session */
+  struct pollfd fds[1 + SERVER_CLIENTS + 3 * SERVER_SESSIONS];
+  int owner[1 + SERVER_CLIENTS + 3 * SERVER_SESSIONS];
+
+  while (!stop_server)
+  {
+    int n = 0;
+    fds[n].fd = srv->fd; fds[n].events = POLLIN; owner[n++] = -1;
+    for (int i=0; i<SERVER_CLIENTS; i++)
+      if (srv->clients[i].fd >= 0)
+      { fds[n].fd = srv->clients[i].fd; fds[n].events = POLLIN; owner[n++] = i; }
+    int first_session = n;
+    for (int i=0; i<SERVER_SESSIONS; i++)
+      if (srv->sessions[i].name[0] != '\0')
+      {
+        struct Session *s = &srv->sessions[i];
+        fds[n].fd = s->ctl; fds[n].events = POLLIN; owner[n++] = i;
+        fds[n].fd = s->out; fds[n].events = POLLIN; owner[n++] = i;
+        fds[n].fd = s->err; fds[n].events = POLLIN; owner[n++] = i;
+      }
+
+    if (poll(fds, n, -1) < 0)
+    {
+      if (errno == EINTR) continue;
+      perror("poll"); break;
+    }
+
+    /* Sorties des sessions d'abord, leurs codes de retour ensuite : une
+     * commande finie a tout écrit avant son code */
+    for (int k=first_session; k<n; k++)
+    {
+      struct Session *s = &srv->sessions[owner[k]];
+      if (!fds[k].revents || s->name[0] == '\0' || fds[k].fd == s->ctl) continue;
+      forward_output(srv, s, fds[k].fd,
+                     (fds[k].fd == s->out) ? "stdout" : "stderr");
+    }
+    for (int k=first_session; k<n; k++)
+    {
+      struct Session *s = &srv->sessions[owner[k]];
+      if (fds[k].revents && s->name[0] != '\0' && fds[k].fd == s->ctl)
+        read_status(srv, s);
+    }
+
+    for (int k=1; k<first_session; k++)
+    {
+      struct Client *c = &srv->clients[owner[k]];
+      if (fds[k].revents && c->fd == fds[k].fd) read_client(srv, c);
+    }
+    if (fds[0].revents & POLLIN) accept_client(srv);
+
+    dispatch(srv);
+  }
+
+  for (int i=0; i<SERVER_SESSIONS; i++)
+    if (srv->sessions[i].name[0] != '\0')
+      end_session(srv, &srv->sessions[i], "server shutdown");
+  for (int i=0; i<SERVER_CLIENTS; i++)
+    if (srv->clients[i].fd >= 0) close_client(&srv->clients[i]);
+  close(srv->fd);
+  unlink(path);
+  free(srv);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+#ifndef server_h
+#define server_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* On définit ici le mode serveur (toto --serve socket) : un processus
+ * résident qui écoute sur une socket Unix locale et exécute les commandes
+ * du shell (même grammaire que treat_cmd) envoyées par plusieurs clients.
+ *
+ * Les commandes sont rangées dans des sessions nommées. Chaque session est
+ * un processus fils qui garde son Shell (graphe, réseau, joueurs, état
+ * appris) en mémoire d'une commande à l'autre ; sa sortie standard et sa
+ * sortie d'erreur sont relayées au client qui a envoyé la commande en
+ * cours. Une session n'exécute qu'une commande à la fois, dans l'ordre
+ * d'arrivée ; au plus 'workers' sessions travaillent en même temps.
+ *
+ * Protocole : une commande par ligne. En plus des commandes du shell :
+ *   session NOM    les commandes suivantes du client vont à la session NOM
+ *                  (créée à sa première commande ; "default" au départ)
+ *   sessions       liste des sessions
+ *   close [NOM]    termine une session (la courante par défaut)
+ *   quit           ferme la connexion
+ *   shutdown       arrête le serveur
+ * Réponses : une ligne JSON par morceau de sortie, puis une ligne finale
+ * avec le code de retour de treat_cmd (ou -1 et un message d'erreur) :
+ *   {"id":3,"session":"a","stream":"stdout","data":"..."}
+ *   {"id":3,"session":"a","status":0}
+ *   {"id":4,"session":"a","status":-1,"error":"..."}
+ * 'id' numérote les commandes de chaque client à partir de 1. */
+
+#define SERVER_CLIENTS  64   /* Clients simultanés */
+#define SERVER_SESSIONS 64   /* Sessions simultanées */
+#define SERVER_LINE     1024 /* Longueur maximale d'une commande */
+#define SERVER_NAME     64   /* Longueur maximale d'un nom de session */
+
+int serve(const char *path, int workers);
+/* Écoute sur la socket 'path' jusqu'à la commande shutdown ; workers <= 0 :
+ * autant que de processeurs. Renvoie le code de sortie du programme. */
+
+#endif
@@ -7,19 +7,58 @@
 
 /* **************** CONSTANTES DE SIMULTATION **************** */
 
-static double alpha = 1./3.;//1./4.;
-static double beta  = 1;//0.52;//1.;
-static double cst_epsilon = 1e-5;//1e-9;
-static double cst_gamma   = 1;
+static double epsilon_iter(struct Shell *sh, int n)
+{
+  return sh->cst_epsilon / pow((double) n + sh->iter_offset + 1, sh->alpha);
+}
+
+static double gamma_iter(struct Shell *sh, double cst_gamma, int n)
+/* cst_gamma : celle du run, que la politique de pas peut réestimer */
+{
+  return cst_gamma / pow((double) n + sh->iter_offset + 1, sh->beta);
+}
+
+/* **************** PROGRESSION **************** */
+
+static void report_converged(struct Shell *sh, int steps)
+/* Fin d'un run convergé : efface d'abord la ligne de progression, s'il y
+ * en a une */
+{
+  if (sh->batch || sh->exec_mode & SILENT)
+    fprintf(stderr, "Converged with %d steps.\n", steps);
+  else fprintf(stderr, "\x1b[1K\rConverged with %d steps.\n", steps);
+  return ;
+}
+
+static void report_progress(struct Shell *sh, int steps)
+/* Ligne de progression, réécrite à chaque itération (ni en batch ni en
+ * silencieux) */
+{
+  if (!sh->batch && !(sh->exec_mode & SILENT))
+    fprintf(stderr, "\x1b[1K\rDid not converged with %d steps", steps);
+  return ;
+}
 
-static double epsilon_iter(int n)
+static const char *mode_name(int exec_mode)
 {
-  return cst_epsilon / pow((double) n + 1, alpha);
+  if (exec_mode & MODE_PATHS)      return "paths";
+  if (exec_mode & MODE_VERTEX)     return "vertex";
+  if (exec_mode & MODE_OPTIMISTIC) return "optimistic";
+  if (exec_mode & MODE_EXTRA)      return "extragradient";
+  if (exec_mode & MODE_BANDIT)     return "bandit";
+  if (exec_mode & MODE_SIMU)       return "simulation";
+  if (exec_mode & MODE_FW)         return "frankwolfe";
+  return "none";
 }
 
-static double gamma_iter(int n)
+static void output_potential(struct Shell *sh, int iteration)
+/* Enregistrement "iteration" de l'option potential */
 {
-  return cst_gamma / pow((double) n + 1, beta);
+  output_iteration(sh->out, mode_name(sh->exec_mode), iteration,
+                   net_potential(sh->net),
+                   (sh->exec_mode & STOP_GAP || sh->exec_mode & MODE_FW)
+                   ? sh->gap : NAN);
+  return ;
 }
 
 struct Shell *new_Shell(void)
@@ -28,28 +67,62 @@ struct Shell *new_Shell(void)
   if (sh == NULL) handle_error("(malloc) new_Shell");
 
   sh->nPlayers = sh->nGraph = sh->exists_token = FALSE;
+  sh->in = stdin; sh->batch = FALSE; sh->out = NULL;
+  sh->profile = NULL; sh->profile_csv = NULL; sh->profile_csv_name = NULL;
   sh->initialized_network = sh->initialized_players = FALSE;
   sh->g   = NULL;
   sh->net = NULL;
   sh->players = NULL;
   sh->exec_mode = MODE_PATHS;
+  sh->alpha = 1./3.;      //1./4.;
+  sh->beta  = 1;          //0.52;//1.;
+  sh->cst_epsilon = 1e-5; //1e-9;
+  sh->cst_gamma   = 1;
+  sh->gap_tol = 0; sh->gap_every = 1; sh->gap = NAN;
+  sh->schedule = SCHED_POWER; sh->schedule_period = 10;
+  sh->prune_threshold = 0; sh->prune_period = 50;
+  sh->queue_kind = QUEUE_DARY; sh->merged_arrivals = FALSE;
+  sh->delay = 0; sh->threads = 1;
+  sh->trace_mode = TRACE_TEXT; sh->trace_out = stderr;
+  sh->trace_chosen = FALSE;
+  sh->stats = NULL; sh->warmup = 0;
+  sh->opt_potential = NAN;
+  sh->eq_masses = NULL; sh->eq_nPlayers = sh->eq_n = 0;
+  sh->steps = -1; sh->run_time = 0;
+  sh->graph_p = 0.5;
+  sh->net_fun = sh->net_dfun = sh->net_d2fun = NULL;
+  sh->paths = NULL; sh->paths_vertices = NULL;
+  sh->learned_mode = 0; sh->learned = NULL; sh->learned_vertices = NULL;
+  sh->learned_nPlayers = sh->learned_n = 0;
+  sh->learned_iter = sh->iter_offset = 0;
+  sh->mem_budget = 0;
+  sh->perturb = NULL; sh->recovery_tol = 1e-2; sh->recovery_window = 100;
 
   return sh;
 }
 
 void free_Shell(struct Shell *sh)
 {
+  forget_learned(sh);
   if (sh->g != NULL)       free_graph(sh->g);
   if (sh->net != NULL)     free_Network(sh->net);
   if (sh->players != NULL) free(sh->players);
+  forget_equilibrium(sh);
+  if (sh->trace_out != stderr) fclose(sh->trace_out);
+  free_SimuStats(sh->stats);
+  free_Output(sh->out);
+  if (sh->in != stdin) fclose(sh->in);
+  if (sh->profile_csv != NULL) fclose(sh->profile_csv);
+  free(sh->profile_csv_name);
+  free_Perturbations(sh->perturb);
 
   return free(sh);
 }
 
 int next_token(struct Shell *sh)
 {
-  char c; int k = 0;
-  while ((c = getchar()) != EOF && k < 1023)
+  int c; int k = 0;
+  while ((c = getc(sh->in)) != EOF && k < 1023)
   {
     //printf("\'%c\'(%d)\n", c, c);
     if (c == ' ' && k)  break;
@@ -105,7 +178,8 @@ int treat_cmd(struct Shell *sh)
 /* *** FONCTION PRINCIPALE *** */
 {
   int ret_value;
-  printf("[%d]> ", sh->nGraph++);
+  if (!sh->batch) printf("[%d]> ", sh->nGraph);
+  sh->nGraph++;
   next_token(sh);
 
   /* Reconnaissance du token */
@@ -114,6 +188,9 @@ int treat_cmd(struct Shell *sh)
   else if (cmp_token(sh->token, "quit") || cmp_token(sh->token, "q")) exit(quit(sh));
   else if (cmp_token(sh->token, "new")) ret_value = new_smg(sh);
   else if (cmp_token(sh->token, "run")) ret_value = run(sh);
+  else if (cmp_token(sh->token, "repeat")) ret_value = repeat(sh);
+  else if (cmp_token(sh->token, "sweep"))  ret_value = sweep(sh);
+  else if (cmp_token(sh->token, "at"))     ret_value = perturb_at(sh);
   else if (cmp_token(sh->token, "print")) ret_value = print(sh);
   else if (cmp_token(sh->token, "set"))   ret_value = set(sh);
   else if (cmp_token(sh->token, "unset")) ret_value = 0;
@@ -176,15 +253,75 @@ int shell_new_graph(struct Shell *sh)
 
   sh->initialized_players = FALSE;
   sh->initialized_network = FALSE;
+  forget_equilibrium(sh);
+  forget_learned(sh);
 
+  free_graph(sh->g);
   sh->g = new_graph(n);
+  sh->graph_p = p;
   set_randDAG(sh->g, p);
   return NORMAL;
 }
 
+/* ************************** MÉMOIRE ************************** */
+
+#define MIB (1024. * 1024.)
+
+static double run_size(struct Shell *sh)
+/* Estimation des octets que demandera un run dans le mode courant, avec
+ * le graphe et les joueurs courants */
+{
+  int n = sh->g->n, k = sh->nPlayers;
+  double size = 0;
+
+  if (sh->exec_mode & MODE_SIMU)
+  {
+    int *dests = malloc(k * sizeof(int)), n_dests = 0;
+    if (dests == NULL && k) handle_error("(malloc) run_size");
+    for (int i=0; i<k; i++)
+    {
+      int j = 0;
+      while (j < n_dests && dests[j] != sh->players[i].sink) j++;
+      if (j == n_dests) dests[n_dests++] = sh->players[i].sink;
+    }
+    size = SimulatedNetwork_size(sh->g, dests, n_dests);
+    free(dests);
+    return size;
+  }
+
+  if (sh->exec_mode & MODE_PATHS && sh->paths == NULL)
+    for (int i=0; i<k; i++)
+      size += path_from_to_size(sh->players[i].source, sh->players[i].sink,
+                                sh->g);
+  else if (sh->exec_mode & (MODES_VERTEX | MODE_BANDIT))
+    size += VPPopulation_size(sh->g, k);
+  else if (sh->exec_mode & MODE_FW) /* Flots des joueurs : x, y et sb */
+    size += 3. * k * n * n * sizeof(double);
+
+  /* Matrices des coûts de chaque itération */
+  return size + 2. * n * n * sizeof(double);
+}
+
+static void preflight(struct Shell *sh, const char *what, double bytes,
+                      long long freed)
+/* Prévient si ce que demande 'what' (bytes octets, freed libérés avant)
+ * dépasse le budget */
+{
+  if (sh->mem_budget <= 0) return ;
+
+  double in_use = mem_current(-1) - freed;
+  if (in_use + bytes > sh->mem_budget)
+    fprintf(stderr, "Warning: %s needs about %.3g MiB (%.3g MiB in use), "
+            "over the %.3g MiB budget\n", what, bytes / MIB, in_use / MIB,
+            sh->mem_budget / MIB);
+  return ;
+}
+
 int shell_new_network(struct Shell *sh)
 {
   if (sh->g == NULL) { fprintf(stderr, "No graph.\n"); return MISSING; }
+  preflight(sh, "new network", Network_size(sh->g->n),
+            (sh->net != NULL) ? mem_current(MEM_NETWORK) : 0);
 
   /* Potentielle libération */
   if (sh->net != NULL) free_Network(sh->net);
@@ -205,8 +342,11 @@ int shell_new_players(struct Shell *sh)
   else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
   n = atoi(sh->token);
 
+  forget_equilibrium(sh);
+  forget_learned(sh);
   sh->initialized_players = TRUE;
   sh->nPlayers = n;
+  free(sh->players);
   sh->players  = malloc(n * sizeof(struct ShellPlayer));
   if (sh->players == NULL) { fprintf(stderr, "(malloc) shell_new_players\n");
                              exit(EXIT_FAILURE); }
@@ -219,6 +359,7 @@ int shell_new_players(struct Shell *sh)
     sh->players[i].mass   = 1.;
   }
 
+  preflight(sh, "new players", run_size(sh), 0);
   return NORMAL;
 }
 
@@ -233,15 +374,59 @@ int set(struct Shell *sh)
 
   if (cmp_token(sh->token, "network")) set_network(sh);
   else if (cmp_token(sh->token, "player")) set_player(sh);
-  else if (cmp_token(sh->token, "graph"))  set_graph(sh);
+  else if (cmp_token(sh->token, "graph"))  return set_graph(sh);
   else if (cmp_token(sh->token, "mass")) set_mass(sh);
   else if (cmp_token(sh->token, "beta")) set_beta(sh);
   else if (cmp_token(sh->token, "cst_gamma")) set_cst_gamma(sh);
+  else if (cmp_token(sh->token, "schedule")) set_schedule(sh);
+  else if (cmp_token(sh->token, "prune")) set_prune(sh);
+  else if (cmp_token(sh->token, "queue")) set_queue(sh);
+  else if (cmp_token(sh->token, "trace")) set_trace(sh);
+  else if (cmp_token(sh->token, "warmup")) set_warmup(sh);
+  else if (cmp_token(sh->token, "arrivals")) set_arrivals(sh);
+  else if (cmp_token(sh->token, "delay")) set_delay(sh);
+  else if (cmp_token(sh->token, "threads")) set_threads(sh);
+  else if (cmp_token(sh->token, "seed")) set_seed(sh);
+  else if (cmp_token(sh->token, "memory")) set_memory(sh);
+  else if (cmp_token(sh->token, "recovery")) set_recovery(sh);
   else unknown(sh);
 
   return NORMAL;
 }
 
+static int set_network_funs(struct Shell *sh, dtod_t fun, dtod_t dfun,
+                            dtod_t d2fun)
+/* Même coût sur tous les arcs, retenu pour les réplicas (repeat ... fresh) */
+{
+  sh->initialized_network = 1;
+  set_allfun  (sh->net, fun);
+  set_alldfun (sh->net, dfun);
+  set_alld2fun(sh->net, d2fun);
+  sh->net_fun = fun; sh->net_dfun = dfun; sh->net_d2fun = d2fun;
+  return NORMAL;
+}
+
+static int network_funs(const char *name, dtod_t *fun, dtod_t *dfun,
+                        dtod_t *d2fun)
+/* Fonction de coût de nom 'name' et ses dérivées. Renvoie 0 si elle
+ * n'existe pas. */
+{
+  if (cmp_token(name, "constant"))
+  { *fun = fun_cst;  *dfun = fun_dcst;  *d2fun = fun_d2cst; }
+  else if (cmp_token(name, "linear"))
+  { *fun = fun_lin;  *dfun = fun_dlin;  *d2fun = fun_d2lin; }
+  else if (cmp_token(name, "inverse"))
+  { *fun = fun_inv;  *dfun = fun_dinv;  *d2fun = fun_d2inv; }
+  else if (cmp_token(name, "inverse2"))
+  { *fun = fun_inv2; *dfun = fun_dinv2; *d2fun = fun_d2inv2; }
+  else if (cmp_token(name, "affine"))
+  { *fun = fun_aff;  *dfun = fun_daff;  *d2fun = fun_d2aff; }
+  else if (cmp_token(name, "poly3"))
+  { *fun = fun_deg3; *dfun = fun_ddeg3; *d2fun = fun_d2deg3; }
+  else return 0;
+  return 1;
+}
+
 int set_network(struct Shell *sh)
 /* Paramétrage du réseau (fonctions de coût) */
 {
@@ -250,53 +435,9 @@ int set_network(struct Shell *sh)
   if (sh->exists_token) next_token(sh);
   else return NORMAL;
 
-  if (cmp_token(sh->token, "constant"))
-  {
-    sh->initialized_network = 1;
-    set_allfun (sh->net, fun_cst);
-    set_alldfun(sh->net, fun_dcst);
-    set_alld2fun(sh->net, fun_d2cst);
-    return NORMAL;
-  }
-  else if (cmp_token(sh->token, "linear"))
-  {
-    sh->initialized_network = 1;
-    set_allfun (sh->net, fun_lin);
-    set_alldfun(sh->net, fun_dlin);
-    set_alld2fun(sh->net, fun_d2lin);
-    return NORMAL;
-  }
-  else if (cmp_token(sh->token, "inverse"))
-  {
-    sh->initialized_network = 1;
-    set_allfun (sh->net, fun_inv);
-    set_alldfun(sh->net, fun_dinv);
-    return NORMAL;
-  }
-  else if (cmp_token(sh->token, "inverse2"))
-  {
-    sh->initialized_network = 1;
-    set_allfun (sh->net, fun_inv2);
-    set_alldfun(sh->net, fun_dinv2);
-    return NORMAL;
-  }
-  else if (cmp_token(sh->token, "affine"))
-  {
-    sh->initialized_network = 1;
-    set_allfun (sh->net, fun_aff);
-    set_alldfun(sh->net, fun_daff);
-    set_alld2fun(sh->net, fun_d2aff);
-    return NORMAL;
-  }
-  else if (cmp_token(sh->token, "poly3"))
-  {
-    sh->initialized_network = 1;
-    set_allfun (sh->net, fun_deg3);
-    set_alldfun(sh->net, fun_ddeg3);
-    set_alld2fun(sh->net, fun_d2deg3);
-    return NORMAL;
-  }
-  else return UNKNOWN;
+  dtod_t fun, dfun, d2fun;
+  if (!network_funs(sh->token, &fun, &dfun, &d2fun)) return UNKNOWN;
+  return set_network_funs(sh, fun, dfun, d2fun);
 }
 
 int set_player(struct Shell *sh)
@@ -332,20 +473,41 @@ int set_graph(struct Shell *sh)
   int n = atoi(sh->token);
 
   /* Libération potentielle */
+  forget_equilibrium(sh);
+  forget_learned(sh);
   if (sh->g != NULL)    free_graph(sh->g);
 
+  sh->initialized_players = FALSE;
+  free(sh->players);
+  sh->players = NULL;
+
+  /* La matrice (n×n entiers, ligne par ligne) suit n sur la même ligne :
+   * on ne lit pas au-delà, le mode serveur n'envoie une ligne qu'après
+   * la réponse à la précédente */
+  char *line = NULL;
+  size_t size = 0;
+  const char *p = "";
+  if (sh->exists_token && getline(&line, &size, sh->in) >= 0) p = line;
+  sh->exists_token = FALSE;
+
   sh->g = new_graph(n);
-  for (int i=0; i<n; i++)
-  for (int j=0; j<n; j++)
+  int k;
+  for (k=0; k<n*n; k++)
   {
-    int coef;
-    if (!scanf("%d", &coef)) { fprintf(stderr, "Scanf"); return MISSING; };
-    sh->g->network[i][j] = coef;
+    char *end;
+    long coef = strtol(p, &end, 10);
+    if (end == p) break;
+    sh->g->network[k / n][k % n] = coef;
+    p = end;
   }
+  free(line);
 
-  sh->initialized_players = FALSE;
-  free(sh->players);
-  sh->players = NULL;
+  if (k < n*n)
+  {
+    fprintf(stderr, "Expected %dx%d adjacency matrix.\n", n, n);
+    free_graph(sh->g); sh->g = NULL;
+    return MISSING;
+  }
 
   return NORMAL;
 }
@@ -366,7 +528,7 @@ int set_beta(struct Shell *sh)
   if (sh->exists_token) next_token(sh);
   else { fprintf(stderr, "Expected float\n"); return NOTOKEN; }
 
-  beta = atof(sh->token);
+  sh->beta = atof(sh->token);
 
   return NORMAL;
 }
@@ -376,11 +538,209 @@ int set_cst_gamma(struct Shell *sh)
   if (sh->exists_token) next_token(sh);
   else { fprintf(stderr, "Expected float\n"); return NOTOKEN; }
 
-  cst_gamma = atof(sh->token);
+  sh->cst_gamma = atof(sh->token);
+
+  return NORMAL;
+}
+
+int set_schedule(struct Shell *sh)
+/* Politique de pas [période] */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected schedule\n"); return NOTOKEN; }
+
+  int policy = schedule_from_name(sh->token);
+  if (policy < 0) return unknown(sh);
+  sh->schedule = policy;
+
+  if (sh->exists_token)
+  {
+    next_token(sh);
+    sh->schedule_period = atoi(sh->token);
+  }
+
+  return NORMAL;
+}
+
+int set_prune(struct Shell *sh)
+/* Élagage : seuil [période] | off */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected threshold\n"); return NOTOKEN; }
+
+  if (cmp_token(sh->token, "off")) { sh->prune_threshold = 0; return NORMAL; }
+  sh->prune_threshold = atof(sh->token);
+
+  if (sh->exists_token)
+  {
+    next_token(sh);
+    sh->prune_period = atoi(sh->token);
+    if (sh->prune_period < 1) sh->prune_period = 1;
+  }
+
+  return NORMAL;
+}
+
+int set_queue(struct Shell *sh)
+/* File des événements de la simulation : binary, dary ou ladder */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected queue\n"); return NOTOKEN; }
+
+  int kind = queue_kind_from_name(sh->token);
+  if (kind < 0) return unknown(sh);
+  sh->queue_kind = kind;
+
+  return NORMAL;
+}
+
+int set_trace(struct Shell *sh)
+/* Trace des paquets : off | text [fichier] | binary [fichier]
+ * Sans fichier, le texte va sur stderr et le binaire dans trace.bin */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected trace mode\n"); return NOTOKEN; }
+
+  int mode = trace_mode_from_name(sh->token);
+  if (mode < 0) return unknown(sh);
+
+  const char *file = (mode == TRACE_BINARY) ? "trace.bin" : NULL;
+  if (sh->exists_token) { next_token(sh); file = sh->token; }
+
+  FILE *out = stderr;
+  if (file != NULL && (out = fopen(file, "w")) == NULL)
+  { fprintf(stderr, "Cannot open %s\n", file); return NOOBJECT; }
+
+  if (sh->trace_out != stderr) fclose(sh->trace_out);
+  sh->trace_mode = mode;
+  sh->trace_out  = out;
+  sh->trace_chosen = TRUE;
+  return NORMAL;
+}
+
+int set_warmup(struct Shell *sh)
+/* Durée (simulée) de la période de chauffe : les statistiques de la
+ * simulation sont remises à zéro à cet instant */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected duration\n"); return NOTOKEN; }
+
+  sh->warmup = atof(sh->token);
+  return NORMAL;
+}
+
+int set_arrivals(struct Shell *sh)
+/* Arrivées de la simulation : un événement par flux (flows), ou un seul
+ * pour leur superposition (merged) */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected flows or merged\n"); return NOTOKEN; }
+
+  if (cmp_token(sh->token, "flows")) sh->merged_arrivals = FALSE;
+  else if (cmp_token(sh->token, "merged")) sh->merged_arrivals = TRUE;
+  else return unknown(sh);
+  return NORMAL;
+}
+
+int set_delay(struct Shell *sh)
+/* Délai de chaque lien : un paquet servi entre dans le nœud suivant après
+ * ce délai. Nécessaire (> 0) à la simulation parallèle. */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected delay\n"); return NOTOKEN; }
+
+  double delay = atof(sh->token);
+  if (delay < 0) { fprintf(stderr, "Negative delay\n"); return NORMAL; }
+  sh->delay = delay;
+  return NORMAL;
+}
+
+int set_threads(struct Shell *sh)
+/* Simulation parallèle sur P threads (P > 1), séquentielle sinon */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+
+  int threads = atoi(sh->token);
+  if (threads < 1) { fprintf(stderr, "Expected positive int\n"); return NORMAL; }
+  sh->threads = threads;
+  return NORMAL;
+}
+
+int set_seed(struct Shell *sh)
+/* Graine de tous les tirages : graphes, joueurs et runs deviennent
+ * reproductibles (sinon, graine tirée de l'heure au lancement) */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+
+  long seed = atol(sh->token);
+  srand48(seed);
+  srand(seed);
+  srandom(seed);
+  return NORMAL;
+}
+
+int set_memory(struct Shell *sh)
+/* Budget mémoire en Mio (0 : aucun) */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected float\n"); return NOTOKEN; }
+
+  sh->mem_budget = atof(sh->token) * MIB;
+  if (sh->mem_budget < 0) sh->mem_budget = 0;
+  return NORMAL;
+}
+
+int set_recovery(struct Shell *sh)
+/* Seuil de rétablissement après une perturbation [durée des fenêtres de
+ * latence de la simulation] */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected float\n"); return NOTOKEN; }
+  sh->recovery_tol = atof(sh->token);
 
+  if (!sh->exists_token) return NORMAL;
+  next_token(sh);
+  double window = atof(sh->token);
+  if (window > 0) sh->recovery_window = window;
+  else fprintf(stderr, "Window should be positive\n");
   return NORMAL;
 }
 
+void forget_equilibrium(struct Shell *sh)
+/* Oublie la solution de référence (graphe ou joueurs modifiés) */
+{
+  if (sh->eq_masses != NULL)
+  {
+    for (int p=0; p<sh->eq_nPlayers; p++)
+      free_cost_matrix(sh->eq_masses[p], sh->eq_n);
+    free(sh->eq_masses);
+  }
+  sh->eq_masses = NULL;
+  sh->eq_nPlayers = sh->eq_n = 0;
+  sh->opt_potential = NAN;
+  return ;
+}
+
+void forget_learned(struct Shell *sh)
+/* Oublie l'état appris par le dernier run (graphe ou joueurs recréés) */
+{
+  if (sh->learned_mode & MODE_PATHS)
+  {
+    free_SBPlayers(sh->learned, sh->learned_nPlayers);
+    free_vertices(sh->learned_vertices, sh->learned_n);
+  }
+  else if (sh->learned_mode & MODES_VERTEX)
+    free_VPPopulation_set(sh->learned, sh->learned_nPlayers);
+  else if (sh->learned_mode & MODE_BANDIT)
+    free_VBPopulation_set(sh->learned, sh->learned_nPlayers);
+  sh->learned_mode = 0; sh->learned = NULL; sh->learned_vertices = NULL;
+  sh->learned_nPlayers = sh->learned_n = 0;
+  sh->learned_iter = 0;
+  return ;
+}
+
 /* ************************** SIMULATION ************************** */
 
 /* Conversion utiles pour les simulations */
@@ -392,9 +752,13 @@ struct SBPlayer *ShellPlayers_to_SBPlayers(struct Shell *sh, int n,
 {
   struct SBPlayer *sbplayers = new_SBPlayers(n);
 
-  for (int i=0; i<n; i++) set_SBPlayer(i, sbplayers, sh->players[i].source,
-                                       sh->players[i].sink, sh->players[i].mass,
-                                       sh->g, vertices);
+  for (int i=0; i<n; i++)
+    if (sh->paths != NULL)
+      set_SBPlayer_paths(i, sbplayers, sh->players[i].source,
+                         sh->players[i].sink, sh->players[i].mass,
+                         sh->paths[i]);
+    else set_SBPlayer(i, sbplayers, sh->players[i].source, sh->players[i].sink,
+                      sh->players[i].mass, sh->g, vertices);
 
   return sbplayers;
 }
@@ -476,7 +840,7 @@ static int has_converged(struct Shell *sh, double epsilon, void *players,
 {
   for (int i=0; i<sh->nPlayers; i++)
   {
-    if (sh->exec_mode & MODE_VERTEX)
+    if (sh->exec_mode & MODES_VERTEX)
     {
       struct VPPopulation *pop = (struct VPPopulation *) players;
       double **mass = mass_spread(i, pop, 0);
@@ -516,185 +880,724 @@ static int has_converged(struct Shell *sh, double epsilon, void *players,
   return 1;
 }
 
-/* *************** SIMULATION PATHS *************** */
-
-static int shell_simu_sb(struct Shell *sh)
-/* Fait la simulation */
+static double relative_gap(struct Shell *sh, double **cost_mat)
+/* Écart relatif de Wardrop sur les coûts de cost_mat :
+ * (coût total - coût des plus courts chemins) / coût total.
+ * On ne fait qu'un calcul de plus courts chemins par destination. */
 {
-  if (sh->g == NULL)   { fprintf(stderr, "No graph.\n");   return MISSING; }
-  if (sh->net == NULL) { fprintf(stderr, "No network.\n"); return MISSING; }
-  if (!sh->initialized_network) { fprintf(stderr, "Uninitialized network.\n");
-                                  return MISSING; }
-  if (sh->players == NULL) { fprintf(stderr, "No players.\n");  return MISSING; }
-  if (!sh->initialized_players) { fprintf(stderr, "Uninitialized players.\n");
-                                  return MISSING; }
-
-  /* Remarque : si les joueurs sont non-initialisés, se préparer à une explosion
-   * de même que si le network n'est pas initalisé... */
+  double tc = total_cost(sh->net, cost_mat);
+  if (tc <= 0) return 0;
 
-  int **vertices = vertices_array(sh->g->n);
-  struct SBPlayer *sb_players = ShellPlayers_to_SBPlayers(sh, sh->nPlayers,
-                                                          vertices);
+  double spc = 0;
+  int *done = calloc(sh->g->n, sizeof(int));
+  if (done == NULL) handle_error("(calloc) relative_gap");
 
-  clock_t t0 = clock();
-
-  for (int iter=0; sh->exec_mode & STOP || iter<sh->nIter; iter++)
-  /* Boucle principale */
+  for (int i=0; i<sh->nPlayers; i++)
   {
+    int t = sh->players[i].sink;
+    if (done[t]) continue;
+    done[t] = 1;
+
+    double *d = DAG_distances_to(t, cost_mat, sh->g, NULL);
+    for (int j=i; j<sh->nPlayers; j++) if (sh->players[j].sink == t)
+      spc += sh->players[j].mass * d[sh->players[j].source];
+    free(d);
+  }
 
-    //aff_SBPlayer_score(0, sb_players);
+  free(done);
+  return (tc - spc) / tc;
+}
 
-    reset_masses(sh->net); /* Reset des masses */
-    for (int i=0; i<sh->nPlayers; i++) /* Calcul des distributions - MàJ des masses */
-    {
-      double *distrib = SBPlayer_distrib(i, sb_players, 0);
-      add_mass_of_player(sh->net, sb_players[i].mass,
-                         sb_players[i].paths, distrib);
-      free(distrib);
-    }
-    double **cost_mat = mcost_matrix(sh->net); /* Précalcul de la matrice des coûts */
-    if (iter && sh->exec_mode & STOP && has_converged(sh, sh->precision,
-                                                      sb_players, cost_mat))
-    {
-      fprintf(stderr, "\x1b[1K\rConverged with %d steps.\n", iter + 1);
-      free_cost_matrix(cost_mat, sh->g->n);
-      break;
-    }
-    else if (sh->exec_mode & STOP && !(sh->exec_mode & SILENT))
-      fprintf(stderr, "\x1b[1K\rDid not converged with %d steps", iter + 1);
+static int gap_reached(struct Shell *sh, int iter, double **cost_mat)
+/* Recalcule l'écart relatif toutes les gap_every itérations.
+ * Renvoie 1 si celui-ci est passé sous le seuil, 0 sinon (ou s'il reste
+ * des perturbations à appliquer). */
+{
+  if (!(sh->exec_mode & STOP_GAP) || iter % sh->gap_every) return 0;
 
-    for (int i=0; i<sh->nPlayers; i++) /* Calcul des coûts - MàJ des évaluations */
-    {
-      double *distrib = fast_eval_player(i, sb_players, cost_mat);
-      for (int j=0; j<sb_players[i].n; j++)
-        sb_players[i].Y_uv[j] += distrib[j] * gamma_iter(iter);
-      free(distrib);
-    }
-    if (sh->exec_mode & POTENTIAL) fprintf(stderr, "@%3d : potential = %.4f\n",
-                         iter+1, net_potential(sh->net));
+  sh->gap = relative_gap(sh, cost_mat);
+  return sh->gap <= sh->gap_tol && !pending_Perturbations(sh->perturb);
+}
 
+/* *************** DÉMARRAGE À CHAUD *************** */
 
-    free_cost_matrix(cost_mat, sh->g->n);
-  }
+/* On part du flot d'équilibre de chaque joueur : en chaque nœud u, la
+ * proportion p_uv du flot sortant de u qui emprunte uv. On choisit les Y_uv
+ * de sorte que la distribution jouée soit exactement p_uv. */
 
-  if (sh->exec_mode & POTENTIAL)
-    for (int i=0; i<sh->nPlayers; i++) aff_SBPlayer_score(i, sb_players);
+#define WARM_MIN_PROBA 1e-12
 
-  if (sh->exec_mode & TIME)
+static double **new_zero_matrix(int n)
+/* Renvoie une matrice n × n nulle */
+{
+  double **x = malloc(n * sizeof(double*));
+  if (x == NULL) handle_error("(malloc) new_zero_matrix");
+  for (int u=0; u<n; u++)
   {
-    clock_t t1 = clock();
-    fprintf(stderr, "Time used : %lf\n", (t1 - t0) / (CLOCKS_PER_SEC * 1.));
+    x[u] = calloc(n, sizeof(double));
+    if (x[u] == NULL) handle_error("(calloc) new_zero_matrix");
   }
-
-
-  free_vertices(vertices, sh->g->n);
-  free_SBPlayers(sb_players, sh->nPlayers);
-  return NORMAL;
+  return x;
 }
 
-/* *************** SIMULATION VERTEX *************** */
-static int shell_simu_vertex(struct Shell *sh)
+static int warm_start_available(struct Shell *sh)
 {
-  /* Vérifications préliminaires pour éviter une explosion en vol */
-  if (sh->g == NULL)   { fprintf(stderr, "No graph.\n"); return MISSING; }
-  if (sh->net == NULL) { fprintf(stderr, "No network.\n"); return MISSING; }
-  if (!sh->initialized_network) { fprintf(stderr, "Uninitialized network.\n");
-                                  return MISSING; }
-  if (sh->players == NULL) { fprintf(stderr, "No players.\n");  return MISSING; }
-  if (!sh->initialized_players) { fprintf(stderr, "Uninitialized players.\n");
-                                  return MISSING; }
+  if (sh->eq_masses != NULL && sh->eq_nPlayers == sh->nPlayers) return 1;
+  fprintf(stderr, "No equilibrium to start from. Use 'run frankwolfe'.\n");
+  return 0;
+}
 
-  struct VPPopulation *v_players = ShellPlayers_to_VPPopulation(sh, sh->nPlayers);
+static double warm_proba(double **x, int u, int v, int *neighbours, int d)
+/* Renvoie la proportion p_uv du flot x sortant de u, -1 si u n'est pas
+ * traversé par le flot */
+{
+  double out = 0;
+  for (int k=0; k<d; k++) out += x[u][neighbours[k]];
+  if (out <= 0) return -1;
 
-  double t0 = clock();
-  double previous_cc = 0;
+  double p = x[u][v] / out;
+  return (p < WARM_MIN_PROBA) ? WARM_MIN_PROBA : p;
+}
 
-  for (int iter=0; sh->exec_mode & (STOP | STOP_CCC) || iter<sh->nIter; iter++)
-  /* Boucle principale */
+static void warm_start_SBPlayers(struct Shell *sh, struct SBPlayer *players)
+/* Y_p = - \sum_{uv \in p} log p_uv : le logit redonne le flot d'équilibre */
+{
+  for (int i=0; i<sh->nPlayers; i++)
   {
-    reset_masses(sh->net);
-    /* Calcul de la masse */
-    for (int p=0; p<sh->nPlayers; p++)
-    /* CALCUL DE LA MASSE & DISTRIBUTIONS : Parcourss de toutes les populations */
+    double **x = sh->eq_masses[i];
+    struct List *paths = players[i].paths;
+    int k = 0;
+    while (!is_empty(paths))
     {
-      double **mass = mass_spread(p, v_players, 0);
-
-      for (int i=0; i<sh->g->n; i++) for (int j=0; j<sh->g->n; j++)
-        sh->net->masses[i][j] += mass[i][j];
-
-      for (int i=0; i<sh->g->n; i++) free(mass[i]); /* Libération de mass */
-      free(mass);
+      struct List *path = paths->head;
+      players[i].Y_uv[k] = 0;
+      int u = *((int*) path->head);
+      for (path = path->tail; !is_empty(path); path = path->tail)
+      {
+        int v = *((int*) path->head);
+        double out = 0;
+        for (int w=0; w<sh->g->n; w++) out += x[u][w];
+        double p = (out > 0) ? x[u][v] / out : 1;
+        if (p < WARM_MIN_PROBA) p = WARM_MIN_PROBA;
+        players[i].Y_uv[k] -= log(p);
+        u = v;
+      }
+      k ++;
+      paths = paths->tail;
     }
+  }
+  return ;
+}
 
-    double **cost_mat = mcost_matrix(sh->net); /* Précalcul de la matrice des coûts */
-    /* Ajustement de Gamma - seulement à la première itération */
-    if (!iter && sh->exec_mode & GAMMA_CORRECTION)
-    {
-      cst_gamma = 1 / net_d2potential(sh->net);
-      printf("Cst Gamma : %lf\n", cst_gamma);
-    }
-    else if (!iter)
+static void warm_start_VPPopulation(struct Shell *sh, struct VPPopulation *pop)
+/* Y_uv = W_v - log p_uv, en respectant l'ordre topologique */
+{
+  for (int p=0; p<sh->nPlayers; p++)
+  for (int u=pop[p].sink-1; u>=pop[p].source; u--)
+  {
+    struct VertexPlayer *player = &pop[p].players[u];
+    for (int k=0; k<player->d; k++)
     {
-      printf("Cst Gamma : %lf\n", cst_gamma);
+      int v = player->neighbours[k];
+      double p_uv = warm_proba(sh->eq_masses[p], u, v,
+                               player->neighbours, player->d);
+      if (p_uv > 0 && pop[p].players[v].W_u != -INFINITY)
+        player->Y_uv[k] = pop[p].players[v].W_u - log(p_uv);
     }
 
-    /* Convergence en distribution */
-    if (iter && sh->exec_mode & STOP && has_converged(sh, sh->precision,
-                                                      v_players, cost_mat))
+    /* Recalcul des W_uv et W_u à évaluations inchangées */
+    double *zero = new_distrib(player->d);
+    update_eval_VertexPlayer(u, pop[p].players, zero, pop[p].sink);
+    free(zero);
+  }
+  return ;
+}
+
+static void warm_start_VBPopulation(struct Shell *sh, struct VBPopulation *pop)
+/* Idem pour les bandits */
+{
+  for (int p=0; p<sh->nPlayers; p++)
+  for (int u=pop[p].sink-1; u>=pop[p].source; u--)
+  {
+    struct VertexBandit *bandit = &pop[p].bandits[u];
+    int d = bandit->d;
+    for (int k=0; k<d; k++)
+    {
+      int v = bandit->neighbours[k];
+      double p_uv = warm_proba(sh->eq_masses[p], u, v, bandit->neighbours, d);
+      if (p_uv > 0 && pop[p].bandits[v].W_u != -INFINITY)
+        bandit->Y_uv[k] = pop[p].bandits[v].W_u - log(p_uv);
+      bandit->W_uv[k] = pop[p].bandits[v].W_u - bandit->Y_uv[k];
+    }
+
+    double W_max = max(bandit->W_uv, d);
+    if (W_max == -INFINITY) { bandit->W_u = -INFINITY; continue; }
+    bandit->W_u = 0;
+    for (int k=0; k<d; k++) bandit->W_u += exp(bandit->W_uv[k] - W_max);
+    bandit->W_u = W_max + log(bandit->W_u);
+  }
+  return ;
+}
+
+/* *************** REPRISE *************** */
+
+/* Un run laisse ses joueurs dans sh (keep_learned) au lieu de les libérer ;
+ * run ... resume les reprend (resume_learned) tant que le graphe et les
+ * couples source/destination n'ont pas changé. Les masses sont relues dans
+ * sh->players, les supports élagués sont conservés. */
+
+static void learned_couple(struct Shell *sh, int p, int *source, int *sink)
+/* Couple source/destination du joueur p de l'état appris */
+{
+  if (sh->learned_mode & MODE_PATHS)
+  {
+    struct SBPlayer *players = sh->learned;
+    *source = players[p].source; *sink = players[p].sink;
+  }
+  else if (sh->learned_mode & MODES_VERTEX)
+  {
+    struct VPPopulation *pop = sh->learned;
+    *source = pop[p].source; *sink = pop[p].sink;
+  }
+  else
+  {
+    struct VBPopulation *pop = sh->learned;
+    *source = pop[p].source; *sink = pop[p].sink;
+  }
+  return ;
+}
+
+static int learned_compatible(struct Shell *sh, int mode)
+{
+  if (!(sh->learned_mode & mode) || sh->learned_nPlayers != sh->nPlayers
+      || sh->learned_n != sh->g->n)
+    return FALSE;
+  for (int p=0; p<sh->nPlayers; p++)
+  {
+    int source, sink;
+    learned_couple(sh, p, &source, &sink);
+    if (source != sh->players[p].source || sink != sh->players[p].sink)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static void *resume_learned(struct Shell *sh, int mode, int ***vertices)
+/* Renvoie l'état appris pour le mode 'mode' (MODE_PATHS, MODES_VERTEX ou
+ * MODE_BANDIT) si le run le reprend, et le retire de sh ; NULL sinon, après
+ * avoir oublié l'ancien état. Fixe le décalage des pas. */
+{
+  sh->iter_offset = 0;
+  if (!(sh->exec_mode & RESUME)) { forget_learned(sh); return NULL; }
+  if (!learned_compatible(sh, mode))
+  {
+    fprintf(stderr, "No learned state to resume from. Starting afresh.\n");
+    forget_learned(sh);
+    return NULL;
+  }
+
+  void *players = sh->learned;
+  for (int p=0; p<sh->nPlayers; p++)
+  {
+    if (mode & MODE_PATHS) ((struct SBPlayer*) players)[p].mass = sh->players[p].mass;
+    else if (mode & MODES_VERTEX)
+      ((struct VPPopulation*) players)[p].mass = sh->players[p].mass;
+    else ((struct VBPopulation*) players)[p].mass = sh->players[p].mass;
+  }
+  if (!(sh->exec_mode & RESUME_RESET)) sh->iter_offset = sh->learned_iter;
+  if (!(sh->exec_mode & SILENT))
+    fprintf(stderr, "Resuming after %lld iterations\n", sh->learned_iter);
+
+  if (vertices != NULL) *vertices = sh->learned_vertices;
+  sh->learned_mode = 0; sh->learned = NULL; sh->learned_vertices = NULL;
+  return players;
+}
+
+static void keep_learned(struct Shell *sh, int mode, void *players,
+                         int **vertices)
+/* Garde les joueurs d'un run terminé pour le suivant */
+{
+  forget_learned(sh);
+  sh->learned_mode = mode;
+  sh->learned = players;
+  sh->learned_vertices = vertices;
+  sh->learned_nPlayers = sh->nPlayers;
+  sh->learned_n = sh->g->n;
+  sh->learned_iter = sh->iter_offset + ((sh->steps > 0) ? sh->steps : 0);
+  return ;
+}
+
+static int prune_due(struct Shell *sh, int iter)
+/* Renvoie 1 si les supports doivent être réexaminés à l'itération iter */
+{
+  return sh->prune_threshold > 0 && iter && !(iter % sh->prune_period);
+}
+
+static void print_optimality_gap(struct Shell *sh)
+/* Affiche l'écart au potentiel optimal, s'il est connu */
+{
+  if (isnan(sh->opt_potential)) return;
+  double potential = net_potential(sh->net);
+  fprintf(stderr, "Optimality gap : %g\n",
+          (potential - sh->opt_potential) / sh->opt_potential);
+  return ;
+}
+
+/* *************** PERTURBATIONS *************** */
+
+/* Les perturbations programmées par at sont appliquées au début de
+ * l'itération T (avant le premier événement d'instant >= T en simulation) :
+ * au graphe, au réseau et aux joueurs du shell, puis aux joueurs du run, dont
+ * on ne touche que ce qui dépend de l'arc ou du joueur concerné. */
+
+static const char *perturbation_invalid(struct Shell *sh, struct Perturbation *p)
+/* Raison pour laquelle p ne s'applique pas au graphe et aux joueurs
+ * actuels, NULL si elle s'applique */
+{
+  int n = sh->g->n, u = p->u, v = p->v;
+  if (p->kind == PERTURB_MASS)
+    return (u < sh->nPlayers) ? NULL : "no such player";
+  if (u >= n || v >= n || !sh->g->network[u][v]) return "no such edge";
+  if (p->kind == PERTURB_COST)
+    return (sh->exec_mode & MODE_SIMU) ? "queues do not use edge costs" : NULL;
+
+  /* Un retrait ne doit couper aucun joueur de sa destination */
+  const char *why = NULL;
+  sh->g->network[u][v] = 0;
+  for (int i=0; i<sh->nPlayers && why == NULL; i++)
+    if (!connected(sh->players[i].source, sh->players[i].sink, sh->g))
+      why = "it would disconnect a player";
+  sh->g->network[u][v] = 1;
+  return why;
+}
+
+static void perturb_shell(struct Shell *sh, struct Perturbation *p)
+/* Applique p au graphe, au réseau et aux joueurs du shell */
+{
+  int u = p->u, v = p->v;
+  if (p->kind == PERTURB_COST)
+  {
+    sh->net->cost[u][v] = p->fun;
+    sh->net->dcost[u][v] = p->dfun;
+    sh->net->d2cost[u][v] = p->d2fun;
+  }
+  else if (p->kind == PERTURB_REMOVE)
+  {
+    sh->g->network[u][v] = 0;
+    sh->net->graph[u][v] = 0;
+    sh->net->masses[u][v] = 0;
+  }
+  else sh->players[u].mass = p->mass;
+  forget_equilibrium(sh);
+  return ;
+}
+
+static void perturb_VPPopulation(struct Shell *sh, struct Perturbation *p,
+                                 struct VPPopulation *pop)
+{
+  if (p->kind == PERTURB_REMOVE)
+    remove_edge_VPPopulation_set(pop, sh->nPlayers, p->u, p->v);
+  else if (p->kind == PERTURB_MASS) set_VPPopulation_mass(p->mass, pop, p->u);
+  return ;
+}
+
+static void perturb_run(struct Shell *sh, double T, void *players, void *play)
+/* Applique les perturbations dues en T. players : les joueurs du run,
+ * struct SBPlayer (MODE_PATHS), VPPopulation (MODES_VERTEX, 'play' étant la
+ * population qui joue si elle est distincte), VBPopulation (MODE_BANDIT) ou
+ * le SimulatedNetwork (MODE_SIMU) */
+{
+  struct Perturbation *p;
+  while ((p = due_Perturbation(sh->perturb, T)) != NULL)
+  {
+    const char *why = perturbation_invalid(sh, p);
+    int u = p->u, v = p->v;
+
+    /* Simulation : la masse d'un joueur s'ajoute au débit de son flux, qui
+     * ne peut ni apparaître ni disparaître en cours de route */
+    double rate = 0;
+    if (why == NULL && sh->exec_mode & MODE_SIMU && p->kind == PERTURB_MASS)
+    {
+      struct SimulatedNetwork *snet = players;
+      int s = sh->players[u].source, t = sh->players[u].sink;
+      rate = snet->lambda[s][t] - sh->players[u].mass + p->mass;
+      if (snet->lambda[s][t] <= 0 || rate <= 0)
+        why = "a flow cannot start or stop during a simulation";
+    }
+    if (why != NULL) { perturbation_skipped(p, T, why); continue; }
+
+    perturb_shell(sh, p);
+    if (sh->exec_mode & MODE_PATHS)
+    {
+      struct SBPlayer *sb_players = players;
+      if (p->kind == PERTURB_REMOVE)
+        remove_edge_SBPlayers(sb_players, sh->nPlayers, u, v);
+      else if (p->kind == PERTURB_MASS) sb_players[u].mass = p->mass;
+    }
+    else if (sh->exec_mode & MODES_VERTEX)
+    {
+      perturb_VPPopulation(sh, p, players);
+      if (play != NULL && play != players) perturb_VPPopulation(sh, p, play);
+    }
+    else if (sh->exec_mode & MODE_BANDIT)
     {
-      if (!(sh->exec_mode & SILENT))
-        fprintf(stderr, "\x1b[1K\rConverged with %d steps.\n", iter + 1);
-      else fprintf(stderr, "Converged with %d steps.\n", iter + 1);
+      if (p->kind == PERTURB_REMOVE)
+        remove_edge_VBPopulation_set(players, sh->nPlayers, u, v);
+      else if (p->kind == PERTURB_MASS) set_VBPopulation_mass(p->mass, players, u);
+    }
+    else if (sh->exec_mode & MODE_SIMU)
+    {
+      struct SimulatedNetwork *snet = players;
+      if (p->kind == PERTURB_REMOVE) remove_edge_SimulatedNetwork(snet, u, v);
+      else set_flow_rate(snet, sh->players[u].source, sh->players[u].sink, rate);
+    }
+    perturbation_applied(sh->perturb, p, T);
+  }
+  return ;
+}
+
+static void check_recovery(struct Shell *sh, int iter, double **cost_mat)
+/* Rétabli de la dernière perturbation dès que l'écart relatif de Wardrop
+ * repasse sous recovery_tol */
+{
+  if (sh->perturb == NULL || sh->perturb->recovering < 0) return ;
+  if (relative_gap(sh, cost_mat) <= sh->recovery_tol)
+    perturbation_recovered(sh->perturb, iter);
+  return ;
+}
+
+/* *************** SIMULATION PATHS *************** */
+
+static int shell_simu_sb(struct Shell *sh)
+/* Fait la simulation */
+{
+  if (sh->g == NULL)   { fprintf(stderr, "No graph.\n");   return MISSING; }
+  if (sh->net == NULL) { fprintf(stderr, "No network.\n"); return MISSING; }
+  if (!sh->initialized_network) { fprintf(stderr, "Uninitialized network.\n");
+                                  return MISSING; }
+  if (sh->players == NULL) { fprintf(stderr, "No players.\n");  return MISSING; }
+  if (!sh->initialized_players) { fprintf(stderr, "Uninitialized players.\n");
+                                  return MISSING; }
+
+  /* Remarque : si les joueurs sont non-initialisés, se préparer à une explosion
+   * de même que si le network n'est pas initalisé... */
+
+  /* Chemins calculés ici, sauf s'ils sont partagés (sweep, repeat) */
+  int **vertices = NULL;
+  struct SBPlayer *sb_players = resume_learned(sh, MODE_PATHS, &vertices);
+  if (sb_players == NULL)
+  {
+    vertices = (sh->paths == NULL) ? vertices_array(sh->g->n) : NULL;
+    sb_players = ShellPlayers_to_SBPlayers(sh, sh->nPlayers, vertices);
+    if (sh->exec_mode & WARM_START && warm_start_available(sh))
+      warm_start_SBPlayers(sh, sb_players);
+    if (sh->prune_threshold > 0)
+      prune_SBPlayers(sb_players, sh->nPlayers, sh->prune_threshold,
+                      sh->prune_period);
+  }
+
+  struct Schedule *sched = new_Schedule(sh->schedule, sh->schedule_period,
+                                       sh->g->n, sh->nPlayers);
+  double cst_gamma = sh->cst_gamma;
+  clock_t t0 = clock();
+  struct Profile *prof = sh->profile;
+
+  for (int iter=0; sh->exec_mode & (STOP | STOP_GAP) || iter<sh->nIter; iter++)
+  /* Boucle principale */
+  {
+    sh->steps = iter + 1;
+    profile_iteration(prof, iter);
+    perturb_run(sh, iter, sb_players, NULL);
+
+    //aff_SBPlayer_score(0, sb_players);
+
+    reset_masses(sh->net); /* Reset des masses */
+    for (int i=0; i<sh->nPlayers; i++) /* Calcul des distributions - MàJ des masses */
+    {
+      profile_phase(prof, PHASE_DISTRIB);
+      double *distrib = SBPlayer_distrib(i, sb_players, 0);
+      profile_phase(prof, PHASE_MASS);
+      add_mass_of_player(sh->net, sb_players[i].mass,
+                         sb_players[i].paths, distrib);
+      free(distrib);
+    }
+    profile_phase(prof, PHASE_COST);
+    double **cost_mat = mcost_matrix(sh->net); /* Précalcul de la matrice des coûts */
+    profile_phase(prof, PHASE_CHECK);
+    check_recovery(sh, iter, cost_mat);
+    if (iter && sh->exec_mode & STOP && !pending_Perturbations(sh->perturb)
+        && has_converged(sh, sh->precision, sb_players, cost_mat))
+    {
+      report_converged(sh, iter + 1);
       free_cost_matrix(cost_mat, sh->g->n);
       break;
     }
-    else if (sh->exec_mode & STOP && !(sh->exec_mode & SILENT))
-      fprintf(stderr, "\x1b[1K\rDid not converged with %d steps", iter + 1);
+    else if (sh->exec_mode & STOP)
+      report_progress(sh, iter + 1);
 
-    for (int p=0; p<sh->nPlayers; p++)
-    for (int i=v_players[p].sink-1; i>=v_players[p].source; i--)
-    /* CALCUL DES CoÜTS - MàJ des ÉVALUATIONS */
-    /* Respecter l'ordre topologique ! */
+    if (gap_reached(sh, iter, cost_mat))
     {
-      int deg = v_players[p].players[i].d;
-      double *costs = new_distrib(deg);
-      for (int j=0; j<deg; j++)
-      {
-        int v = v_players[p].players[i].neighbours[j];
-        costs[j] = gamma_iter(iter) * cost_mat[i][v];
-      }
-      update_eval_VertexPlayer(i, v_players[p].players, costs,
-                               v_players[p].sink);
-      free(costs);
+      report_converged(sh, iter + 1);
+      free_cost_matrix(cost_mat, sh->g->n);
+      break;
+    }
+
+    profile_phase(prof, PHASE_UPDATE);
+    cst_gamma = schedule_observe(sched, sh->net, cost_mat, iter, cst_gamma);
+    for (int i=0; i<sh->nPlayers; i++) /* Calcul des coûts - MàJ des évaluations */
+    {
+      double *distrib = fast_eval_player(i, sb_players, cost_mat);
+      double gamma = schedule_player_gamma(sched, i, distrib, sb_players[i].n,
+                                           gamma_iter(sh, cst_gamma, iter),
+                                           cst_gamma);
+      for (int j=0; j<sb_players[i].n; j++)
+        sb_players[i].Y_uv[j] += distrib[j] * gamma;
+      if (sb_players[i].support != NULL) sb_players[i].support->lag += gamma;
+      free(distrib);
     }
+    if (prune_due(sh, iter + 1))
+      rescan_SBPlayers(sb_players, sh->nPlayers, cost_mat);
+
+    profile_phase(prof, PHASE_LOG);
+    if (sh->exec_mode & POTENTIAL && sh->out != NULL)
+      output_potential(sh, iter + 1);
+    else if (sh->exec_mode & POTENTIAL)
+    {
+      fprintf(stderr, "@%3d : potential = %.4f", iter+1, net_potential(sh->net));
+      if (sh->exec_mode & STOP_GAP) fprintf(stderr, ", gap = %g", sh->gap);
+      if (sh->prune_threshold > 0)
+        fprintf(stderr, ", support = %d",
+                support_size_SBPlayers(sb_players, sh->nPlayers));
+      fprintf(stderr, "\n");
+    }
+
+
+    profile_phase(prof, PHASE_COST);
+    free_cost_matrix(cost_mat, sh->g->n);
+  }
+  profile_finish(prof);
+
+  if (sh->exec_mode & POTENTIAL)
+    for (int i=0; i<sh->nPlayers; i++) aff_SBPlayer_score(i, sb_players);
+  print_optimality_gap(sh);
+
+  if (sh->exec_mode & TIME)
+  {
+    clock_t t1 = clock();
+    fprintf(stderr, "Time used : %lf\n", (t1 - t0) / (CLOCKS_PER_SEC * 1.));
+  }
+
+
+  free_Schedule(sched);
+  /* Chemins partagés : pas d'état à garder, ils ne sont pas à nous */
+  if (vertices != NULL) keep_learned(sh, MODE_PATHS, sb_players, vertices);
+  else release_SBPlayers(sb_players, sh->nPlayers);
+  return NORMAL;
+}
+
+/* *************** SIMULATION VERTEX *************** */
+
+static void spread_VPPopulation(struct Shell *sh, struct VPPopulation *pop)
+/* Remplace les masses du réseau par celles qu'envoient les populations */
+{
+  reset_masses(sh->net);
+  for (int p=0; p<sh->nPlayers; p++)
+  /* CALCUL DE LA MASSE & DISTRIBUTIONS : Parcourss de toutes les populations */
+  {
+    double **mass = mass_spread(p, pop, 0);
+
+    for (int i=0; i<sh->g->n; i++) for (int j=0; j<sh->g->n; j++)
+      sh->net->masses[i][j] += mass[i][j];
+
+    free_cost_matrix(mass, sh->g->n);
+  }
+  return ;
+}
+
+static void update_VPPopulation(struct Shell *sh, struct VPPopulation *pop,
+                                double **cost_mat, double gamma)
+/* Ajoute gamma * cost_mat aux évaluations de toutes les populations */
+{
+  for (int p=0; p<sh->nPlayers; p++)
+  for (int i=pop[p].sink-1; i>=pop[p].source; i--)
+  /* CALCUL DES CoÜTS - MàJ des ÉVALUATIONS */
+  /* Respecter l'ordre topologique ! */
+  {
+    int deg = pop[p].players[i].d;
+    double *costs = new_distrib(deg);
+    for (int j=0; j<deg; j++)
+    {
+      int v = pop[p].players[i].neighbours[j];
+      costs[j] = gamma * cost_mat[i][v];
+    }
+    update_eval_VertexPlayer(i, pop[p].players, costs, pop[p].sink);
+    free(costs);
+  }
+  return ;
+}
+
+static void lookahead_VPPopulation(struct Shell *sh, struct VPPopulation *base,
+                                   struct VPPopulation *play, double **cost_mat,
+                                   double gamma)
+/* play <- base + gamma * cost_mat, sans toucher à base.
+ * Hedge optimiste : cost_mat est le coût de l'itération précédente ;
+ * extra-gradient : c'est le coût mesuré en base. */
+{
+  for (int p=0; p<sh->nPlayers; p++)
+  for (int i=0; i<sh->g->n; i++)
+    memcpy(play[p].players[i].Y_uv, base[p].players[i].Y_uv,
+           base[p].players[i].d * sizeof(double));
+  update_VPPopulation(sh, play, cost_mat, gamma);
+  return ;
+}
+
+static int shell_simu_vertex(struct Shell *sh)
+/* Simulation d'un joueur par sommet. En modes optimiste et extra-gradient, la
+ * masse est envoyée par une seconde population 'play', décalée d'un pas de
+ * l'état courant dans la direction d'un coût prédit. */
+{
+  /* Vérifications préliminaires pour éviter une explosion en vol */
+  if (sh->g == NULL)   { fprintf(stderr, "No graph.\n"); return MISSING; }
+  if (sh->net == NULL) { fprintf(stderr, "No network.\n"); return MISSING; }
+  if (!sh->initialized_network) { fprintf(stderr, "Uninitialized network.\n");
+                                  return MISSING; }
+  if (sh->players == NULL) { fprintf(stderr, "No players.\n");  return MISSING; }
+  if (!sh->initialized_players) { fprintf(stderr, "Uninitialized players.\n");
+                                  return MISSING; }
+
+  struct VPPopulation *v_players = resume_learned(sh, MODES_VERTEX, NULL);
+  if (v_players == NULL)
+  {
+    v_players = ShellPlayers_to_VPPopulation(sh, sh->nPlayers);
+    if (sh->exec_mode & WARM_START && warm_start_available(sh))
+      warm_start_VPPopulation(sh, v_players);
+  }
+
+  /* Population qui joue, et coût prédit (optimiste) */
+  int lookahead = sh->exec_mode & (MODE_OPTIMISTIC | MODE_EXTRA);
+  struct VPPopulation *v_play = v_players;
+  double **prev_cost = NULL;
+  if (lookahead) v_play = ShellPlayers_to_VPPopulation(sh, sh->nPlayers);
+  if (sh->exec_mode & MODE_OPTIMISTIC) prev_cost = new_zero_matrix(sh->g->n);
+  if (sh->prune_threshold > 0) /* L'élagage porte sur la population qui joue */
+    prune_VPPopulation_set(v_play, sh->nPlayers, sh->prune_threshold,
+                           sh->prune_period);
+
+  struct Schedule *sched = new_Schedule(sh->schedule, sh->schedule_period,
+                                       sh->g->n, sh->nPlayers);
+  double cst_gamma = sh->cst_gamma;
+  clock_t t0 = clock();
+  double previous_cc = 0;
+  struct Profile *prof = sh->profile;
+
+  for (int iter=0; sh->exec_mode & (STOP | STOP_CCC | STOP_GAP) || iter<sh->nIter;
+       iter++)
+  /* Boucle principale */
+  {
+    sh->steps = iter + 1;
+    profile_iteration(prof, iter);
+    perturb_run(sh, iter, v_players, v_play);
+    /* Point de jeu : décalage dans la direction du coût prédit */
+    if (sh->exec_mode & MODE_OPTIMISTIC)
+      lookahead_VPPopulation(sh, v_players, v_play, prev_cost,
+                             schedule_gamma(sched,
+                                            gamma_iter(sh, cst_gamma, iter),
+                                            cst_gamma));
+    else if (sh->exec_mode & MODE_EXTRA)
+    {
+      spread_VPPopulation(sh, v_players);
+      double **base_cost = mcost_matrix(sh->net);
+      lookahead_VPPopulation(sh, v_players, v_play, base_cost,
+                             schedule_gamma(sched,
+                                            gamma_iter(sh, cst_gamma, iter),
+                                            cst_gamma));
+      free_cost_matrix(base_cost, sh->g->n);
+    }
+
+    if (prune_due(sh, iter)) rescan_VPPopulation_set(v_play, sh->nPlayers);
+
+    /* Calcul de la masse */
+    profile_phase(prof, PHASE_MASS);
+    spread_VPPopulation(sh, v_play);
+
+    profile_phase(prof, PHASE_COST);
+    double **cost_mat = mcost_matrix(sh->net); /* Précalcul de la matrice des coûts */
+    /* Ajustement de Gamma - seulement à la première itération */
+    if (!iter && sh->exec_mode & GAMMA_CORRECTION)
+      cst_gamma = 1 / net_d2potential(sh->net);
+    if (!iter && !(sh->exec_mode & SILENT))
+      printf("Cst Gamma : %lf\n", cst_gamma);
+
+    /* Convergence en distribution */
+    profile_phase(prof, PHASE_CHECK);
+    check_recovery(sh, iter, cost_mat);
+    if (iter && sh->exec_mode & STOP && !pending_Perturbations(sh->perturb)
+        && has_converged(sh, sh->precision, v_play, cost_mat))
+    {
+      report_converged(sh, iter + 1);
+      free_cost_matrix(cost_mat, sh->g->n);
+      break;
+    }
+    else if (sh->exec_mode & STOP)
+      report_progress(sh, iter + 1);
+
+    /* Convergence en écart relatif */
+    if (gap_reached(sh, iter, cost_mat))
+    {
+      report_converged(sh, iter + 1);
+      free_cost_matrix(cost_mat, sh->g->n);
+      break;
+    }
+
+    profile_phase(prof, PHASE_UPDATE);
+    cst_gamma = schedule_observe(sched, sh->net, cost_mat, iter, cst_gamma);
+    update_VPPopulation(sh, v_players, cost_mat,
+                        schedule_gamma(sched,
+                                       gamma_iter(sh, cst_gamma, iter),
+                                       cst_gamma));
 
     /* AFFICHAGE DU POTENTIEL */
-    if (sh->exec_mode & POTENTIAL) fprintf(stderr, "%d %f\n",
-                         iter+1, net_potential(sh->net));
+    profile_phase(prof, PHASE_LOG);
+    if (sh->exec_mode & POTENTIAL && sh->out != NULL)
+      output_potential(sh, iter + 1);
+    else if (sh->exec_mode & POTENTIAL)
+    {
+      fprintf(stderr, "%d %f", iter+1, net_potential(sh->net));
+      if (sh->exec_mode & STOP_GAP) fprintf(stderr, " %g", sh->gap);
+      if (sh->prune_threshold > 0)
+        fprintf(stderr, " %d", support_size_VPPopulation_set(v_play, sh->nPlayers));
+      fprintf(stderr, "\n");
+    }
 
     /* Convergence en coût cumulé */
+    profile_phase(prof, PHASE_CHECK);
     if (sh->exec_mode & STOP_CCC)
     {
       double current_cc = net_potential(sh->net);
       double ccc = 100 * iter * (previous_cc - current_cc) / current_cc;
       //printf("%lf\n", ccc);
-      if (iter > 1 && ccc >= 0 && ccc <= sh->precision)
+      if (iter > 1 && ccc >= 0 && ccc <= sh->precision
+          && !pending_Perturbations(sh->perturb))
       {
-       if (!(sh->exec_mode & SILENT))
-        fprintf(stderr, "\x1b[1K\rConverged with %d steps.\n", iter + 1);
-       else fprintf(stderr, "Converged with %d steps.\n", iter + 1);
+       report_converged(sh, iter + 1);
        free_cost_matrix(cost_mat, sh->g->n);
        break;
       }
-      else if (!(sh->exec_mode & SILENT))
-       fprintf(stderr, "\x1b[1K\rDid not converged with %d steps", iter + 1);
+      else report_progress(sh, iter + 1);
       previous_cc = current_cc;
     }
 
+    profile_phase(prof, PHASE_COST);
+    if (prev_cost != NULL) /* Le coût observé sera la prédiction suivante */
+    {
+      double **tmp = prev_cost;
+      prev_cost = cost_mat; cost_mat = tmp;
+    }
     free_cost_matrix(cost_mat, sh->g->n);
 
 
   }
+  profile_finish(prof);
 
   if (sh->exec_mode & TIME)
   {
@@ -702,9 +1605,14 @@ static int shell_simu_vertex(struct Shell *sh)
     fprintf(stderr, "Time used : %lf\n", (t1 - t0) / (CLOCKS_PER_SEC * 1.));
   }
 
+  print_optimality_gap(sh);
+
   /* FIN : Libération & co */
 
-  free_VPPopulation_set(v_players, sh->nPlayers);
+  free_Schedule(sched);
+  if (prev_cost != NULL) free_cost_matrix(prev_cost, sh->g->n);
+  if (lookahead) free_VPPopulation_set(v_play, sh->nPlayers);
+  keep_learned(sh, MODES_VERTEX, v_players, NULL);
   return NORMAL;
 }
 
@@ -721,48 +1629,127 @@ static int shell_simu_bandit(struct Shell *sh, int k)
   if (!sh->initialized_players) { fprintf(stderr, "Uninitialized players.\n");
                                   return MISSING; }
 
-  struct VBPopulation *pop =
-    ShellPlayers_to_VBPopulation(sh, sh->nPlayers);
+  struct VBPopulation *pop = resume_learned(sh, MODE_BANDIT, NULL);
+  if (pop == NULL)
+  {
+    pop = ShellPlayers_to_VBPopulation(sh, sh->nPlayers);
+    if (sh->exec_mode & WARM_START && warm_start_available(sh))
+      warm_start_VBPopulation(sh, pop);
+    if (sh->prune_threshold > 0)
+      prune_VBPopulation_set(pop, sh->nPlayers, sh->prune_threshold,
+                             sh->prune_period);
+  }
+
+  struct Schedule *sched = new_Schedule(sh->schedule, sh->schedule_period,
+                                       sh->g->n, sh->nPlayers);
+  double cst_gamma = sh->cst_gamma;
+  struct Profile *prof = sh->profile;
 
-  for (int iter=0; sh->exec_mode & STOP || iter<sh->nIter; iter++)
+  for (int iter=0; sh->exec_mode & (STOP | STOP_GAP) || iter<sh->nIter; iter++)
   /* Boucle principale */
   {
-    if (sh->exec_mode & POTENTIAL)
-    {
+    sh->steps = iter + 1;
+    profile_iteration(prof, iter);
+    perturb_run(sh, iter, pop, NULL);
+    if (prune_due(sh, iter)) rescan_VBPopulation_set(pop, sh->nPlayers);
+
+    profile_phase(prof, PHASE_MASS);
+    if (sh->exec_mode & (POTENTIAL | STOP_GAP))
       bandit_measure_costs(pop, sh->nPlayers, sh->net, 0);
-      fprintf(stderr, "%d %f\n", iter+1, net_potential(sh->net));
-    }
 
+    profile_phase(prof, PHASE_COST);
     double **cost_mat = mcost_matrix(sh->net); /* Précalcul de la matrice des coûts */
-    if (iter && sh->exec_mode & STOP && has_converged(sh, sh->precision,
-                                                      pop, cost_mat))
+    profile_phase(prof, PHASE_CHECK);
+    int gap_ok = gap_reached(sh, iter, cost_mat);
+
+    profile_phase(prof, PHASE_LOG);
+    if (sh->exec_mode & POTENTIAL && sh->out != NULL)
+      output_potential(sh, iter + 1);
+    else if (sh->exec_mode & POTENTIAL)
+    {
+      fprintf(stderr, "%d %f", iter+1, net_potential(sh->net));
+      if (sh->exec_mode & STOP_GAP) fprintf(stderr, " %g", sh->gap);
+      if (sh->prune_threshold > 0)
+        fprintf(stderr, " %d", support_size_VBPopulation_set(pop, sh->nPlayers));
+      fprintf(stderr, "\n");
+    }
+
+    profile_phase(prof, PHASE_CHECK);
+    if (gap_ok || (iter && sh->exec_mode & STOP
+                   && !pending_Perturbations(sh->perturb)
+                   && has_converged(sh, sh->precision, pop, cost_mat)))
     {
-      fprintf(stderr, "\x1b[1K\rConverged with %d steps.\n", iter + 1);
+      report_converged(sh, iter + 1);
       free_cost_matrix(cost_mat, sh->g->n);
       break;
     }
-    else if (sh->exec_mode & STOP && !(sh->exec_mode & SILENT))
-      fprintf(stderr, "\x1b[1K\rDid not converged with %d steps", iter + 1);
+    else if (sh->exec_mode & STOP)
+      report_progress(sh, iter + 1);
     free_cost_matrix(cost_mat, sh->g->n);
 
+    profile_phase(prof, PHASE_MASS);
     bandit_measure_costs(pop, sh->nPlayers, sh->net, 0);
-    if (isnan(net_potential(sh->net))) return NORMAL;
+    if (isnan(net_potential(sh->net))) break;
 
+    profile_phase(prof, PHASE_COST);
+    cost_mat = mcost_matrix(sh->net);
+    profile_phase(prof, PHASE_UPDATE);
+    cst_gamma = schedule_observe(sched, sh->net, cost_mat, iter, cst_gamma);
+    check_recovery(sh, iter, cost_mat);
+    free_cost_matrix(cost_mat, sh->g->n);
+
+    /* Tirage des chemins joués et de leurs coûts bruités */
+    profile_phase(prof, PHASE_DISTRIB);
     reset_VBPopulation_noisy_costs(pop, sh->nPlayers);
     for (int i=0; i<k; i++)
-      bandit_add_noisy_measure(pop, sh->nPlayers, sh->net, epsilon_iter(iter));
+      bandit_add_noisy_measure(pop, sh->nPlayers, sh->net, epsilon_iter(sh, iter));
 
 
-    bandit_update_scores(pop, sh->nPlayers, sh->net, gamma_iter(iter),
-                         epsilon_iter(iter), k);
+    profile_phase(prof, PHASE_UPDATE);
+    bandit_update_scores(pop, sh->nPlayers, sh->net,
+                         schedule_gamma(sched,
+                                        gamma_iter(sh, cst_gamma, iter),
+                                        cst_gamma),
+                         epsilon_iter(sh, iter), k);
 
   }
+  profile_finish(prof);
 
-  free_VBPopulation_set(pop, sh->nPlayers);
+  print_optimality_gap(sh);
+  free_Schedule(sched);
+  keep_learned(sh, MODE_BANDIT, pop, NULL);
 
   return NORMAL;
 }
 
+static void simulate_perturbed(struct Shell *sh, struct SimulatedNetwork *snet)
+/* Boucle de la simulation séquentielle avec perturbations, appliquées avant
+ * le premier événement qui les suit. Le rétablissement se mesure sur la
+ * latence des paquets arrivés, par fenêtres de durée recovery_window. */
+{
+  struct Perturbations *ps = sh->perturb;
+  struct Welford *latency = &sh->stats->all_latency;
+  ps->unit = "time units";
+
+  for (int iter=0; iter<sh->nIter; iter++)
+  {
+    struct Event event;
+    if (!next_event(&event, snet->qevents))
+    { fprintf(stderr, "No event ! \n"); exit(EXIT_FAILURE); }
+
+    int recovering = ps->recovering;
+    perturb_run(sh, event.T, snet, NULL);
+    if (ps->recovering != recovering && ps->recovering >= 0)
+      start_latency_window(ps, event.T, latency->n, latency->n * latency->mean,
+                           sh->recovery_window);
+
+    treat_event(snet, event);
+    latency_window(ps, event.T, latency->n, latency->n * latency->mean,
+                   sh->recovery_tol);
+  }
+  return ;
+}
+
 static int shell_simu_queues(struct Shell *sh)
 {
   if (sh->g == NULL)   { fprintf(stderr, "No graph.\n"); return MISSING; }
@@ -773,106 +1760,349 @@ static int shell_simu_queues(struct Shell *sh)
   if (!sh->initialized_players) { fprintf(stderr, "Uninitialized players.\n");
                                   return MISSING; }
 
-  struct SimulatedNetwork *snet = new_SimulatedNetwork(sh->g, sh->precision);
+  clock_t t0 = clock();
+  struct SimulatedNetwork *snet = new_SimulatedNetwork(sh->g, sh->precision,
+                                                       sh->queue_kind);
+  snet->delay = sh->delay;
+  if (sh->threads > 1 && sh->delay <= 0)
+  { fprintf(stderr, "Parallel simulation needs a positive delay (set delay)\n");
+    free_SimulatedNetwork(snet); return MISSING; }
+  if (sh->threads <= 1) snet->trace = new_Trace(sh->trace_mode, sh->trace_out);
+  else if (sh->trace_chosen && sh->trace_mode != TRACE_OFF)
+    fprintf(stderr, "No packet trace in parallel simulation\n");
+  if (sh->threads > 1 && pending_Perturbations(sh->perturb))
+    fprintf(stderr, "No perturbations in parallel simulation\n");
 
   /* Initialisation des flux */
   for (int p=0; p<sh->nPlayers; p++)
   {
     struct ShellPlayer player = sh->players[p];
-    snet->lambda[player.source][player.sink] = player.mass;
+    snet->lambda[player.source][player.sink] += player.mass;
   }
 
+  free_SimuStats(sh->stats);
+  sh->stats = new_SimuStats(snet->n, snet->lambda);
+  snet->stats  = sh->stats;
+  snet->warmup = sh->warmup;
+
   /* Initialisation des nœuds */
   for (int u=0; u<snet->n; u++)
   {
-    snet->vertex[u].mu = 1; /* FIXME : peut être variable */
-    snet->vertex[u].n  = 1;
+    snet->node[u].mu = 1; /* FIXME : peut être variable */
+    snet->node[u].n  = 1;
     /*update_distrib_SimulatedPlayer(snet->vertex, u, snet->vertex[u].n,
                                    sh->g->n);*/
     //print_distrib(snet->vertex[u].X_uv[sh->players[0].sink], snet->vertex[u].d);
   }
 
   /* Initialisation des événements */
+  init_destinations(snet, sh->g);
+  long long n_events = sh->nIter;
+  struct timespec w0, w1;
+  clock_gettime(CLOCK_MONOTONIC, &w0);
+
+  if (sh->threads > 1)
+    n_events = simulate_parallel(snet, sh->threads, sh->merged_arrivals,
+                                 sh->nIter);
+  else
+  {
+    init_arrivals(snet, sh->merged_arrivals);
+
+    for (int u=0; u<sh->g->n; u++)
+    {
+      //printf("Adding event : UPDATE %d\n", u);
+      struct Event upd_event = new_Event(0, u, UPDATE_DISTRIB, u);
+      add_Event(upd_event, &snet->qevents);
+    }
+
+    if (!(sh->exec_mode & SILENT)) print_EventQueue(snet->qevents);
+
+    /* Simulation */
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+    if (pending_Perturbations(sh->perturb)) simulate_perturbed(sh, snet);
+    else for (int iter=0; iter<sh->nIter; iter++) treat_new_event(snet);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &w1);
+  double t_simu = (w1.tv_sec - w0.tv_sec) + (w1.tv_nsec - w0.tv_nsec) * 1e-9;
+  sh->steps = n_events;
+  free_Trace(snet->trace); /* Vidée avant les affichages qui suivent */
+  snet->trace = NULL;
+  for (int u=0; u<snet->n; u++)
+    close_SimuStats(sh->stats, u, snet->node[u].L, snet->node[u].T);
+
+  spread_Simulated_mass(snet, sh->net);
+
+  /*for (int p=0; p<sh->nPlayers; p++)
+  {
+    int s = sh->players[p].source;
+    int t = sh->players[p].sink;
+    for (int k=0; k<snet->vertex[s].d; k++)
+    {
+      int v = snet->vertex[s].neighbours[k];
+      printf("---- Edge Y_%d-%d : %lf\n", s, v, snet->vertex[s].Y_uv[k]);
+    }
+    for (int u=sh->players[p].source; u<sh->g->n; u++)
+      printf("W_%d^(%d) : %lf\n", u, t, snet->vertex[u].W_u[t]);
+  }*/
+
+  long long int worst = -1;
+  int overloaded_node = -1;
+  for (int u=0; u<snet->n; u++)
+  {
+    if (snet->node[u].n > worst)
+    {
+      worst = snet->node[u].n;
+      overloaded_node = u;
+    }
+  }
+  if (!(sh->exec_mode & SILENT))
+    printf("Most loaded node : %d\n", overloaded_node);
+
+  if (sh->exec_mode & TIME)
+  {
+    clock_t t1 = clock();
+    fprintf(stderr, "Time used : %lf (%s queue)\n",
+            (t1 - t0) / (CLOCKS_PER_SEC * 1.), queue_kind_name(sh->queue_kind));
+    fprintf(stderr, "Events : %lld (%.0f per second, %d thread%s)\n",
+            n_events, n_events / t_simu, sh->threads,
+            (sh->threads > 1) ? "s" : "");
+  }
+
+
+  free_SimulatedNetwork(snet);
+  sh->precision = 0.01;
+  return NORMAL;
+}
+
+/* *************** SOLUTION DE RÉFÉRENCE : FRANK-WOLFE *************** */
+
+static double ***new_player_matrices(int k, int n)
+/* Renvoie k matrices n × n nulles */
+{
+  double ***x = malloc(k * sizeof(double**));
+  if (x == NULL) handle_error("(malloc) new_player_matrices");
+  for (int p=0; p<k; p++) x[p] = new_zero_matrix(n);
+  return x;
+}
+
+static void free_player_matrices(double ***x, int k, int n)
+{
+  for (int p=0; p<k; p++) free_cost_matrix(x[p], n);
+  return free(x);
+}
+
+static void all_or_nothing(struct Shell *sh, double **cost_mat, double ***y)
+/* Affecte toute la masse de chaque joueur sur son plus court chemin.
+ * y[p] reçoit le flot du joueur p. Un calcul par destination. */
+{
+  int n = sh->g->n;
+  int *next = malloc(n * sizeof(int));
+  int *done = calloc(n, sizeof(int));
+  if (next == NULL || done == NULL) handle_error("(malloc) all_or_nothing");
+
   for (int p=0; p<sh->nPlayers; p++)
-  {
-    struct ShellPlayer player = sh->players[p];
-    struct EventID ID  = new_EventID(0, player.source, player.sink);
-    struct Event event = new_Event(0, player.source, NEW_PAQUET, player.sink, ID);
-    add_Event(event, &snet->qevents);
-  }
+  for (int u=0; u<n; u++) for (int v=0; v<n; v++) y[p][u][v] = 0;
 
-  for (int u=0; u<sh->g->n; u++)
+  for (int i=0; i<sh->nPlayers; i++)
   {
-    struct EventID ID  = new_EventID(0, 0, 0);
-    //printf("Adding event : UPDATE %d\n", u);
-    struct Event upd_event = new_Event(0, u, UPDATE_DISTRIB, u, ID);
-    add_Event(upd_event, &snet->qevents);
+    int t = sh->players[i].sink;
+    if (done[t]) continue;
+    done[t] = 1;
+
+    double *d = DAG_distances_to(t, cost_mat, sh->g, next);
+    for (int p=i; p<sh->nPlayers; p++) if (sh->players[p].sink == t)
+    for (int u=sh->players[p].source; u != t && next[u] >= 0; u = next[u])
+      y[p][u][next[u]] += sh->players[p].mass;
+    free(d);
   }
 
-  for (int i=0; i<snet->qevents->n; i++) print_Event(snet->qevents->events[i]);
+  free(next);
+  free(done);
+  return ;
+}
 
-  /* Simulation */
-  for (int iter=0; iter<sh->nIter; iter++) treat_new_event(snet);
+static int shell_simu_frankwolfe(struct Shell *sh)
+/* Calcule l'optimum social (ou l'équilibre de Wardrop) par Frank-Wolfe,
+ * éventuellement conjugué. La solution reste dans sh->net->masses. */
+{
+  if (sh->g == NULL)   { fprintf(stderr, "No graph.\n"); return MISSING; }
+  if (sh->net == NULL) { fprintf(stderr, "No network.\n"); return MISSING; }
+  if (!sh->initialized_network) { fprintf(stderr, "Uninitialized network.\n");
+                                  return MISSING; }
+  if (sh->players == NULL) { fprintf(stderr, "No players.\n");  return MISSING; }
+  if (!sh->initialized_players) { fprintf(stderr, "Uninitialized players.\n");
+                                  return MISSING; }
 
-  spread_Simulated_mass(snet, sh->net);
+  int n = sh->g->n, k = sh->nPlayers;
+  int marginal = !(sh->exec_mode & FW_WARDROP);
+  int conjugate = sh->exec_mode & FW_CONJUGATE;
+  double delta = 0.05; /* Borne sur le coefficient de conjugaison */
 
-  /*for (int p=0; p<sh->nPlayers; p++)
+  double ***x  = new_player_matrices(k, n); /* Flots courants */
+  double ***y  = new_player_matrices(k, n); /* Solutions tout-ou-rien */
+  double ***sb = new_player_matrices(k, n); /* Directions conjuguées */
+  double **dir = new_zero_matrix(n);        /* s_k - x */
+  double **ys  = new_zero_matrix(n);        /* s_k agrégé */
+
+  clock_t t0 = clock();
+
+  /* Initialisation : tout-ou-rien à flot nul */
+  reset_masses(sh->net);
+  double **cost_mat = marginal ? mcost_matrix(sh->net) : cost_matrix(sh->net);
+  all_or_nothing(sh, cost_mat, x);
+  free_cost_matrix(cost_mat, n);
+
+  struct Profile *prof = sh->profile;
+  for (int iter=0; sh->exec_mode & STOP_GAP || iter<sh->nIter; iter++)
   {
-    int s = sh->players[p].source;
-    int t = sh->players[p].sink;
-    for (int k=0; k<snet->vertex[s].d; k++)
+    sh->steps = iter + 1;
+    profile_iteration(prof, iter);
+    /* Flot agrégé */
+    profile_phase(prof, PHASE_MASS);
+    reset_masses(sh->net);
+    for (int p=0; p<k; p++) for (int u=0; u<n; u++) for (int v=0; v<n; v++)
+      sh->net->masses[u][v] += x[p][u][v];
+
+    profile_phase(prof, PHASE_COST);
+    cost_mat = marginal ? mcost_matrix(sh->net) : cost_matrix(sh->net);
+    profile_phase(prof, PHASE_CHECK);
+    sh->gap = relative_gap(sh, cost_mat);
+    profile_phase(prof, PHASE_LOG);
+    if (sh->exec_mode & POTENTIAL && sh->out != NULL)
+      output_potential(sh, iter + 1);
+    else if (sh->exec_mode & POTENTIAL)
+      fprintf(stderr, "%d %f %g\n", iter+1, net_potential(sh->net), sh->gap);
+
+    profile_phase(prof, PHASE_CHECK);
+    if (sh->exec_mode & STOP_GAP && sh->gap <= sh->gap_tol)
     {
-      int v = snet->vertex[s].neighbours[k];
-      printf("---- Edge Y_%d-%d : %lf\n", s, v, snet->vertex[s].Y_uv[k]);
+      fprintf(stderr, "Converged with %d steps.\n", iter + 1);
+      free_cost_matrix(cost_mat, n);
+      break;
     }
-    for (int u=sh->players[p].source; u<sh->g->n; u++)
-      printf("W_%d^(%d) : %lf\n", u, t, snet->vertex[u].W_u[t]);
-  }*/
 
-  long long int worst = -1;
-  int overloaded_node = -1;
-  for (int u=0; u<snet->n; u++)
-  {
-    if (snet->vertex[u].n > worst)
+    /* Direction : meilleure réponse aux coûts courants */
+    profile_phase(prof, PHASE_DISTRIB);
+    all_or_nothing(sh, cost_mat, y);
+    free_cost_matrix(cost_mat, n);
+    profile_phase(prof, PHASE_UPDATE);
+
+    /* Direction conjuguée :
+     * s_k = a.s_{k-1} + (1-a).y_k, avec a tel que s_k - x et s_{k-1} - x
+     * soient conjuguées pour la hessienne (diagonale) de l'objectif. */
+    double a = 0;
+    if (conjugate && iter)
     {
-      worst = snet->vertex[u].n;
-      overloaded_node = u;
+      double N = 0, D = 0;
+      for (int u=0; u<n; u++) for (int v=0; v<n; v++)
+      if (sh->g->network[u][v])
+      {
+        double s_uv = 0, y_uv = 0;
+        for (int p=0; p<k; p++) { s_uv += sb[p][u][v]; y_uv += y[p][u][v]; }
+        double x_uv = sh->net->masses[u][v];
+        double h = link_dcost(sh->net, u, v, x_uv, marginal);
+        N += (s_uv - x_uv) * h * (y_uv - x_uv);
+        D += (s_uv - x_uv) * h * (y_uv - s_uv);
+      }
+      if (D != 0) a = N / D;
+      if (a > 1 - delta) a = 1 - delta;
+      if (a < 0 || isnan(a)) a = 0;
+    }
+
+    for (int p=0; p<k; p++) for (int u=0; u<n; u++) for (int v=0; v<n; v++)
+      sb[p][u][v] = a * sb[p][u][v] + (1 - a) * y[p][u][v];
+
+    /* Recherche linéaire sur le flot agrégé */
+    for (int u=0; u<n; u++) for (int v=0; v<n; v++)
+    {
+      ys[u][v] = 0;
+      for (int p=0; p<k; p++) ys[u][v] += sb[p][u][v];
+      dir[u][v] = ys[u][v] - sh->net->masses[u][v];
     }
+    double tau = line_search(sh->net, sh->net->masses, dir, marginal);
+
+    for (int p=0; p<k; p++) for (int u=0; u<n; u++) for (int v=0; v<n; v++)
+      x[p][u][v] += tau * (sb[p][u][v] - x[p][u][v]);
   }
-  printf("Most loaded node : %d\n", overloaded_node);
+  profile_finish(prof);
 
+  /* Résultats : potentiel de référence et flots des joueurs */
+  reset_masses(sh->net);
+  for (int p=0; p<k; p++) for (int u=0; u<n; u++) for (int v=0; v<n; v++)
+    sh->net->masses[u][v] += x[p][u][v];
 
-  free_SimulatedNetwork(snet);
-  sh->precision = 0.01;
+  forget_equilibrium(sh);
+  sh->eq_masses = x;
+  sh->eq_nPlayers = k; sh->eq_n = n;
+  if (marginal) sh->opt_potential = net_potential(sh->net);
+
+  fprintf(stderr, "Optimal potential : %f (gap %g)\n",
+          net_potential(sh->net), sh->gap);
+
+  if (sh->exec_mode & TIME)
+  {
+    clock_t t1 = clock();
+    fprintf(stderr, "Time used : %lf\n", (t1 - t0) / (CLOCKS_PER_SEC * 1.));
+  }
+
+  free_player_matrices(y, k, n);
+  free_player_matrices(sb, k, n);
+  free_cost_matrix(dir, n);
+  free_cost_matrix(ys, n);
   return NORMAL;
 }
 
-int run(struct Shell *sh)
+static int parse_run(struct Shell *sh)
+/* Lit les options de run */
 {
-  sh->exec_mode &= 0xf;
+  sh->exec_mode &= MODE_MASK;
   sh->nIter = 100; sh->precision = 1e-2;
+  sh->gap_every = 1; sh->gap = NAN;
+  free(sh->profile_csv_name);
+  sh->profile_csv_name = NULL;
   // cst_gamma = 1;
 
   while (sh->exists_token)
   {
     next_token(sh);
     if (cmp_token(sh->token, "paths"))
-      sh->exec_mode = MODE_PATHS  | (sh->exec_mode ^ (sh->exec_mode & 0xf));
+      sh->exec_mode = MODE_PATHS  | (sh->exec_mode ^ (sh->exec_mode & MODE_MASK));
     else if (cmp_token(sh->token, "vertex"))
-      sh->exec_mode = MODE_VERTEX | (sh->exec_mode ^ (sh->exec_mode & 0xf));
+      sh->exec_mode = MODE_VERTEX | (sh->exec_mode ^ (sh->exec_mode & MODE_MASK));
     else if (cmp_token(sh->token, "bandit"))
-      sh->exec_mode = MODE_BANDIT | (sh->exec_mode ^ (sh->exec_mode & 0xf));
+      sh->exec_mode = MODE_BANDIT | (sh->exec_mode ^ (sh->exec_mode & MODE_MASK));
+    else if (cmp_token(sh->token, "optimistic"))
+      sh->exec_mode = MODE_OPTIMISTIC | (sh->exec_mode ^ (sh->exec_mode & MODE_MASK));
+    else if (cmp_token(sh->token, "extragradient"))
+      sh->exec_mode = MODE_EXTRA | (sh->exec_mode ^ (sh->exec_mode & MODE_MASK));
     else if (cmp_token(sh->token, "simulation"))
     {
-      sh->exec_mode = MODE_SIMU  | (sh->exec_mode ^ (sh->exec_mode & 0xf));
+      sh->exec_mode = MODE_SIMU  | (sh->exec_mode ^ (sh->exec_mode & MODE_MASK));
       sh->precision = 100;
     }
+    else if (cmp_token(sh->token, "frankwolfe"))
+      sh->exec_mode = MODE_FW | (sh->exec_mode ^ (sh->exec_mode & MODE_MASK));
+    else if (cmp_token(sh->token, "conjugate")) sh->exec_mode |= FW_CONJUGATE;
+    else if (cmp_token(sh->token, "wardrop"))   sh->exec_mode |= FW_WARDROP;
+    else if (cmp_token(sh->token, "warm"))      sh->exec_mode |= WARM_START;
+    else if (cmp_token(sh->token, "resume"))    sh->exec_mode |= RESUME;
+    else if (cmp_token(sh->token, "reset"))     sh->exec_mode |= RESUME_RESET;
     else if (cmp_token(sh->token, "corrected"))
       sh->exec_mode |= GAMMA_CORRECTION;
     else if (cmp_token(sh->token, "silent"))
       sh->exec_mode = SILENT | sh->exec_mode;
     else if (cmp_token(sh->token, "potential")) sh->exec_mode |= POTENTIAL;
     else if (cmp_token(sh->token, "time")) sh->exec_mode |= TIME;
+    else if (cmp_token(sh->token, "profile")) sh->exec_mode |= PROFILE;
+    else if (cmp_token(sh->token, "csv"))
+    {
+      if (sh->exists_token) next_token(sh);
+      else { fprintf(stderr, "Expected file name\n"); return NOTOKEN; }
+
+      free(sh->profile_csv_name);
+      if ((sh->profile_csv_name = strdup(sh->token)) == NULL)
+        handle_error("(strdup) parse_run");
+    }
     else if (cmp_token(sh->token, "with"))
     {
       if (sh->exists_token) next_token(sh);
@@ -889,6 +2119,22 @@ int run(struct Shell *sh)
       sh->precision = atof(sh->token);
       sh->exec_mode |= STOP_CCC;
     }
+    else if (cmp_token(sh->token, "gap"))
+    {
+      if (sh->exists_token) next_token(sh);
+      else { fprintf(stderr, "Expected float\n"); return NOTOKEN; }
+
+      sh->gap_tol = atof(sh->token);
+      sh->exec_mode |= STOP_GAP;
+    }
+    else if (cmp_token(sh->token, "every"))
+    {
+      if (sh->exists_token) next_token(sh);
+      else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+
+      sh->gap_every = atoi(sh->token);
+      if (sh->gap_every < 1) sh->gap_every = 1;
+    }
     else if (cmp_token(sh->token, "for"))
     {
       if (sh->exists_token) next_token(sh);
@@ -897,12 +2143,594 @@ int run(struct Shell *sh)
       sh->nIter = atoi(sh->token);
     }
   }
+  return NORMAL;
+}
+
+static void execute_run(struct Shell *sh)
+/* Lance l'exécution choisie par parse_run, en mesurant le temps CPU du
+ * thread (clock compte celui de tout le processus) */
+{
+  struct timespec t0, t1;
+  sh->steps = -1;
+  if (sh->exec_mode & PROFILE && sh->exec_mode & MODE_SIMU)
+    fprintf(stderr, "No iteration phases in the queue simulation\n");
+  else if (sh->exec_mode & PROFILE)
+  {
+    /* Le fichier n'est créé que pour un run profilé */
+    if (sh->profile_csv_name != NULL
+        && (sh->profile_csv = fopen(sh->profile_csv_name, "w")) == NULL)
+      perror(sh->profile_csv_name);
+    sh->profile = new_Profile(sh->profile_csv);
+  }
+  if (sh->exec_mode & MODE_FW && pending_Perturbations(sh->perturb))
+    fprintf(stderr, "No perturbations in frankwolfe\n");
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
 
   if (sh->exec_mode & MODE_PATHS) shell_simu_sb(sh);
-  else if (sh->exec_mode & MODE_VERTEX) shell_simu_vertex(sh);
+  else if (sh->exec_mode & MODES_VERTEX) shell_simu_vertex(sh);
   else if (sh->exec_mode & MODE_BANDIT) shell_simu_bandit(sh, 1);
   else if (sh->exec_mode & MODE_SIMU)   shell_simu_queues(sh);
+  else if (sh->exec_mode & MODE_FW)     shell_simu_frankwolfe(sh);
+
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+  sh->run_time = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  if (sh->perturb != NULL) finish_Perturbations(sh->perturb);
+
+  if (sh->profile != NULL) print_Profile(sh->profile, stderr);
+  free_Profile(sh->profile);
+  sh->profile = NULL;
+  if (sh->profile_csv != NULL) fclose(sh->profile_csv);
+  sh->profile_csv = NULL;
+  free(sh->profile_csv_name);
+  sh->profile_csv_name = NULL;
+
+  if (sh->out != NULL && sh->net != NULL)
+    output_run(sh->out, mode_name(sh->exec_mode), sh->steps, sh->run_time,
+               net_potential(sh->net), sh->gap, 0, NULL, NULL);
+  return ;
+}
+
+int run(struct Shell *sh)
+{
+  int ret_value = parse_run(sh);
+  if (ret_value != NORMAL) return ret_value;
+
+  if (sh->g != NULL && sh->players != NULL)
+    preflight(sh, "run", run_size(sh), 0);
+
+  execute_run(sh);
+  return NORMAL;
+}
+
+/* ************************** RÉPLICAS ************************** */
+
+/* Paramètres que sweep fait varier */
+#define SWEEP_BETA        0
+#define SWEEP_ALPHA       1
+#define SWEEP_CST_GAMMA   2
+#define SWEEP_CST_EPSILON 3
+#define SWEEP_PRECISION   4
+#define SWEEP_MASS        5
+#define SWEEP_PARAMS      6
+
+static const char *sweep_names[SWEEP_PARAMS] =
+  { "beta", "alpha", "cst_gamma", "cst_epsilon", "precision", "mass" };
+
+struct Replicas
+/* Partagé par les threads de repeat et sweep */
+{
+  struct Shell *sh; /* Modèle, lu seulement */
+  int fresh;
+  int n;
+  int next;                 /* Prochain réplica à lancer */
+  unsigned short (*rng)[3]; /* rng[r] : flux du réplica r */
+
+  /* sweep : value[r * n_params + k] est la valeur de param[k] pour r */
+  int n_params;
+  int param[SWEEP_PARAMS];
+  double *value;
+
+  long long *steps; /* Résultats de chaque réplica */
+  double *time, *potential, *gap;
+};
+
+static struct Replicas *new_Replicas(struct Shell *sh, int n, int fresh)
+{
+  struct Replicas *reps = malloc(sizeof(struct Replicas));
+  if (reps == NULL) handle_error("(malloc) new_Replicas");
+  reps->sh = sh; reps->fresh = fresh;
+  reps->n = n; reps->next = 0;
+  reps->n_params = 0; reps->value = NULL;
+  reps->rng   = malloc(n * sizeof(unsigned short[3]));
+  reps->steps = malloc(n * sizeof(long long));
+  reps->time  = malloc(n * sizeof(double));
+  reps->potential = malloc(n * sizeof(double));
+  reps->gap   = malloc(n * sizeof(double));
+  if (reps->rng == NULL || reps->steps == NULL || reps->time == NULL
+      || reps->potential == NULL || reps->gap == NULL)
+    handle_error("(malloc) new_Replicas");
+  return reps;
+}
+
+static void free_Replicas(struct Replicas *reps)
+{
+  free(reps->rng); free(reps->value);
+  free(reps->steps); free(reps->time); free(reps->potential); free(reps->gap);
+  return free(reps);
+}
+
+static void share_paths(struct Shell *sh)
+/* Calcule une fois pour toutes les chemins des joueurs (mode paths) */
+{
+  sh->paths_vertices = vertices_array(sh->g->n);
+  sh->paths = malloc(sh->nPlayers * sizeof(struct List*));
+  if (sh->paths == NULL) handle_error("(malloc) share_paths");
+  for (int i=0; i<sh->nPlayers; i++)
+    sh->paths[i] = path_from_to(sh->players[i].source, sh->players[i].sink,
+                                sh->g, sh->paths_vertices);
+  return ;
+}
+
+static void forget_paths(struct Shell *sh)
+{
+  if (sh->paths == NULL) return ;
+  for (int i=0; i<sh->nPlayers; i++) free_paths(sh->paths[i]);
+  free(sh->paths);
+  free_vertices(sh->paths_vertices, sh->g->n);
+  sh->paths = NULL; sh->paths_vertices = NULL;
+  return ;
+}
+
+static struct Shell *new_replica(struct Shell *sh, int fresh)
+/* Copie de sh pour un réplica, sans trace ni affichage, qui ne partage
+ * que ce que run ne modifie pas : le graphe et les chemins des joueurs.
+ * Avec fresh, graphe et couples des joueurs sont tirés à nouveau (sur le
+ * flux du thread). */
+{
+  int n = sh->g->n;
+  struct Shell *rep = malloc(sizeof(struct Shell));
+  if (rep == NULL) handle_error("(malloc) new_replica");
+  *rep = *sh;
+  rep->exists_token = FALSE;
+  rep->exec_mode = (rep->exec_mode | SILENT) & ~(POTENTIAL | TIME);
+  rep->trace_mode = TRACE_OFF; rep->trace_out = stderr;
+  rep->out = NULL; /* repeat et sweep écrivent pour les réplicas */
+  rep->exec_mode &= ~PROFILE;
+  rep->profile = NULL; rep->profile_csv = NULL; rep->profile_csv_name = NULL;
+  rep->stats = NULL;
+  /* L'état appris reste au modèle : un réplica repart de zéro */
+  rep->learned_mode = 0; rep->learned = NULL; rep->learned_vertices = NULL;
+  rep->learned_nPlayers = rep->learned_n = 0; rep->learned_iter = 0;
+  rep->exec_mode &= ~RESUME;
+  rep->perturb = NULL; /* Le graphe est partagé : pas de perturbations */
+
+  if (fresh)
+  {
+    rep->g = new_graph(n);
+    set_randDAG(rep->g, sh->graph_p);
+    rep->paths = NULL; rep->paths_vertices = NULL;
+  }
+
+  rep->net = new_Network(n);
+  network_get_graph(rep->net, rep->g);
+  rep->net->mode = sh->net->mode;
+  if (fresh)
+  {
+    reset_masses(rep->net);
+    set_allfun  (rep->net, sh->net_fun);
+    set_alldfun (rep->net, sh->net_dfun);
+    set_alld2fun(rep->net, sh->net_d2fun);
+  }
+  else for (int u=0; u<n; u++) for (int v=0; v<n; v++)
+  {
+    rep->net->masses[u][v] = sh->net->masses[u][v];
+    rep->net->cost  [u][v] = sh->net->cost  [u][v];
+    rep->net->dcost [u][v] = sh->net->dcost [u][v];
+    rep->net->d2cost[u][v] = sh->net->d2cost[u][v];
+  }
+
+  rep->players = malloc(sh->nPlayers * sizeof(struct ShellPlayer));
+  if (rep->players == NULL) handle_error("(malloc) new_replica");
+  for (int i=0; i<sh->nPlayers; i++)
+  {
+    rep->players[i] = sh->players[i];
+    if (!fresh) continue;
+    struct Couple ss = connected_couple_DAG(rep->g);
+    rep->players[i].source = ss.left;
+    rep->players[i].sink   = ss.right;
+  }
+
+  /* Copie de la solution de référence (frankwolfe la remplace) ; elle ne
+   * vaut plus rien sur un autre graphe */
+  if (fresh || sh->eq_masses == NULL)
+  {
+    rep->eq_masses = NULL; rep->eq_nPlayers = rep->eq_n = 0;
+    if (fresh) rep->opt_potential = NAN;
+    return rep;
+  }
+  rep->eq_masses = malloc(sh->eq_nPlayers * sizeof(double**));
+  if (rep->eq_masses == NULL) handle_error("(malloc) new_replica");
+  for (int p=0; p<sh->eq_nPlayers; p++)
+  {
+    rep->eq_masses[p] = new_zero_matrix(sh->eq_n);
+    for (int u=0; u<sh->eq_n; u++) for (int v=0; v<sh->eq_n; v++)
+      rep->eq_masses[p][u][v] = sh->eq_masses[p][u][v];
+  }
+  return rep;
+}
+
+static void free_replica(struct Shell *rep, int fresh)
+/* Ne libère que ce qui est propre au réplica */
+{
+  if (fresh) free_graph(rep->g);
+  free_Network(rep->net);
+  free(rep->players);
+  forget_equilibrium(rep);
+  forget_learned(rep);
+  free_SimuStats(rep->stats);
+  return free(rep);
+}
+
+static void set_parameter(struct Shell *sh, int param, double x)
+{
+  switch (param)
+  {
+    case SWEEP_BETA:        sh->beta = x; break;
+    case SWEEP_ALPHA:       sh->alpha = x; break;
+    case SWEEP_CST_GAMMA:   sh->cst_gamma = x; break;
+    case SWEEP_CST_EPSILON: sh->cst_epsilon = x; break;
+    case SWEEP_PRECISION:   sh->precision = x; break;
+    case SWEEP_MASS:
+      for (int p=0; p<sh->nPlayers; p++) sh->players[p].mass = x;
+      break;
+  }
+  return ;
+}
+
+static void *replica_thread(void *arg)
+{
+  struct Replicas *reps = arg;
+  int r;
+  while ((r = __atomic_fetch_add(&reps->next, 1, __ATOMIC_RELAXED)) < reps->n)
+  {
+    /* Le réplica r ne dépend que de son flux, pas du thread qui le lance */
+    set_thread_stream(reps->rng[r]);
+    struct Shell *rep = new_replica(reps->sh, reps->fresh);
+    for (int k=0; k<reps->n_params; k++)
+      set_parameter(rep, reps->param[k], reps->value[r * reps->n_params + k]);
+    execute_run(rep);
+    reps->steps[r] = rep->steps;
+    reps->time[r]  = rep->run_time;
+    reps->potential[r] = net_potential(rep->net);
+    reps->gap[r] = rep->gap;
+    free_replica(rep, reps->fresh);
+  }
+  set_thread_stream(NULL);
+  return NULL;
+}
+
+static void replicas_preflight(struct Shell *sh, const char *what, int n,
+                               int P, int fresh)
+/* Au plus P réplicas en même temps, chacun avec son réseau, ses joueurs et
+ * éventuellement son graphe */
+{
+  int N = sh->g->n;
+  double size = run_size(sh) + Network_size(N);
+  if (fresh) size += (double) N * (N * sizeof(int) + sizeof(int*));
+  preflight(sh, what, ((P < n) ? P : n) * size, 0);
+  return ;
+}
+
+static double run_replicas(struct Replicas *reps, int P)
+/* Lance les réplicas sur P threads ; renvoie le temps écoulé */
+{
+  struct Shell *sh = reps->sh;
+  if (P < 1) P = 1;
+  if (P > reps->n) P = reps->n;
+  if (!reps->fresh && sh->exec_mode & MODE_PATHS) share_paths(sh);
+
+  pthread_t *threads = malloc(P * sizeof(pthread_t));
+  if (threads == NULL) handle_error("(malloc) run_replicas");
+
+  struct timespec w0, w1;
+  clock_gettime(CLOCK_MONOTONIC, &w0);
+  if (P == 1) replica_thread(reps);
+  else
+  {
+    for (int p=0; p<P; p++)
+      if (pthread_create(&threads[p], NULL, replica_thread, reps))
+        handle_error("(pthread_create) run_replicas");
+    for (int p=0; p<P; p++) pthread_join(threads[p], NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &w1);
+
+  free(threads);
+  forget_paths(sh);
+  return (w1.tv_sec - w0.tv_sec) + (w1.tv_nsec - w0.tv_nsec) * 1e-9;
+}
+
+static int replicas_ready(struct Shell *sh)
+{
+  if (sh->g == NULL || sh->net == NULL || !sh->initialized_players)
+  { fprintf(stderr, "No graph, network or players\n"); return FALSE; }
+  return TRUE;
+}
+
+static void print_replicas(const char *name, struct Welford *w)
+/* Moyenne et demi-largeur de son intervalle de confiance à 95 % */
+{
+  printf("%-10s mean %g +- %g (sd %g)\n", name, w->mean,
+         (w->n > 1) ? 1.96 * welford_sd(w) / sqrt(w->n) : 0, welford_sd(w));
+  return ;
+}
+
+int repeat(struct Shell *sh)
+/* repeat N [parallel P] [fresh] run ... */
+{
+  int n, P = 1, fresh = FALSE;
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+  n = atoi(sh->token);
+
+  while (1)
+  {
+    if (sh->exists_token) next_token(sh);
+    else { fprintf(stderr, "Expected run\n"); return NOTOKEN; }
+
+    if (cmp_token(sh->token, "run")) break;
+    else if (cmp_token(sh->token, "fresh")) fresh = TRUE;
+    else if (cmp_token(sh->token, "parallel"))
+    {
+      if (sh->exists_token) next_token(sh);
+      else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+      P = atoi(sh->token);
+    }
+    else return unknown(sh);
+  }
+
+  if (!replicas_ready(sh)) return MISSING;
+  if (fresh && sh->net_fun == NULL)
+  { fprintf(stderr, "fresh needs a network set with 'set network'\n");
+    return MISSING; }
+  if (n < 1) return NORMAL;
+
+  int ret_value = parse_run(sh);
+  if (ret_value != NORMAL) return ret_value;
+  replicas_preflight(sh, "repeat", n, P, fresh);
+  if (pending_Perturbations(sh->perturb))
+    fprintf(stderr, "No perturbations in replicas\n");
+
+  /* Flux tirés sur celui du programme : reproductibles, quel que soit P */
+  struct Replicas *reps = new_Replicas(sh, n, fresh);
+  for (int r=0; r<n; r++) for (int i=0; i<3; i++)
+    reps->rng[r][i] = (unsigned short) rand_long();
+  double wall = run_replicas(reps, P);
+
+  struct Welford steps = { 0, 0, 0 }, time = { 0, 0, 0 },
+                 potential = { 0, 0, 0 };
+  for (int r=0; r<n; r++)
+  {
+    welford_add(&steps, reps->steps[r]);
+    welford_add(&time, reps->time[r]);
+    welford_add(&potential, reps->potential[r]);
+  }
+  if (P > n) P = n;
+  printf("Replicas : %d (%d thread%s, %g s)\n", n, P, (P > 1) ? "s" : "",
+         wall);
+  print_replicas("Steps", &steps);
+  print_replicas("Time", &time);
+  print_replicas("Potential", &potential);
+
+  if (sh->out != NULL) for (int r=0; r<n; r++)
+  {
+    const char *name = "replica";
+    double x = r;
+    output_run(sh->out, mode_name(sh->exec_mode), reps->steps[r],
+               reps->time[r], reps->potential[r], reps->gap[r], 1, &name, &x);
+  }
+
+  free_Replicas(reps);
+  return NORMAL;
+}
+
+int sweep(struct Shell *sh)
+/* sweep <param> <from> <to> <step> [<param> ...] [parallel P] run ... */
+{
+  int P = 1, n_params = 0, param[SWEEP_PARAMS], count[SWEEP_PARAMS];
+  double from[SWEEP_PARAMS], step[SWEEP_PARAMS];
+
+  while (1)
+  {
+    if (sh->exists_token) next_token(sh);
+    else { fprintf(stderr, "Expected run\n"); return NOTOKEN; }
+
+    if (cmp_token(sh->token, "run")) break;
+    else if (cmp_token(sh->token, "parallel"))
+    {
+      if (sh->exists_token) next_token(sh);
+      else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+      P = atoi(sh->token);
+      continue;
+    }
+
+    int k = 0;
+    while (k < SWEEP_PARAMS && !cmp_token(sh->token, sweep_names[k])) k++;
+    if (k == SWEEP_PARAMS) return unknown(sh);
+    for (int i=0; i<n_params; i++)
+      if (param[i] == k)
+      { fprintf(stderr, "Parameter swept twice\n"); return UNKNOWN; }
+    if (n_params == SWEEP_PARAMS)
+    { fprintf(stderr, "Too many swept parameters\n"); return UNKNOWN; }
+
+    double x[3];
+    for (int i=0; i<3; i++)
+    {
+      if (sh->exists_token) next_token(sh);
+      else { fprintf(stderr, "Expected float\n"); return NOTOKEN; }
+      x[i] = atof(sh->token);
+    }
+    if (!(x[2] > 0) || x[1] < x[0])
+    { fprintf(stderr, "Expected from <= to and step > 0\n"); return UNKNOWN; }
+
+    param[n_params] = k;
+    from[n_params]  = x[0];
+    step[n_params]  = x[2];
+    /* Marge pour les pas qui ne tombent pas juste en flottants */
+    count[n_params] = (int) floor((x[1] - x[0]) / x[2] + 1e-9) + 1;
+    n_params ++;
+  }
+
+  if (!replicas_ready(sh)) return MISSING;
+  if (!n_params) { fprintf(stderr, "Nothing to sweep\n"); return MISSING; }
+
+  int ret_value = parse_run(sh);
+  if (ret_value != NORMAL) return ret_value;
+  for (int k=0; k<n_params; k++)
+    if (param[k] == SWEEP_PRECISION && !(sh->exec_mode & (STOP | STOP_CCC)))
+      sh->exec_mode |= STOP;
+
+  /* Produit cartésien, le dernier paramètre variant le plus vite */
+  int n = 1;
+  for (int k=0; k<n_params; k++) n *= count[k];
+  replicas_preflight(sh, "sweep", n, P, FALSE);
+  if (pending_Perturbations(sh->perturb))
+    fprintf(stderr, "No perturbations in replicas\n");
+  struct Replicas *reps = new_Replicas(sh, n, FALSE);
+  reps->n_params = n_params;
+  for (int k=0; k<n_params; k++) reps->param[k] = param[k];
+  reps->value = malloc(n * n_params * sizeof(double));
+  if (reps->value == NULL) handle_error("(malloc) sweep");
+  for (int r=0; r<n; r++)
+    for (int k=n_params-1, i=r; k>=0; i/=count[k], k--)
+      reps->value[r * n_params + k] = from[k] + (i % count[k]) * step[k];
+
+  /* Même flux pour toutes les configurations : leurs écarts ne viennent
+   * que des paramètres */
+  unsigned short seed[3];
+  for (int i=0; i<3; i++) seed[i] = (unsigned short) rand_long();
+  for (int r=0; r<n; r++) for (int i=0; i<3; i++) reps->rng[r][i] = seed[i];
+  double wall = run_replicas(reps, P);
+
+  if (P > n) P = n;
+  printf("Configurations : %d (%d thread%s, %g s)\n", n, P,
+         (P > 1) ? "s" : "", wall);
+  printf("#");
+  for (int k=0; k<n_params; k++) printf(" %s", sweep_names[param[k]]);
+  printf(" steps time potential\n");
+  for (int r=0; r<n; r++)
+  {
+    for (int k=0; k<n_params; k++)
+      printf("%g ", reps->value[r * n_params + k]);
+    printf("%lld %g %g\n", reps->steps[r], reps->time[r], reps->potential[r]);
+  }
+
+  if (sh->out != NULL)
+  {
+    const char *names[SWEEP_PARAMS];
+    for (int k=0; k<n_params; k++) names[k] = sweep_names[param[k]];
+    for (int r=0; r<n; r++)
+      output_run(sh->out, mode_name(sh->exec_mode), reps->steps[r],
+                 reps->time[r], reps->potential[r], reps->gap[r], n_params,
+                 names, &reps->value[r * n_params]);
+  }
+
+  free_Replicas(reps);
+  return NORMAL;
+}
+
+/* ************************** PERTURBATIONS ************************** */
+
+static int read_edge(struct Shell *sh, struct Perturbation *p)
+/* Lit "edge u v", à partir du token courant */
+{
+  if (!cmp_token(sh->token, "edge"))
+  { fprintf(stderr, "Expected edge\n"); return NOTOKEN; }
+
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+  p->u = atoi(sh->token);
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+  p->v = atoi(sh->token);
+
+  if (p->u < 0 || p->v <= p->u)
+  { fprintf(stderr, "No edge %d %d\n", p->u, p->v); return UNKNOWN; }
+  return NORMAL;
+}
+
+static int read_perturbation(struct Shell *sh, struct Perturbation *p)
+/* Lit "set edge u v cost <fonction>", "remove edge u v" ou
+ * "set player p mass m" */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected set or remove\n"); return NOTOKEN; }
+
+  int remove = cmp_token(sh->token, "remove");
+  if (!remove && !cmp_token(sh->token, "set")) return unknown(sh);
+
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected edge or player\n"); return NOTOKEN; }
+  if (remove)
+  {
+    p->kind = PERTURB_REMOVE;
+    return read_edge(sh, p);
+  }
+  if (cmp_token(sh->token, "player"))
+  {
+    p->kind = PERTURB_MASS;
+    if (sh->exists_token) next_token(sh);
+    else { fprintf(stderr, "Expected int\n"); return NOTOKEN; }
+    p->u = atoi(sh->token);
+
+    if (sh->exists_token) next_token(sh);
+    if (!cmp_token(sh->token, "mass"))
+    { fprintf(stderr, "Expected mass\n"); return NOTOKEN; }
+    if (sh->exists_token) next_token(sh);
+    else { fprintf(stderr, "Expected float\n"); return NOTOKEN; }
+    p->mass = atof(sh->token);
+
+    if (p->u < 0 || p->mass < 0)
+    { fprintf(stderr, "Bad player or mass\n"); return UNKNOWN; }
+    return NORMAL;
+  }
+
+  p->kind = PERTURB_COST;
+  int ret_value = read_edge(sh, p);
+  if (ret_value != NORMAL) return ret_value;
+
+  if (sh->exists_token) next_token(sh);
+  if (!cmp_token(sh->token, "cost"))
+  { fprintf(stderr, "Expected cost\n"); return NOTOKEN; }
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected function\n"); return NOTOKEN; }
+  if (!network_funs(sh->token, &p->fun, &p->dfun, &p->d2fun))
+    return unknown(sh);
+  snprintf(p->fun_name, sizeof(p->fun_name), "%.15s", sh->token);
+  return NORMAL;
+}
+
+int perturb_at(struct Shell *sh)
+/* at <T> <perturbation> | at clear */
+{
+  if (sh->exists_token) next_token(sh);
+  else { fprintf(stderr, "Expected time or clear\n"); return NOTOKEN; }
+
+  if (cmp_token(sh->token, "clear"))
+  {
+    if (sh->perturb != NULL) clear_Perturbations(sh->perturb);
+    return NORMAL;
+  }
+
+  struct Perturbation p;
+  memset(&p, 0, sizeof(p));
+  p.T = atof(sh->token);
+  if (p.T < 0) { fprintf(stderr, "Time should be nonnegative\n"); return UNKNOWN; }
+
+  int ret_value = read_perturbation(sh, &p);
+  if (ret_value != NORMAL) return ret_value;
 
+  if (sh->perturb == NULL) sh->perturb = new_Perturbations();
+  add_Perturbation(sh->perturb, p);
   return NORMAL;
 }
 
@@ -921,6 +2749,11 @@ int print(struct Shell *sh)
   if (cmp_token(sh->token, "mass"))      return shell_print_masses (sh);
   if (cmp_token(sh->token, "graphviz"))  return shell_graphviz(sh);
   if (cmp_token(sh->token, "mark")) { fprintf(stderr, "#\n"); return NORMAL; }
+  if (cmp_token(sh->token, "schedule"))  return shell_print_schedule(sh);
+  if (cmp_token(sh->token, "queue"))     return shell_print_queue(sh);
+  if (cmp_token(sh->token, "stats"))     return shell_print_stats(sh);
+  if (cmp_token(sh->token, "memory"))    return shell_print_memory(sh);
+  if (cmp_token(sh->token, "perturbations")) return shell_print_perturbations(sh);
 
   return unknown(sh);
 }
@@ -1050,6 +2883,45 @@ int shell_print_potential(struct Shell *sh)
   return NORMAL;
 }
 
+int shell_print_schedule(struct Shell *sh)
+/* Sur stderr, pour être intercalé avec les résultats des simulations */
+{
+  fprintf(stderr, "Schedule : %s (period %d)\n", schedule_name(sh->schedule),
+          sh->schedule_period);
+  return NORMAL;
+}
+
+int shell_print_queue(struct Shell *sh)
+{
+  fprintf(stderr, "Queue : %s\n", queue_kind_name(sh->queue_kind));
+  return NORMAL;
+}
+
+int shell_print_stats(struct Shell *sh)
+/* Statistiques de la dernière simulation */
+{
+  if (sh->stats == NULL) { fprintf(stderr, "No simulation.\n"); return NOOBJECT; }
+  print_SimuStats(sh->stats);
+  return NORMAL;
+}
+
+int shell_print_memory(struct Shell *sh)
+/* Mémoire par sous-système, et budget s'il y en a un */
+{
+  print_memory(stdout);
+  if (sh->mem_budget > 0) printf("Budget : %.3g MiB\n", sh->mem_budget / MIB);
+  return NORMAL;
+}
+
+int shell_print_perturbations(struct Shell *sh)
+/* Perturbations du prochain run, et seuil de rétablissement */
+{
+  print_Perturbations(sh->perturb, stdout);
+  printf("Recovery : %g (windows of %g in simulation)\n", sh->recovery_tol,
+         sh->recovery_window);
+  return NORMAL;
+}
+
 /* **** MODES **** */
 
 int change_mode(struct Shell *sh)
@@ -1057,7 +2929,7 @@ int change_mode(struct Shell *sh)
 {
   if (sh->exists_token) next_token(sh);
   else if (sh->exec_mode & MODE_PATHS)  { printf("Mode: paths.\n");  return NORMAL; }
-  else if (sh->exec_mode & MODE_VERTEX) { printf("Mode: vertex.\n"); return NORMAL; }
+  else if (sh->exec_mode & MODES_VERTEX) { printf("Mode: vertex.\n"); return NORMAL; }
 
   if (cmp_token(sh->token, "vertex"))
   {
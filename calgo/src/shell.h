@@ -10,9 +10,14 @@
 #include "graph.h"
 #include "network_th.h"
 #include "network_simu.h"
+#include "network_par.h"
 #include "list.h"
 #include "ui.h"
 #include "fun.h"
+#include "schedule.h"
+#include "output.h"
+#include "profile.h"
+#include "perturb.h"
 
 
 /* Les booléens */
@@ -32,14 +37,33 @@
 #define MODE_VERTEX 2
 #define MODE_BANDIT 4
 #define MODE_SIMU   8
+#define MODE_FW     16
+#define MODE_OPTIMISTIC 32 /* Hedge optimiste (un joueur par sommet) */
+#define MODE_EXTRA      64 /* Extra-gradient / mirror-prox (un joueur par sommet) */
+#define MODE_MASK   0xff /* Bits réservés aux modes */
 
-#define SILENT    16
-#define POTENTIAL 32
-#define TIME      64
-#define STOP      128
-#define STOP_CCC  512
+/* Modes utilisant les populations VPPopulation */
+#define MODES_VERTEX (MODE_VERTEX | MODE_OPTIMISTIC | MODE_EXTRA)
 
-#define GAMMA_CORRECTION 256
+#define SILENT    256
+#define POTENTIAL 512
+#define TIME      1024
+#define STOP      2048
+#define STOP_CCC  8192
+#define STOP_GAP  16384
+
+#define GAMMA_CORRECTION 4096
+
+/* Options de Frank-Wolfe et démarrage à chaud */
+#define FW_CONJUGATE 32768
+#define FW_WARDROP   65536
+#define WARM_START   131072
+
+#define PROFILE 262144 /* Temps par phase des itérations */
+
+/* Reprise de l'état appris par le run précédent */
+#define RESUME       524288
+#define RESUME_RESET 1048576 /* Compteur de gamma_iter et epsilon_iter remis à 0 */
 
 struct ShellPlayer
 /* On a besoin d'une structure spéciale de joueurs pour le
@@ -54,6 +78,17 @@ struct Shell
   char token[1024];
   int exists_token;
 
+  /* Lecture des commandes : stdin, ou un fichier en mode batch (pas
+   * d'invite ni de séquences d'échappement) */
+  FILE *in;
+  int batch;
+  struct Output *out; /* Résultats structurés (NULL : aucun) */
+
+  /* run ... profile [csv fichier] : profil du run en cours */
+  struct Profile *profile;
+  char *profile_csv_name; /* Lu par parse_run, ouvert seulement avec profile */
+  FILE *profile_csv; /* Une ligne par itération (NULL : aucune) */
+
   struct graph       *g;
   struct Network     *net;
   struct ShellPlayer *players;
@@ -65,6 +100,77 @@ struct Shell
 
   int nIter;
   double precision;
+
+  /* Constantes de simulation : pas gamma_n = cst_gamma / (n+1)^beta et bruit
+   * epsilon_n = cst_epsilon / (n+1)^alpha (cst_gamma peut être ajusté par
+   * les simulations) */
+  double alpha, beta, cst_epsilon, cst_gamma;
+
+  /* Écart relatif de Wardrop */
+  double gap_tol;   /* Seuil d'arrêt */
+  int gap_every;    /* Calculé toutes les gap_every itérations */
+  double gap;       /* Dernière valeur calculée */
+
+  /* Politique de pas */
+  int schedule, schedule_period;
+
+  /* Élagage des supports (seuil nul : pas d'élagage) */
+  double prune_threshold;
+  int prune_period;
+
+  /* File des événements de la simulation (QUEUE_BINARY, ...) */
+  int queue_kind;
+  int merged_arrivals; /* Une seule source poissonnienne pour tous les flux */
+  double delay; /* Délai des liens (0 : aucun) */
+  int threads;  /* Simulation parallèle sur 'threads' partitions si > 1 */
+
+  /* Trace des paquets de la simulation */
+  int trace_mode;  /* TRACE_OFF, TRACE_TEXT ou TRACE_BINARY */
+  FILE *trace_out; /* stderr par défaut */
+  int trace_chosen; /* set trace utilisé (sinon trace texte implicite) */
+
+  /* Statistiques de la dernière simulation, mesurées après warmup */
+  struct SimuStats *stats;
+  double warmup;
+
+  /* Solution de référence (Frank-Wolfe) */
+  double opt_potential; /* Potentiel de l'optimum social, NAN si inconnu */
+  double ***eq_masses;  /* eq_masses[p][u][v] : flot du joueur p à l'équilibre */
+  int eq_nPlayers, eq_n;
+
+  /* Dernière exécution de run (agrégée par repeat) */
+  long long steps; /* Itérations, ou événements de la simulation */
+  double run_time; /* Temps CPU de son thread */
+
+  /* Pour repeat ... fresh : de quoi tirer un autre graphe et son réseau */
+  double graph_p;
+  dtod_t net_fun, net_dfun, net_d2fun;
+
+  /* Chemins des joueurs partagés par les réplicas (NULL : calculés à
+   * chaque run) */
+  struct List **paths;
+  int **paths_vertices;
+
+  /* État appris par le dernier run (run ... resume en repart) : joueurs
+   * struct SBPlayer (MODE_PATHS, avec les sommets de leurs chemins),
+   * VPPopulation (MODES_VERTEX) ou VBPopulation (MODE_BANDIT) */
+  int learned_mode; /* 0 : aucun */
+  void *learned;
+  int **learned_vertices;
+  int learned_nPlayers, learned_n;
+  long long learned_iter; /* Itérations déjà faites sur cet état */
+  long long iter_offset;  /* Décalage du compteur de gamma_iter et epsilon_iter */
+
+  /* Budget mémoire en octets (0 : aucun) : new network, new players et run
+   * préviennent si leur estimation le dépasse */
+  double mem_budget;
+
+  /* Perturbations du prochain run (at ...), NULL : aucune. Rétabli après
+   * l'une d'elles : écart relatif de Wardrop sous recovery_tol
+   * (apprentissage), ou latences moyennes de deux fenêtres successives de
+   * durée recovery_window à recovery_tol près (simulation). */
+  struct Perturbations *perturb;
+  double recovery_tol, recovery_window;
 };
 
 struct Shell *new_Shell(void); /* Renvoie un nouveal Shell */
@@ -108,6 +214,22 @@ int set_graph(struct Shell *sh);
 int set_mass(struct Shell *sh);
 int set_beta(struct Shell *sh);
 int set_cst_gamma(struct Shell *sh);
+int set_schedule(struct Shell *sh); /* Politique de pas [période] */
+int set_prune(struct Shell *sh);    /* Élagage : seuil [période] | off */
+int set_queue(struct Shell *sh);    /* File des événements de la simulation */
+int set_trace(struct Shell *sh);    /* Trace : off | text [fichier] | binary [fichier] */
+int set_warmup(struct Shell *sh);   /* Durée (simulée) de la période de chauffe */
+int set_arrivals(struct Shell *sh); /* Arrivées : flows | merged */
+int set_delay(struct Shell *sh);    /* Délai des liens de la simulation */
+int set_threads(struct Shell *sh);  /* Nombre de threads de la simulation */
+int set_seed(struct Shell *sh);     /* Graine des tirages aléatoires */
+int set_memory(struct Shell *sh);   /* Budget mémoire en Mio (0 : aucun) */
+int set_recovery(struct Shell *sh); /* Seuil de rétablissement [fenêtre] */
+
+void forget_equilibrium(struct Shell *sh);
+/* Oublie la solution de référence (graphe ou joueurs modifiés) */
+void forget_learned(struct Shell *sh);
+/* Oublie l'état appris par le dernier run (graphe ou joueurs recréés) */
 
 
 /* Conversion utiles pour les simulations */
@@ -131,6 +253,23 @@ struct VBPopulation *ShellPlayers_to_VBPopulation(struct Shell *sh, int n);
 
 /* Simulation */
 int run(struct Shell *sh);
+/* run [mode] [options] [resume [reset]] : avec resume, les joueurs repartent
+ * de l'état appris par le run précédent du même mode (mêmes joueurs, masses
+ * éventuellement changées), et le compteur des pas continue, sauf avec reset */
+int repeat(struct Shell *sh);
+/* repeat N [parallel P] [fresh] run ... : N réplicas indépendants de run,
+ * sur P threads, éventuellement sur d'autres graphe et joueurs aléatoires */
+int sweep(struct Shell *sh);
+/* sweep <param> <from> <to> <step> [<param> ...] [parallel P] run ... :
+ * un run par point de la grille (beta, alpha, cst_gamma, cst_epsilon,
+ * precision, mass), sur P threads, une ligne de résultats par point */
+
+/* Perturbations */
+int perturb_at(struct Shell *sh);
+/* at <T> set edge u v cost <fonction> | at <T> remove edge u v
+ * | at <T> set player p mass m | at clear : changement appliqué en cours
+ * du prochain run, à l'itération T (ou à l'instant simulé T), sur place.
+ * Il reste dans le graphe, le réseau et les joueurs après le run. */
 
 /* Affichage */
 int print(struct Shell *sh);                /* Fonction d'affichage maîtresse */
@@ -141,6 +280,11 @@ int shell_print_player(struct Shell *sh);   /* Affichage d'un joueur */
 int shell_print_scores(struct Shell *sh);   /* Affiche les scores des joueurs */
 int shell_print_masses(struct Shell *sh);   /* Affiche les masses dans le graphe */
 int shell_print_potential(struct Shell *sh);
+int shell_print_schedule(struct Shell *sh);
+int shell_print_queue(struct Shell *sh);
+int shell_print_stats(struct Shell *sh);
+int shell_print_memory(struct Shell *sh); /* Mémoire par sous-système */
+int shell_print_perturbations(struct Shell *sh);
 int shell_graphviz(struct Shell *sh);
 
 /* **** MODES **** */
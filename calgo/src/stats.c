@@ -0,0 +1,262 @@
+#include "stats.h"
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct SimuStats *new_SimuStats(int n, double **lambda)
+/* Statistiques pour un graphe de taille n : un couple par flux
+ * lambda[s][t] > 0 */
+{
+  struct SimuStats *stats = malloc(sizeof(struct SimuStats));
+  if (stats == NULL) handle_error("(malloc) new_SimuStats");
+
+  stats->n = n;
+  stats->n_pairs = 0;
+  stats->pair = malloc(n * sizeof(int*));
+  if (stats->pair == NULL) handle_error("(malloc) new_SimuStats");
+  for (int s=0; s<n; s++)
+  {
+    stats->pair[s] = malloc(n * sizeof(int));
+    if (stats->pair[s] == NULL) handle_error("(malloc) new_SimuStats");
+    for (int t=0; t<n; t++)
+      stats->pair[s][t] = (lambda[s][t] > 0) ? stats->n_pairs++ : -1;
+  }
+
+  int k = stats->n_pairs;
+  stats->source  = malloc(k * sizeof(int));
+  stats->sink    = malloc(k * sizeof(int));
+  stats->latency = malloc(k * sizeof(struct Welford));
+  stats->hist    = malloc(k * sizeof(struct Histogram));
+  stats->lost    = malloc(k * sizeof(long long));
+  stats->busy    = malloc(n * sizeof(double));
+  stats->sojourn = malloc(n * sizeof(struct Welford));
+  if ((k && (stats->source == NULL || stats->sink == NULL
+             || stats->latency == NULL || stats->hist == NULL
+             || stats->lost == NULL))
+      || stats->busy == NULL || stats->sojourn == NULL)
+    handle_error("(malloc) new_SimuStats");
+
+  for (int s=0; s<n; s++) for (int t=0; t<n; t++) if (stats->pair[s][t] >= 0)
+  {
+    stats->source[stats->pair[s][t]] = s;
+    stats->sink  [stats->pair[s][t]] = t;
+  }
+
+  reset_SimuStats(stats, 0);
+  return stats;
+}
+
+void free_SimuStats(struct SimuStats *stats)
+{
+  if (stats == NULL) return ;
+
+  for (int s=0; s<stats->n; s++) free(stats->pair[s]);
+  free(stats->pair);
+  free(stats->source); free(stats->sink);
+  free(stats->latency); free(stats->hist); free(stats->lost);
+  free(stats->busy); free(stats->sojourn);
+  return free(stats);
+}
+
+void reset_SimuStats(struct SimuStats *stats, double T)
+/* Oublie tout ce qui précède l'instant T (fin de la période de chauffe) */
+{
+  struct Welford zero = { 0, 0, 0 };
+
+  for (int p=0; p<stats->n_pairs; p++)
+  {
+    stats->latency[p] = zero;
+    stats->hist[p].n  = 0;
+    for (int b=0; b<HIST_SIZE; b++) stats->hist[p].count[b] = 0;
+    stats->lost[p] = 0;
+  }
+  stats->all_latency = zero;
+  stats->all_hist.n  = 0;
+  for (int b=0; b<HIST_SIZE; b++) stats->all_hist.count[b] = 0;
+  stats->all_lost = 0;
+
+  for (int u=0; u<stats->n; u++) { stats->busy[u] = 0; stats->sojourn[u] = zero; }
+  stats->start = stats->now = T;
+  return ;
+}
+
+/* *********************** ACCUMULATION *********************** */
+
+void welford_add(struct Welford *w, double x)
+{
+  w->n ++;
+  double delta = x - w->mean;
+  w->mean += delta / w->n;
+  w->m2   += delta * (x - w->mean);
+  return ;
+}
+
+double welford_sd(struct Welford *w)
+/* Écart-type (non biaisé) */
+{
+  return (w->n > 1) ? sqrt(w->m2 / (w->n - 1)) : 0;
+}
+
+static int hist_index(double x)
+/* x = m.2^e, m dans [1/2, 1[ : seau (e - 1, m) */
+{
+  if (!(x > 0)) return 0;
+  int e;
+  double m = frexp(x, &e);
+  int b = (e - 1 - HIST_EXP_MIN) * HIST_SUB + (int) ((2*m - 1) * HIST_SUB);
+  if (b < 0) return 0;
+  if (b >= HIST_SIZE) return HIST_SIZE - 1;
+  return b;
+}
+
+static double hist_value(int b)
+/* Milieu du seau b */
+{
+  int e = b / HIST_SUB + HIST_EXP_MIN;
+  int sub = b % HIST_SUB;
+  return ldexp(1 + (sub + 0.5) / HIST_SUB, e);
+}
+
+void hist_add(struct Histogram *h, double x)
+{
+  h->count[hist_index(x)] ++;
+  h->n ++;
+  return ;
+}
+
+double hist_quantile(struct Histogram *h, double q)
+/* Quantile q (0 < q <= 1), au milieu de son seau. NAN si h est vide. */
+{
+  if (!h->n) return NAN;
+
+  long long rank = (long long) ceil(q * h->n), seen = 0;
+  if (rank < 1) rank = 1;
+  for (int b=0; b<HIST_SIZE; b++)
+  {
+    seen += h->count[b];
+    if (seen >= rank) return hist_value(b);
+  }
+  return hist_value(HIST_SIZE - 1);
+}
+
+void stats_packet(struct SimuStats *stats, int source, int sink, double T,
+                  double latency, int delivered)
+/* Un paquet de (source, sink) sort du réseau à l'instant T */
+{
+  int p = stats->pair[source][sink];
+  if (T > stats->now) stats->now = T;
+
+  if (!delivered) { stats->all_lost ++; if (p >= 0) stats->lost[p] ++; return ; }
+
+  welford_add(&stats->all_latency, latency);
+  hist_add(&stats->all_hist, latency);
+  if (p < 0) return ;
+  welford_add(&stats->latency[p], latency);
+  hist_add(&stats->hist[p], latency);
+  return ;
+}
+
+static double busy_between(double start, double L, double T_from, double T_to)
+/* Temps de travail dans [T_from, T_to], sur la partie postérieure à start,
+ * d'un nœud de charge L à l'instant T_from */
+{
+  double from = (T_from > start) ? T_from : start;
+  double to   = (T_from + L < T_to) ? T_from + L : T_to;
+  return (to > from) ? to - from : 0;
+}
+
+void stats_node(struct SimuStats *stats, int u, double T, double L_before,
+                double T_before, double L_after)
+/* Un paquet arrive en u à l'instant T. L_before et T_before sont la charge
+ * de u et l'instant de la précédente arrivée ; L_after est son temps de
+ * séjour. */
+{
+  if (T > stats->now) stats->now = T;
+  stats->busy[u] += busy_between(stats->start, L_before, T_before, T);
+  welford_add(&stats->sojourn[u], L_after);
+  return ;
+}
+
+void close_SimuStats(struct SimuStats *stats, int u, double L, double T)
+/* Fin de la simulation : compte le travail en cours sur le nœud u, de
+ * charge L depuis l'instant T */
+{
+  stats->busy[u] += busy_between(stats->start, L, T, stats->now);
+  return ;
+}
+
+static void welford_merge(struct Welford *w, struct Welford *other)
+/* Formule de Chan et al. */
+{
+  if (!other->n) return ;
+  long long n = w->n + other->n;
+  double delta = other->mean - w->mean;
+  w->mean += delta * other->n / n;
+  w->m2   += other->m2 + delta * delta * w->n * other->n / n;
+  w->n = n;
+  return ;
+}
+
+static void hist_merge(struct Histogram *h, struct Histogram *other)
+{
+  for (int b=0; b<HIST_SIZE; b++) h->count[b] += other->count[b];
+  h->n += other->n;
+  return ;
+}
+
+void merge_SimuStats(struct SimuStats *stats, struct SimuStats *other)
+/* Ajoute à stats celles d'une autre partie de la même simulation (mêmes
+ * graphe et flux, nœuds disjoints) */
+{
+  for (int p=0; p<stats->n_pairs; p++)
+  {
+    welford_merge(&stats->latency[p], &other->latency[p]);
+    hist_merge(&stats->hist[p], &other->hist[p]);
+    stats->lost[p] += other->lost[p];
+  }
+  welford_merge(&stats->all_latency, &other->all_latency);
+  hist_merge(&stats->all_hist, &other->all_hist);
+  stats->all_lost += other->all_lost;
+
+  for (int u=0; u<stats->n; u++)
+  {
+    stats->busy[u] += other->busy[u];
+    welford_merge(&stats->sojourn[u], &other->sojourn[u]);
+  }
+  if (other->start > stats->start) stats->start = other->start;
+  if (other->now > stats->now) stats->now = other->now;
+  return ;
+}
+
+/* *********************** AFFICHAGE *********************** */
+
+static void print_latency(const char *name, struct Welford *w,
+                          struct Histogram *h, long long lost)
+{
+  printf("%-12s delivered %lld, lost %lld, latency mean %g sd %g, "
+         "p50 %g p99 %g p999 %g\n", name, w->n, lost, w->mean, welford_sd(w),
+         hist_quantile(h, 0.5), hist_quantile(h, 0.99), hist_quantile(h, 0.999));
+  return ;
+}
+
+void print_SimuStats(struct SimuStats *stats)
+{
+  double duration = stats->now - stats->start;
+  printf("Measured over [%g, %g]\n", stats->start, stats->now);
+
+  char name[32];
+  for (int p=0; p<stats->n_pairs; p++)
+  {
+    sprintf(name, "%d -> %d", stats->source[p], stats->sink[p]);
+    print_latency(name, &stats->latency[p], &stats->hist[p], stats->lost[p]);
+  }
+  print_latency("all", &stats->all_latency, &stats->all_hist, stats->all_lost);
+
+  for (int u=0; u<stats->n; u++) if (stats->sojourn[u].n)
+    printf("Node %-7d utilisation %.3f, packets %lld, sojourn mean %g sd %g\n",
+           u, (duration > 0) ? stats->busy[u] / duration : 0,
+           stats->sojourn[u].n, stats->sojourn[u].mean,
+           welford_sd(&stats->sojourn[u]));
+  return ;
+}
@@ -0,0 +1,96 @@
+#ifndef stats_h
+#define stats_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* On définit ici les statistiques calculées au fil de la simulation des
+ * files d'attente, sans rien écrire par paquet :
+ *  - par couple origine/destination : nombre de paquets arrivés et perdus,
+ *    moyenne et variance de la latence (Welford), histogramme de la latence ;
+ *  - par nœud : taux d'occupation (temps de travail / temps mesuré) et temps
+ *    de séjour des paquets (attente + service).
+ * Les histogrammes sont logarithmiques, à la HDR : HIST_SUB seaux linéaires
+ * par puissance de 2, soit une erreur relative d'au plus 1/(2.HIST_SUB)
+ * sur les quantiles. */
+
+#define HIST_SUB     32
+#define HIST_EXP_MIN (-16) /* 2^-16 : en deçà, premier seau */
+#define HIST_EXP_MAX 24    /* 2^24  : au-delà, dernier seau */
+#define HIST_SIZE    ((HIST_EXP_MAX - HIST_EXP_MIN) * HIST_SUB)
+
+struct Welford
+{
+  long long n;
+  double mean, m2; /* m2 : somme des carrés des écarts à la moyenne */
+};
+
+struct Histogram
+{
+  long long count[HIST_SIZE];
+  long long n;
+};
+
+struct SimuStats
+{
+  int n;       /* Taille du graphe */
+  int n_pairs; /* Nombre de couples origine/destination */
+  int **pair;  /* pair[s][t] : indice du couple (s, t), -1 s'il n'existe pas */
+  int *source, *sink;
+
+  struct Welford   *latency; /* Par couple */
+  struct Histogram *hist;
+  long long        *lost;
+
+  struct Welford   all_latency; /* Tous couples confondus */
+  struct Histogram all_hist;
+  long long        all_lost;
+
+  double *busy;            /* Temps de travail de chaque nœud */
+  struct Welford *sojourn; /* Temps de séjour sur chaque nœud */
+
+  double start, now; /* Période mesurée */
+};
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct SimuStats *new_SimuStats(int n, double **lambda);
+/* Statistiques pour un graphe de taille n : un couple par flux
+ * lambda[s][t] > 0 */
+void free_SimuStats(struct SimuStats *stats);
+
+void reset_SimuStats(struct SimuStats *stats, double T);
+/* Oublie tout ce qui précède l'instant T (fin de la période de chauffe) */
+
+/* *********************** ACCUMULATION *********************** */
+
+void welford_add(struct Welford *w, double x);
+double welford_sd(struct Welford *w); /* Écart-type (non biaisé) */
+
+void hist_add(struct Histogram *h, double x);
+double hist_quantile(struct Histogram *h, double q);
+/* Quantile q (0 < q <= 1), au milieu de son seau. NAN si h est vide. */
+
+void stats_packet(struct SimuStats *stats, int source, int sink, double T,
+                  double latency, int delivered);
+/* Un paquet de (source, sink) sort du réseau à l'instant T */
+void stats_node(struct SimuStats *stats, int u, double T, double L_before,
+                double T_before, double L_after);
+/* Un paquet arrive en u à l'instant T. L_before et T_before sont la charge
+ * de u et l'instant de la précédente arrivée ; L_after est son temps de
+ * séjour. */
+
+void close_SimuStats(struct SimuStats *stats, int u, double L, double T);
+/* Fin de la simulation : compte le travail en cours sur le nœud u, de
+ * charge L depuis l'instant T */
+
+void merge_SimuStats(struct SimuStats *stats, struct SimuStats *other);
+/* Ajoute à stats celles d'une autre partie de la même simulation (mêmes
+ * graphe et flux, nœuds disjoints) */
+
+/* *********************** AFFICHAGE *********************** */
+
+void print_SimuStats(struct SimuStats *stats);
+
+#endif
@@ -0,0 +1,94 @@
+#include "support.h"
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+/* Nombre de réexamens sous le seuil avant retrait (environ 'period'
+ * itérations consécutives) */
+#define LOW_RESCANS 2
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Support *new_Support(int n, double threshold, int period)
+/* Renvoie un nouveau support plein sur n actions */
+{
+  struct Support *s = malloc(sizeof(struct Support));
+  if (s == NULL) handle_error("(malloc) new_Support");
+
+  s->n = s->n_active = n;
+  s->threshold = threshold;
+  s->period = (period > 0) ? period : 1;
+  s->lag = 0;
+  s->active = malloc(n * sizeof(char));
+  s->low    = calloc(n, sizeof(int));
+  if ((s->active == NULL || s->low == NULL) && n)
+    handle_error("(malloc) new_Support");
+  for (int i=0; i<n; i++) s->active[i] = 1;
+
+  return s;
+}
+
+void free_Support(struct Support *s)
+{
+  if (s == NULL) return ;
+  free(s->active);
+  free(s->low);
+  return free(s);
+}
+
+void support_remove(struct Support *s, int i)
+/* Retire l'action i (les suivantes sont décalées) : arc ou chemin disparu */
+{
+  if (s == NULL) return ;
+  if (s->active[i]) s->n_active--;
+  memmove(s->active + i, s->active + i + 1, (s->n - i - 1) * sizeof(char));
+  memmove(s->low + i, s->low + i + 1, (s->n - i - 1) * sizeof(int));
+  s->n--;
+
+  /* Plus rien de joué : tout revient dans le support */
+  if (s->n_active == 0)
+  {
+    for (int j=0; j<s->n; j++) { s->active[j] = 1; s->low[j] = 0; }
+    s->n_active = s->n;
+  }
+  return ;
+}
+
+/* *********************** ÉLAGAGE *********************** */
+
+void support_restrict(struct Support *s, double *distrib)
+/* Met à 0 les probabilités hors du support, et renormalise */
+{
+  if (s == NULL || s->n_active == s->n) return ;
+
+  double total = 0;
+  for (int i=0; i<s->n; i++)
+  {
+    if (!s->active[i]) distrib[i] = 0;
+    total += distrib[i];
+  }
+  if (total > 0) for (int i=0; i<s->n; i++) distrib[i] /= total;
+  return ;
+}
+
+int support_rescan(struct Support *s, double *distrib)
+/* Réexamine le support étant donnée la distribution complète 'distrib' :
+ * retire les actions restées sous le seuil depuis deux réexamens, réintègre
+ * celles qui le repassent. Renvoie le nombre d'actions réintégrées. */
+{
+  int back = 0;
+  for (int i=0; i<s->n; i++)
+  {
+    if (distrib[i] >= s->threshold)
+    {
+      s->low[i] = 0;
+      if (!s->active[i]) { s->active[i] = 1; s->n_active++; back++; }
+    }
+    else if (s->active[i] && ++s->low[i] >= LOW_RESCANS && s->n_active > 1)
+    {
+      s->active[i] = 0;
+      s->n_active--;
+    }
+  }
+  s->lag = 0;
+  return back;
+}
@@ -0,0 +1,47 @@
+#ifndef support_h
+#define support_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* On définit ici le support actif d'une distribution : l'ensemble des actions
+ * (chemins ou arcs) qu'un joueur considère encore. Une action dont la
+ * probabilité reste sous un seuil est retirée du support, et n'est plus
+ * parcourue dans les boucles de calcul des masses et des coûts. Le support
+ * n'est réexaminé que toutes les 'period' itérations : une action y revient
+ * dès que sa probabilité (recalculée sur ses évaluations) repasse le seuil. */
+
+struct Support
+{
+  int n;            /* Nombre d'actions */
+  int n_active;     /* Taille du support */
+  char *active;     /* active[i] : l'action i est dans le support */
+  int *low;         /* Nombre de réexamens consécutifs sous le seuil */
+  double threshold; /* Seuil de probabilité */
+  int period;       /* Période de réexamen (en itérations) */
+  double lag;       /* Somme des pas depuis le dernier réexamen */
+};
+
+/* L'action i est-elle jouée ? (support NULL : pas d'élagage) */
+#define in_support(s, i) ((s) == NULL || (s)->active[i])
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Support *new_Support(int n, double threshold, int period);
+/* Renvoie un nouveau support plein sur n actions */
+void free_Support(struct Support *s);
+void support_remove(struct Support *s, int i);
+/* Retire l'action i (les suivantes sont décalées) : arc ou chemin disparu */
+
+/* *********************** ÉLAGAGE *********************** */
+
+void support_restrict(struct Support *s, double *distrib);
+/* Met à 0 les probabilités hors du support, et renormalise */
+
+int support_rescan(struct Support *s, double *distrib);
+/* Réexamine le support étant donnée la distribution complète 'distrib' :
+ * retire les actions restées sous le seuil depuis deux réexamens, réintègre
+ * celles qui le repassent. Renvoie le nombre d'actions réintégrées. */
+
+#endif
@@ -0,0 +1,138 @@
+#include "trace.h"
+#include <sched.h>
+#include <time.h>
+
+#define handle_error(s) do {fprintf(stderr, #s "\n"); exit(EXIT_FAILURE); } while(0);
+
+#define TEXT_BUFFER 65536 /* Tampon de formatage du mode texte */
+#define TEXT_LINE   64    /* Longueur maximale d'une ligne "temps latence" */
+
+/* L'anneau n'a qu'un producteur (la simulation) et qu'un consommateur (le
+ * thread d'écriture) : head n'est écrit que par le premier, tail que par le
+ * second, et chacun publie son indice avec une sémantique release. */
+
+/* *********************** THREAD D'ÉCRITURE *********************** */
+
+static void write_text(struct Trace *trace, struct TraceRecord *records, int n,
+                       char *buffer)
+/* Formate les paquets dans buffer et l'écrit d'un bloc : 'out' peut être
+ * stderr, qui n'est pas bufferisé */
+{
+  int len = 0;
+  for (int i=0; i<n; i++)
+  {
+    if (records[i].outcome == TRACE_RUN) continue;
+    len += sprintf(buffer + len, "%lf %lf\n", records[i].T, records[i].latency);
+    if (len > TEXT_BUFFER - TEXT_LINE) { fwrite(buffer, 1, len, trace->out);
+                                         len = 0; }
+  }
+  fwrite(buffer, 1, len, trace->out);
+  return ;
+}
+
+static void *trace_writer(void *arg)
+{
+  struct Trace *trace = arg;
+  char *buffer = malloc(TEXT_BUFFER);
+  if (buffer == NULL) handle_error("(malloc) trace_writer");
+  struct timespec nap = { 0, 200000 };
+
+  while (1)
+  {
+    /* done avant head : tout ce qui précède la fin est alors visible */
+    int done = __atomic_load_n(&trace->done, __ATOMIC_ACQUIRE);
+    uint64_t head = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE);
+
+    if (head == trace->tail)
+    {
+      if (done) break;
+      nanosleep(&nap, NULL);
+      continue;
+    }
+
+    /* Partie contiguë de l'anneau */
+    uint64_t start = trace->tail % TRACE_RING;
+    int n = (head - trace->tail < TRACE_RING - start) ? head - trace->tail
+                                                      : TRACE_RING - start;
+    if (trace->mode == TRACE_BINARY)
+      fwrite(trace->ring + start, sizeof(struct TraceRecord), n, trace->out);
+    else write_text(trace, trace->ring + start, n, buffer);
+
+    __atomic_store_n(&trace->tail, trace->tail + n, __ATOMIC_RELEASE);
+  }
+
+  fflush(trace->out);
+  free(buffer);
+  return NULL;
+}
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Trace *new_Trace(int mode, FILE *out)
+{
+  if (mode == TRACE_OFF) return NULL;
+
+  struct Trace *trace = malloc(sizeof(struct Trace));
+  if (trace == NULL) handle_error("(malloc) new_Trace");
+  trace->ring = malloc(TRACE_RING * sizeof(struct TraceRecord));
+  if (trace->ring == NULL) handle_error("(malloc) new_Trace");
+
+  trace->mode = mode;
+  trace->out  = out;
+  trace->head = trace->tail = 0;
+  trace->done = 0;
+
+  if (mode == TRACE_BINARY) trace_packet(trace, 0, 0, -1, -1, 0, TRACE_RUN);
+  if (pthread_create(&trace->writer, NULL, trace_writer, trace))
+    handle_error("(pthread_create) new_Trace");
+
+  return trace;
+}
+
+void free_Trace(struct Trace *trace)
+{
+  if (trace == NULL) return ;
+
+  __atomic_store_n(&trace->done, 1, __ATOMIC_RELEASE);
+  pthread_join(trace->writer, NULL);
+  free(trace->ring);
+  return free(trace);
+}
+
+int trace_mode_from_name(const char *name)
+/* Renvoie le mode de nom 'name', -1 s'il n'existe pas */
+{
+  for (int mode=TRACE_OFF; mode<=TRACE_BINARY; mode++)
+    if (!strcmp(name, trace_mode_name(mode))) return mode;
+  return -1;
+}
+
+const char *trace_mode_name(int mode)
+{
+  if (mode == TRACE_OFF)    return "off";
+  if (mode == TRACE_TEXT)   return "text";
+  if (mode == TRACE_BINARY) return "binary";
+  return "unknown";
+}
+
+/* *********************** ENREGISTREMENT *********************** */
+
+void trace_packet(struct Trace *trace, double T, double latency, int source,
+                  int sink, int hops, int outcome)
+/* Ajoute un enregistrement ; attend si l'anneau est plein */
+{
+  while (trace->head - __atomic_load_n(&trace->tail, __ATOMIC_ACQUIRE)
+         >= TRACE_RING)
+    sched_yield();
+
+  struct TraceRecord *record = trace->ring + trace->head % TRACE_RING;
+  record->T = T;
+  record->latency = latency;
+  record->source  = source;
+  record->sink    = sink;
+  record->hops    = hops;
+  record->outcome = outcome;
+
+  __atomic_store_n(&trace->head, trace->head + 1, __ATOMIC_RELEASE);
+  return ;
+}
@@ -0,0 +1,69 @@
+#ifndef trace_h
+#define trace_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+/* On définit ici la trace des paquets de la simulation. Le thread de
+ * simulation range des enregistrements de taille fixe dans un anneau
+ * préalloué ; un thread d'écriture les vide en tâche de fond, en binaire
+ * (lu par trace-convert) ou en texte bufferisé ("temps latence", l'ancien
+ * format de stderr). */
+
+#define TRACE_OFF    0
+#define TRACE_TEXT   1
+#define TRACE_BINARY 2
+
+/* Issue d'un paquet */
+#define TRACE_DELIVERED 0
+#define TRACE_LOST      1
+#define TRACE_RUN       2 /* Pas un paquet : début d'une simulation (binaire) */
+
+#define TRACE_RING (1<<16) /* Nombre d'enregistrements de l'anneau */
+
+struct TraceRecord /* 32 octets, format du fichier binaire */
+{
+  double T;         /* Instant de sortie du réseau */
+  double latency;   /* Temps de parcours */
+  int32_t source, sink;
+  int32_t hops;     /* Nombre de sauts */
+  int32_t outcome;  /* TRACE_DELIVERED, TRACE_LOST ou TRACE_RUN */
+};
+
+struct Trace
+{
+  int mode;
+  FILE *out;
+
+  struct TraceRecord *ring;
+  uint64_t head; /* Prochain enregistrement à écrire (simulation) */
+  uint64_t tail; /* Prochain enregistrement à vider (écriture) */
+  int done;      /* Plus rien ne sera ajouté */
+
+  pthread_t writer;
+};
+
+/* *********************** ADMINISTRATION *********************** */
+
+struct Trace *new_Trace(int mode, FILE *out);
+/* Renvoie une trace écrivant dans 'out' et lance son thread d'écriture.
+ * Renvoie NULL si mode vaut TRACE_OFF. En binaire, un enregistrement
+ * TRACE_RUN sépare les simulations successives d'un même fichier. */
+void free_Trace(struct Trace *trace);
+/* Vide l'anneau, arrête le thread d'écriture et libère la trace.
+ * Ne ferme pas 'out'. */
+
+int trace_mode_from_name(const char *name);
+/* Renvoie le mode de nom 'name', -1 s'il n'existe pas */
+const char *trace_mode_name(int mode);
+
+/* *********************** ENREGISTREMENT *********************** */
+
+void trace_packet(struct Trace *trace, double T, double latency, int source,
+                  int sink, int hops, int outcome);
+/* Ajoute un enregistrement ; attend si l'anneau est plein */
+
+#endif
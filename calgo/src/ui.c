@@ -35,6 +35,7 @@ void init_SBPlayer(int i, struct SBPlayer *players, struct graph *g,
   players[i].paths = path_from_to(players[i].source, players[i].sink, g, vertices);
   players[i].n     = len(players[i].paths);
   players[i].Y_uv = calloc(players[i].n, sizeof(double));
+  players[i].support = NULL;
 
   return ;
 }
@@ -51,13 +52,23 @@ void init_SBPlayers(struct SBPlayer *players, struct graph *g, int n,
 void set_SBPlayer(int i, struct SBPlayer *players, int source, int sink,
                   double mass, struct graph *g, int **vertices)
 /* Initialise le joueur 'i' à (source, sink, mass) */
+{
+  set_SBPlayer_paths(i, players, source, sink, mass,
+                     path_from_to(source, sink, g, vertices));
+  return;
+}
+
+void set_SBPlayer_paths(int i, struct SBPlayer *players, int source, int sink,
+                        double mass, struct List *paths)
+/* Idem, avec des chemins déjà calculés, qui restent à l'appelant */
 {
   players[i].mass = mass;
   players[i].source = source;
   players[i].sink   = sink;
-  players[i].paths  = path_from_to(source, sink, g, vertices);
+  players[i].paths  = paths;
   players[i].n      = len(players[i].paths);
   players[i].Y_uv   = calloc(players[i].n, sizeof(double));
+  players[i].support = NULL;
 
   if (players[i].Y_uv == NULL) { fprintf(stderr, "(calloc) set_SBPlayer\n");
                                  exit(EXIT_FAILURE); }
@@ -76,11 +87,18 @@ void normalize_SBPlayers(struct SBPlayer *players, int n)
 
 void free_SBPlayers(struct SBPlayer *players, int n)
 /* Libère les n premiers joueurs de players, et libère le pointeur 'players' */
+{
+  for (int i=0; i<n; i++) free_paths(players[i].paths);
+  return release_SBPlayers(players, n);
+}
+
+void release_SBPlayers(struct SBPlayer *players, int n)
+/* Idem, sans libérer les chemins (set_SBPlayer_paths) */
 {
   for (int i=0; i<n; i++)
   {
     free(players[i].Y_uv);
-    free_paths(players[i].paths);
+    free_Support(players[i].support);
   }
   free(players);
   return ;
@@ -97,6 +115,93 @@ void reset_SBPlayers(struct SBPlayer *players, int n)
   return ;
 }
 
+void prune_SBPlayers(struct SBPlayer *players, int n, double threshold,
+                     int period)
+/* Active l'élagage des chemins des n premiers joueurs */
+{
+  for (int i=0; i<n; i++)
+  {
+    free_Support(players[i].support);
+    players[i].support = new_Support(players[i].n, threshold, period);
+  }
+  return ;
+}
+
+void rescan_SBPlayers(struct SBPlayer *players, int n, double **cost_mat)
+/* Rattrape les évaluations des chemins hors support (coûts de cost_mat sur
+ * les pas accumulés) et réexamine les supports */
+{
+  for (int i=0; i<n; i++)
+  {
+    struct Support *support = players[i].support;
+    if (support == NULL) continue;
+
+    /* Les chemins hors support n'ont pas été évalués depuis le dernier
+     * réexamen : on leur impute le coût courant sur tous les pas manqués */
+    struct List *paths = players[i].paths;
+    for (int k=0; !is_empty(paths); k++, paths = paths->tail)
+    if (!support->active[k])
+      players[i].Y_uv[k] += support->lag * fast_path_cost(paths->head, cost_mat);
+
+    double *distrib = new_distrib(players[i].n);
+    balanced_logit(distrib, players[i].Y_uv, 0, players[i].n);
+    support_rescan(support, distrib);
+    free(distrib);
+  }
+  return ;
+}
+
+int support_size_SBPlayers(struct SBPlayer *players, int n)
+/* Nombre total de chemins joués */
+{
+  int size = 0;
+  for (int i=0; i<n; i++)
+    size += (players[i].support == NULL) ? players[i].n
+                                         : players[i].support->n_active;
+  return size;
+}
+
+static int path_uses(struct List *path, int u, int v)
+/* Renvoie 1 si le chemin emprunte l'arc uv, 0 sinon */
+{
+  for (; !is_empty(path) && !is_empty(path->tail); path = path->tail)
+    if (*(int*) path->head == u) return *(int*) path->tail->head == v;
+  return 0;
+}
+
+static void free_path(void *path)
+{
+  return free_List(path, pass);
+}
+
+void remove_edge_SBPlayers(struct SBPlayer *players, int n, int u, int v)
+/* Retire aux n premiers joueurs les chemins qui empruntent l'arc uv, avec
+ * leurs évaluations */
+{
+  for (int i=0; i<n; i++)
+  {
+    /* Les chemins restent entre source et sink (ordre topologique) */
+    if (u < players[i].source || v > players[i].sink) continue;
+
+    struct List *paths = players[i].paths;
+    int j = 0; /* Rang du chemin courant une fois les retraits faits */
+    for (int k=0; k<players[i].n; k++)
+    {
+      if (path_uses(paths->head, u, v))
+      {
+        drop_head(paths, free_path); /* paths voit déjà le chemin suivant */
+        support_remove(players[i].support, j);
+        continue;
+      }
+      players[i].Y_uv[j++] = players[i].Y_uv[k];
+      paths = paths->tail;
+    }
+    players[i].n = j;
+    fix_jmper(players[i].paths);
+  }
+  return ;
+}
+
 /* ******************** FONCTIONS DE JEU ******************** */
 
 double* SBPlayer_distrib(int i, struct SBPlayer *players,
@@ -106,6 +211,7 @@ double* SBPlayer_distrib(int i, struct SBPlayer *players,
 {
   double *distrib = new_distrib(players[i].n);
   balanced_logit(distrib, players[i].Y_uv, e, players[i].n);
+  support_restrict(players[i].support, distrib);
   /*printf("@@@@@@@  ");
   for (int j=0; j<players[i].n; j++) printf("%.3f (%d), ", distrib[j], j);
   printf("\n");*/
@@ -126,7 +232,8 @@ double* fast_eval_player(int i, struct SBPlayer *players, double **cost_mat)
   while (!is_empty(paths))
   {
     path = paths->head;
-    distrib[k++] = fast_path_cost(path, cost_mat);
+    if (in_support(players[i].support, k)) distrib[k] = fast_path_cost(path, cost_mat);
+    k++;
     paths = paths->tail;
   }
   return distrib;
@@ -222,6 +329,7 @@ void init_VertexPlayer(struct VertexPlayer *players, struct graph *g, int id)
   players[id].Y_uv = calloc(players[id].d, sizeof(double));
   /* Initialisation des w */
   players[id].W_uv = calloc(players[id].d, sizeof(double));
+  players[id].support = NULL;
 
   return;
 }
@@ -232,6 +340,7 @@ void free_VertexPlayer(struct VertexPlayer *players, int id)
   free(players[id].neighbours);
   free(players[id].Y_uv);
   free(players[id].W_uv);
+  free_Support(players[id].support);
   return ;
 }
 
@@ -269,6 +378,15 @@ struct VPPopulation *new_population_set(struct graph *g, int k)
   return pop;
 }
 
+double VPPopulation_size(struct graph *g, int k)
+/* Octets qu'occupera new_population_set(g, k) */
+{
+  double m = 0;
+  for (int u=0; u<g->n; u++) for (int v=0; v<g->n; v++) m += g->network[u][v];
+  return k * (sizeof(struct VPPopulation) + g->n * sizeof(struct VertexPlayer)
+              + m * (sizeof(int) + 2 * sizeof(double)));
+}
+
 void free_VPPopulation_set(struct VPPopulation *pop, int k)
 /* Libère la mémoire dédiée à k populations */
 {
@@ -301,6 +419,91 @@ void reset_VPPopulation_set(struct VPPopulation *pop, int k)
 }
 
 
+void prune_VPPopulation_set(struct VPPopulation *pop, int k, double threshold,
+                            int period)
+/* Active l'élagage des arcs de k populations */
+{
+  for (int p=0; p<k; p++)
+  for (int u=0; u<pop[p].n; u++)
+  {
+    free_Support(pop[p].players[u].support);
+    pop[p].players[u].support = new_Support(pop[p].players[u].d, threshold,
+                                            period);
+  }
+  return ;
+}
+
+void rescan_VPPopulation_set(struct VPPopulation *pop, int k)
+/* Réexamine les supports de k populations.
+ * Les Y_uv de tous les arcs sont tenus à jour : pas de rattrapage. */
+{
+  for (int p=0; p<k; p++)
+  for (int u=pop[p].source; u<pop[p].sink; u++)
+  if (pop[p].players[u].W_u != -INFINITY && pop[p].players[u].support != NULL)
+  {
+    double *distrib = new_distrib(pop[p].players[u].d);
+    pos_balanced_logit(distrib, pop[p].players[u].W_uv, 0, pop[p].players[u].d);
+    support_rescan(pop[p].players[u].support, distrib);
+    free(distrib);
+  }
+  return ;
+}
+
+int support_size_VPPopulation_set(struct VPPopulation *pop, int k)
+/* Nombre total d'arcs joués */
+{
+  int size = 0;
+  for (int p=0; p<k; p++)
+  for (int u=pop[p].source; u<pop[p].sink; u++)
+  if (pop[p].players[u].W_u != -INFINITY)
+    size += (pop[p].players[u].support == NULL) ? pop[p].players[u].d
+                                              : pop[p].players[u].support->n_active;
+  return size;
+}
+
+static int neighbour_rank(int *neighbours, int d, int v)
+/* Rang de v parmi les d voisins, -1 s'il n'y est pas */
+{
+  for (int k=0; k<d; k++) if (neighbours[k] == v) return k;
+  return -1;
+}
+
+static void remove_rank(double *t, int d, int k)
+/* Retire la case k d'un tableau de taille d */
+{
+  memmove(t + k, t + k + 1, (d - k - 1) * sizeof(double));
+  return ;
+}
+
+void remove_edge_VPPopulation_set(struct VPPopulation *pop, int k, int u, int v)
+/* Retire l'arc uv à k populations, puis refait les scores W de u et des
+ * sommets qui le précèdent (sans nouvelle mesure) */
+{
+  for (int p=0; p<k; p++)
+  {
+    struct VertexPlayer *players = pop[p].players;
+    int d = players[u].d;
+    int j = neighbour_rank(players[u].neighbours, d, v);
+    if (j < 0) continue;
+
+    memmove(players[u].neighbours + j, players[u].neighbours + j + 1,
+            (d - j - 1) * sizeof(int));
+    remove_rank(players[u].Y_uv, d, j);
+    remove_rank(players[u].W_uv, d, j);
+    support_remove(players[u].support, j);
+    players[u].d --;
+
+    /* Seuls u et ses prédécesseurs voient changer leur W (ordre
+     * topologique) ; un sommet qui n'atteint plus sink passe à -INFINITY */
+    if (u < pop[p].source || u >= pop[p].sink) continue;
+    double *zero = new_distrib(pop[p].n);
+    for (int w=u; w>=pop[p].source; w--)
+      update_eval_VertexPlayer(w, players, zero, pop[p].sink);
+    free(zero);
+  }
+  return ;
+}
+
 /* ******************** FONCTIONS USUELLES ******************** */
 
 void normalize_VPPopulation_set(struct VPPopulation *pop, int k)
@@ -345,6 +548,7 @@ double *VertexPlayer_distrib(int i, struct VertexPlayer *players, double e)
 {
   double *distrib = new_distrib(players[i].d);
   pos_balanced_logit(distrib, players[i].W_uv, e, players[i].d); /* NEW : POS */
+  support_restrict(players[i].support, distrib);
   /*printf("@@@@@@(%d) : ", i);
   for (int j=0; j<players[i].d; j++)
   printf("%.3f(%d)[%g]{%g} ", distrib[j], players[i].neighbours[j],
@@ -412,7 +616,7 @@ double **mass_spread(int p, struct VPPopulation *pop, double e)
 
   /* La masse passant en un nœud i est la somme mass[.<i][i] */
   for (int u=pop[p].source; u<pop[p].sink; u++)
-  if (pop[p].players[u].W_u != -INFINITY)
+  if (pop[p].players[u].W_u != -INFINITY && local_mass[u] != 0)
   {
     double *distrib = VertexPlayer_distrib(u, pop[p].players, e); /* distribution */
     /*if (i == pop[p].source)
@@ -426,6 +630,7 @@ double **mass_spread(int p, struct VPPopulation *pop, double e)
 
     /* Propagation de la masse */
     for (int k=0; k<pop[p].players[u].d; k++)
+    if (in_support(pop[p].players[u].support, k))
     {
       int v = pop[p].players[u].neighbours[k];
       mass[u][v] = local_mass[u] * distrib[k];
@@ -456,6 +661,7 @@ void init_VertexBandit(struct VertexBandit *bandits, struct graph *g, int u)
   bandits[u].noise = calloc(d, sizeof(double));
   bandits[u].costs = calloc(d, sizeof(double));
   bandits[u].noisy_costs = calloc(d, sizeof(double));
+  bandits[u].support = NULL;
 
   if (bandits[u].neighbours == NULL || bandits[u].Y_uv  == NULL
       || bandits[u].W_uv    == NULL || bandits[u].noise == NULL
@@ -480,6 +686,7 @@ void free_VertexBandit(struct VertexBandit *bandits, int u)
   free(bandits[u].W_uv);
   free(bandits[u].noise);
   free(bandits[u].costs);
+  free_Support(bandits[u].support);
   return free(bandits[u].noisy_costs);
 }
 
@@ -546,6 +753,7 @@ struct VBPopulation *VBPopulation_from_VPPopulation(struct VPPopulation *pop, in
       pop_bandits[p].bandits[u].noise = calloc(d, sizeof(double));
       pop_bandits[p].bandits[u].costs = calloc(d, sizeof(double));
       pop_bandits[p].bandits[u].noisy_costs = calloc(d, sizeof(double));
+      pop_bandits[p].bandits[u].support = NULL;
     }
   }
 
@@ -593,6 +801,90 @@ void reset_VBPopulation_set(struct VBPopulation *pop, int k)
   return ;
 }
 
+void prune_VBPopulation_set(struct VBPopulation *pop, int k, double threshold,
+                            int period)
+/* Active l'élagage des arcs de k populations */
+{
+  for (int p=0; p<k; p++)
+  for (int u=0; u<pop[p].n; u++)
+  {
+    free_Support(pop[p].bandits[u].support);
+    pop[p].bandits[u].support = new_Support(pop[p].bandits[u].d, threshold,
+                                            period);
+  }
+  return ;
+}
+
+void rescan_VBPopulation_set(struct VBPopulation *pop, int k)
+/* Réexamine les supports de k populations */
+{
+  for (int p=0; p<k; p++)
+  for (int u=pop[p].source; u<pop[p].sink; u++)
+  if (pop[p].bandits[u].W_u != -INFINITY && pop[p].bandits[u].support != NULL)
+  {
+    double *distrib = new_distrib(pop[p].bandits[u].d);
+    pos_balanced_logit(distrib, pop[p].bandits[u].W_uv, 0, pop[p].bandits[u].d);
+    support_rescan(pop[p].bandits[u].support, distrib);
+    free(distrib);
+  }
+  return ;
+}
+
+int support_size_VBPopulation_set(struct VBPopulation *pop, int k)
+/* Nombre total d'arcs joués */
+{
+  int size = 0;
+  for (int p=0; p<k; p++)
+  for (int u=pop[p].source; u<pop[p].sink; u++)
+  if (pop[p].bandits[u].W_u != -INFINITY)
+    size += (pop[p].bandits[u].support == NULL) ? pop[p].bandits[u].d
+                                              : pop[p].bandits[u].support->n_active;
+  return size;
+}
+
+static void update_W_VertexBandit(struct VertexBandit *bandits, int u)
+/* W_uv = W_v - Y_uv, puis W_u, sans nouvelle mesure (comme dans
+ * bandit_update_scores) */
+{
+  int d = bandits[u].d;
+  for (int i=0; i<d; i++)
+    bandits[u].W_uv[i] = bandits[bandits[u].neighbours[i]].W_u - bandits[u].Y_uv[i];
+
+  double W_max = (d) ? max(bandits[u].W_uv, d) : -INFINITY;
+  if (W_max == -INFINITY) { bandits[u].W_u = -INFINITY; return ; }
+
+  bandits[u].W_u = 0;
+  for (int i=0; i<d; i++) bandits[u].W_u += exp(bandits[u].W_uv[i] - W_max);
+  bandits[u].W_u = W_max + log(bandits[u].W_u);
+  return ;
+}
+
+void remove_edge_VBPopulation_set(struct VBPopulation *pop, int k, int u, int v)
+/* Idem remove_edge_VPPopulation_set */
+{
+  for (int p=0; p<k; p++)
+  {
+    struct VertexBandit *bandits = pop[p].bandits;
+    int d = bandits[u].d;
+    int j = neighbour_rank(bandits[u].neighbours, d, v);
+    if (j < 0) continue;
+
+    memmove(bandits[u].neighbours + j, bandits[u].neighbours + j + 1,
+            (d - j - 1) * sizeof(int));
+    remove_rank(bandits[u].Y_uv, d, j);
+    remove_rank(bandits[u].W_uv, d, j);
+    remove_rank(bandits[u].noise, d, j);
+    remove_rank(bandits[u].costs, d, j);
+    remove_rank(bandits[u].noisy_costs, d, j);
+    support_remove(bandits[u].support, j);
+    bandits[u].d --;
+
+    if (u < pop[p].source || u >= pop[p].sink) continue;
+    for (int w=u; w>=pop[p].source; w--) update_W_VertexBandit(bandits, w);
+  }
+  return ;
+}
+
 /* #################### FONCTIONS USUELLES #################### */
 
 void normalize_VBPopulation_set(struct VBPopulation *pop, int k)
@@ -641,6 +933,7 @@ double *VertexBandit_distrib(int u, struct VertexBandit *bandits, double e,
     for (int i=0; i<bandits[u].d; i++) distrib[i] += e * noise[i];
     free(noise);
   }
+  support_restrict(bandits[u].support, distrib);
 
   return distrib;
 }
@@ -662,13 +955,14 @@ double **bandit_mass_spread(int p, struct VBPopulation *pop, double e, int noise
 
   /* La masse passant en un nœud i est la somme mass[.<i][i] */
   for (int u=pop[p].source; u<pop[p].sink; u++)
-  if (pop[p].bandits[u].W_u != -INFINITY)
+  if (pop[p].bandits[u].W_u != -INFINITY && local_mass[u] != 0)
   {
     /* On calcule la distribution, puis la masse locale */
     double *distrib = VertexBandit_distrib(u, pop[p].bandits, e, noise);
 
     /* Propagation de la masse */
     for (int k=0; k<pop[p].bandits[u].d; k++)
+    if (in_support(pop[p].bandits[u].support, k))
     {
       int v = pop[p].bandits[u].neighbours[k];
       mass[u][v] = local_mass[u] * distrib[k];
@@ -7,6 +7,7 @@
 #include "graph.h"
 #include "network_th.h"
 #include "distrib.h"
+#include "support.h"
 
 #define NO_NOISE 0
 #define WITH_NOISE 1
@@ -21,6 +22,7 @@ struct SBPlayer
   struct List *paths;  /* Liste des chemins possibles source --> sink */
   double *Y_uv; /* Liste des évaluations des chemins (Y_i) */
   int n;               /* Nombre d'actions */
+  struct Support *support; /* Chemins joués (NULL : pas d'élagage) */
 };
 
 /* ************* FONCTIONS ADMINISTRATIVES ************* */
@@ -37,16 +39,33 @@ void init_SBPlayers(struct SBPlayer *players, struct graph *g, int n,
 void set_SBPlayer(int i, struct SBPlayer *players, int source, int sink,
                   double mass, struct graph *g, int **vertices);
 /* Initialise le joueur 'i' à (source, sink, mass) */
+void set_SBPlayer_paths(int i, struct SBPlayer *players, int source, int sink,
+                        double mass, struct List *paths);
+/* Idem, avec des chemins déjà calculés, qui restent à l'appelant */
 
 void normalize_SBPlayers(struct SBPlayer *players, int n);
 /* Normalise les masses des n premiers joueurs de SBP */
 
 void free_SBPlayers(struct SBPlayer *players, int n);
 /* Libère les n premiers joueurs de players, et libère le pointeur 'players' */
+void release_SBPlayers(struct SBPlayer *players, int n);
+/* Idem, sans libérer les chemins (set_SBPlayer_paths) */
 
 void reset_SBPlayers(struct SBPlayer *players, int n);
 /* Remet les évaluation des n premiers joueurs à 0 */
 
+void prune_SBPlayers(struct SBPlayer *players, int n, double threshold,
+                     int period);
+/* Active l'élagage des chemins des n premiers joueurs */
+void rescan_SBPlayers(struct SBPlayer *players, int n, double **cost_mat);
+/* Rattrape les évaluations des chemins hors support (coûts de cost_mat sur
+ * les pas accumulés) et réexamine les supports */
+int support_size_SBPlayers(struct SBPlayer *players, int n);
+/* Nombre total de chemins joués */
+void remove_edge_SBPlayers(struct SBPlayer *players, int n, int u, int v);
+/* Retire aux n premiers joueurs les chemins qui empruntent l'arc uv, avec
+ * leurs évaluations. Les autres chemins gardent les leurs. */
+
 /* ******************** FONCTIONS DE JEU ******************** */
 
 double* SBPlayer_distrib(int i, struct SBPlayer *players,
@@ -59,7 +78,7 @@ double* fast_eval_player(int i, struct SBPlayer *players, double **cost_mat);
 /* Renvoie la matrice des coûts du joueur i, en fonction de la matrice des
  * coûts en paramètre. Si celle-si est la matrice des coûts purs, alors
  * on a le cas bandit ; si c'est la matrice des coûts modifiés, alors on a
- * le cas semi-bandit. */
+ * le cas semi-bandit. Les chemins hors support ont un coût nul. */
 
 double **paths_mass_spread(int p, struct SBPlayer *players, int n);
 /* Renvoie la matrice des masses du joueur 'p'.
@@ -87,6 +106,7 @@ struct VertexPlayer /* One - One Player */
   double *Y_uv; /* Tableau des évaluations sur les possibilités */
   double *W_uv; /* Tableau des w sur les arêtes */
   double W_u;    /* Son propre score (w_v) */
+  struct Support *support; /* Arcs joués (NULL : pas d'élagage) */
 };
 
 struct VPPopulation /* Vertex - Players Population */
@@ -108,12 +128,25 @@ void free_VertexPlayer(struct VertexPlayer *players, int id);
 
 struct VPPopulation *new_population_set(struct graph *g, int k);
 /* Renvoie un tableau de k nouvelles populations en adéquation avec le graphe G */
+double VPPopulation_size(struct graph *g, int k);
+/* Octets qu'occupera new_population_set(g, k) */
 void free_VPPopulation_set(struct VPPopulation *pop, int k);
 /* Libère la mémoire dédiée à k populations */
 
 void reset_VPPopulation_set(struct VPPopulation *pop, int k);
 /* Remet à 0 les évaluation d'un ensemble de populations */
 
+void prune_VPPopulation_set(struct VPPopulation *pop, int k, double threshold,
+                            int period);
+/* Active l'élagage des arcs de k populations */
+void rescan_VPPopulation_set(struct VPPopulation *pop, int k);
+/* Réexamine les supports de k populations */
+int support_size_VPPopulation_set(struct VPPopulation *pop, int k);
+/* Nombre total d'arcs joués */
+void remove_edge_VPPopulation_set(struct VPPopulation *pop, int k, int u, int v);
+/* Retire l'arc uv à k populations, puis refait les scores W de u et des
+ * sommets qui le précèdent (sans nouvelle mesure) */
+
 /* ******************** FONCTIONS USUELLES ******************** */
 
 void normalize_VPPopulation_set(struct VPPopulation *pop, int k);
@@ -158,6 +191,8 @@ struct VertexBandit /* One - One Player */
   double *noise; /* les z_uv */
   double *costs;
   double *noisy_costs; /* c'est \sum z_uv c(x_uv + delta.z_uv) */
+
+  struct Support *support; /* Arcs joués (NULL : pas d'élagage) */
 };
 
 struct VBPopulation /* Vertex - Bandits Population */
@@ -193,6 +228,16 @@ void partial_free_VBPopulation_set(struct VBPopulation *pop, int k);
 void reset_VBPopulation_set(struct VBPopulation *pop, int k);
 /* Remet à 0 les évaluations d'un ensemble de populations */
 
+void prune_VBPopulation_set(struct VBPopulation *pop, int k, double threshold,
+                            int period);
+/* Active l'élagage des arcs de k populations */
+void rescan_VBPopulation_set(struct VBPopulation *pop, int k);
+/* Réexamine les supports de k populations */
+int support_size_VBPopulation_set(struct VBPopulation *pop, int k);
+/* Nombre total d'arcs joués */
+void remove_edge_VBPopulation_set(struct VBPopulation *pop, int k, int u, int v);
+/* Idem remove_edge_VPPopulation_set */
+
 /* #################### FONCTIONS USUELLES #################### */
 
 void normalize_VBPopulation_set(struct VBPopulation *pop, int k);
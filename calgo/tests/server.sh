@@ -0,0 +1,93 @@
+#!/bin/bash
+# Test d'intégration du mode serveur (toto --serve) : deux clients
+# concurrents sur deux sessions avec un seul worker, puis remplissage de la
+# table des sessions, puis arrêt. Écrit ce qui échoue sur stderr ; code de
+# sortie non nul en cas d'échec.
+#
+# Usage : tests/server.sh [toto [toto-client]]
+
+TOTO=${1:-./toto}
+CLIENT=${2:-./toto-client}
+SESSIONS=$(awk '$2 == "SERVER_SESSIONS" { print $3 }' "$(dirname "$0")/../src/server.h")
+
+TMP=$(mktemp -d)
+SOCK="$TMP/sock"
+SERVER=
+trap '[ -n "$SERVER" ] && kill $SERVER 2> /dev/null; rm -rf "$TMP"' EXIT
+
+failures=0
+fail()
+{
+  echo "FAIL : $*" >&2
+  failures=$((failures + 1))
+}
+
+statuses()
+# Codes de retour des lignes finales d'une sortie JSON, un par ligne
+{
+  sed -n 's/.*"status":\(-\{0,1\}[0-9]*\).*/\1/p' "$1"
+}
+
+"$TOTO" --serve "$SOCK" --workers 1 2> "$TMP/server.log" &
+SERVER=$!
+for i in $(seq 50); do [ -S "$SOCK" ] && break; sleep 0.1; done
+[ -S "$SOCK" ] || { cat "$TMP/server.log" >&2; fail "no socket"; exit 1; }
+
+# Deux sessions en même temps : avec un seul worker, la seconde attend la
+# première au lieu d'être refusée
+for s in a b
+do
+  cat > "$TMP/$s.cmd" <<EOF
+set seed 1
+mode vertex
+new graph 12 0.4
+new players 8
+set mass 2
+new network
+set network poly3
+run vertex for 300
+print graph
+EOF
+  "$CLIENT" "$SOCK" -s $s -j < "$TMP/$s.cmd" > "$TMP/$s.out" &
+  eval "pid_$s=$!"
+done
+wait $pid_a || fail "client a failed"
+wait $pid_b || fail "client b failed"
+
+for s in a b
+do
+  expected=$(( $(grep -c . "$TMP/$s.cmd") + 1 )) # session, puis les commandes
+  [ "$(statuses "$TMP/$s.out" | grep -c '^0$')" = $expected ] \
+    || fail "session $s : expected $expected zero statuses, got: $(statuses "$TMP/$s.out" | tr '\n' ' ')"
+  grep -q "\"session\":\"$s\"" "$TMP/$s.out" || fail "session $s : wrong session name"
+  grep -q '"stream":"stdout"' "$TMP/$s.out" || fail "session $s : no output streamed"
+done
+
+# Table des sessions pleine : a et b comptent ; la suivante est refusée
+for i in $(seq $((SESSIONS - 1)))
+do
+  echo "session s$i"
+  echo "//"
+done > "$TMP/fill.cmd"
+"$CLIENT" "$SOCK" -j < "$TMP/fill.cmd" > "$TMP/fill.out" \
+  && fail "no session was refused"
+refused=$(grep -c '"status":-1,"error":"cannot start session"' "$TMP/fill.out")
+[ "$refused" = 1 ] || fail "expected 1 refused session, got $refused"
+
+# Une session fermée libère sa place
+printf 'close a\nsession again\n//\n' | "$CLIENT" "$SOCK" -j > "$TMP/again.out" \
+  || fail "session not accepted after close: $(cat "$TMP/again.out")"
+
+# Arrêt : le serveur répond, termine ses sessions et retire la socket
+echo shutdown | "$CLIENT" "$SOCK" -j > "$TMP/shutdown.out" \
+  || fail "shutdown failed"
+wait $SERVER || fail "server exit status $?"
+SERVER=
+[ -e "$SOCK" ] && fail "socket left behind"
+
+if [ $failures -gt 0 ]
+then
+  echo "server log :" >&2; cat "$TMP/server.log" >&2
+  exit 1
+fi
+echo "tests/server.sh : OK"
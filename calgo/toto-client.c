@@ -0,0 +1,121 @@
+/* Client du mode serveur (toto --serve socket). Envoie les commandes lues
+ * sur stdin, une par ligne, et attend la fin de chacune avant la suivante.
+ * Les sorties de la session sont recopiées sur stdout et stderr, les
+ * erreurs du serveur sur stderr ; avec -j, les réponses JSON sont écrites
+ * telles quelles sur stdout. Avec -s nom, les commandes vont à la session
+ * 'nom' au lieu de "default".
+ * Renvoie 1 si une commande a échoué côté serveur (code -1), 0 sinon. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static void usage(const char *name)
+{
+  fprintf(stderr, "Usage : %s socket [-s session] [-j]\n", name);
+  exit(EXIT_FAILURE);
+}
+
+static void print_string(FILE *f, const char *s)
+/* Décode la chaîne JSON qui commence à s (après le guillemet ouvrant) */
+{
+  for (; *s && *s != '"'; s++)
+  {
+    if (*s != '\\') { putc(*s, f); continue; }
+    switch (*++s)
+    {
+      case 'n': putc('\n', f); break;
+      case 't': putc('\t', f); break;
+      case 'u': { unsigned int c;
+                  if (sscanf(s + 1, "%4x", &c) == 1) putc(c, f);
+                  s += 4; break; }
+      case '\0': return ;
+      default: putc(*s, f);
+    }
+  }
+  return ;
+}
+
+static int reply(const char *line, int json)
+/* Traite une ligne de réponse ; renvoie 1 si c'est la dernière de la
+ * commande, 2 si celle-ci a échoué, 0 sinon */
+{
+  if (json) fputs(line, stdout);
+  const char *p;
+  if (!json && (p = strstr(line, "\"data\":\"")) != NULL)
+  {
+    FILE *f = (strstr(line, "\"stream\":\"stderr\"") != NULL) ? stderr : stdout;
+    print_string(f, p + 8);
+    fflush(f);
+  }
+  if (!json && (p = strstr(line, "\"error\":\"")) != NULL)
+  {
+    fprintf(stderr, "Server error : ");
+    print_string(stderr, p + 9);
+    fprintf(stderr, "\n");
+  }
+  if (strstr(line, "\"status\":-1") != NULL) return 2;
+  return (strstr(line, "\"status\":") != NULL);
+}
+
+static int command(FILE *sock, const char *cmd, int json)
+/* Envoie cmd et lit ses réponses ; renvoie -1 si le serveur est parti,
+ * 1 si la commande a échoué, 0 sinon */
+{
+  fprintf(sock, "%s\n", cmd);
+  fflush(sock);
+
+  char *line = NULL;
+  size_t size = 0;
+  int done = 0;
+  while (!done && getline(&line, &size, sock) > 0) done = reply(line, json);
+  free(line);
+  return (done) ? done - 1 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+  const char *session = NULL;
+  int json = 0;
+  if (argc < 2) usage(argv[0]);
+  for (int i=2; i<argc; i++)
+  {
+    if (!strcmp(argv[i], "-s") && i + 1 < argc) session = argv[++i];
+    else if (!strcmp(argv[i], "-j")) json = 1;
+    else usage(argv[0]);
+  }
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, argv[1], sizeof(addr.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, (struct sockaddr*) &addr, sizeof(addr)))
+  { perror(argv[1]); return EXIT_FAILURE; }
+  FILE *sock = fdopen(fd, "r+");
+  if (sock == NULL) { perror("fdopen"); return EXIT_FAILURE; }
+
+  char cmd[1024 + 16];
+  int failed = 0, ret = 0;
+  if (session != NULL)
+  {
+    snprintf(cmd, sizeof(cmd), "session %s", session);
+    ret = command(sock, cmd, json);
+    failed |= (ret != 0);
+  }
+
+  while (ret >= 0 && fgets(cmd, sizeof(cmd), stdin) != NULL)
+  {
+    cmd[strcspn(cmd, "\r\n")] = '\0';
+    if (cmd[strspn(cmd, " \t")] == '\0') continue; /* Pas de réponse */
+    if ((ret = command(sock, cmd, json)) > 0) failed = 1;
+    if (!strcmp(cmd, "quit") || !strcmp(cmd, "q")) break;
+  }
+  if (ret < 0) fprintf(stderr, "Connection closed by the server\n");
+
+  fclose(sock);
+  return (failed || ret < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
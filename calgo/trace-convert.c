@@ -0,0 +1,53 @@
+/* Convertit une trace binaire de la simulation (set trace binary) en texte.
+ * Lit la trace sur stdin. Les simulations successives sont écrites dans les
+ * fichiers donnés en argument, dans l'ordre (les suivantes sont ignorées) ;
+ * sans fichier, tout va sur stdout, chaque simulation étant précédée d'une
+ * ligne "#".
+ * Par défaut une ligne "temps latence" par paquet, comme l'ancienne sortie
+ * sur stderr ; avec -a : "temps latence source destination sauts issue"
+ * (issue : 0 arrivé, 1 perdu). */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/trace.h"
+
+#define BLOCK 4096
+
+int main(int argc, char *argv[])
+{
+  int all = 0, first = 1;
+  if (argc > 1 && !strcmp(argv[1], "-a")) { all = 1; first = 2; }
+  int file_count = argc - first;
+
+  struct TraceRecord *records = malloc(BLOCK * sizeof(struct TraceRecord));
+  if (records == NULL) return -1;
+
+  FILE *out = (file_count) ? NULL : stdout;
+  int run = 0;
+  size_t n_read;
+  while ((n_read = fread(records, sizeof(struct TraceRecord), BLOCK, stdin)))
+  for (size_t i=0; i<n_read; i++)
+  {
+    struct TraceRecord r = records[i];
+    if (r.outcome == TRACE_RUN)
+    {
+      if (!file_count) { printf("#\n"); continue; }
+      if (out != NULL) fclose(out);
+      out = NULL;
+      if (run < file_count && (out = fopen(argv[first + run], "w")) == NULL)
+      { perror(argv[first + run]); return -1; }
+      run++;
+      continue;
+    }
+    if (out == NULL) continue;
+
+    if (all) fprintf(out, "%lf %lf %d %d %d %d\n", r.T, r.latency, r.source,
+                     r.sink, r.hops, r.outcome);
+    else fprintf(out, "%lf %lf\n", r.T, r.latency);
+  }
+
+  if (out != NULL && out != stdout) fclose(out);
+  free(records);
+  return 0;
+}